@@ -0,0 +1,188 @@
+/******************************************************************************
+** File:	Accum.cpp
+**
+** Notes:	Carry-save accumulator: a value held as words & the carries out
+**			of them, added a block at a time with AVX-512, AVX2 or neither,
+**			whichever the CPU & Windows support, & normalised on demand.
+*/
+
+#include "stdafx.h"
+
+#include "Accum.h"
+#include "Trace.h"
+
+int ACCUM_simd = -1;
+
+/******************************************************************************
+** Function:	Best instruction set the CPU has & the OS saves the state of
+**
+** Notes:		Returns ACCUM_xxx
+*/
+int accum_detect(void)
+{
+	int info[4];
+
+	__cpuidex(info, 0, 0);
+	if (info[0] < 7)
+		return ACCUM_SCALAR;
+
+	// AVX, & XSAVE enabled by the OS for the YMM registers:
+	__cpuidex(info, 1, 0);
+	if ((info[2] & (3 << 27)) != (3 << 27))
+		return ACCUM_SCALAR;
+
+	uint64 xcr0 = _xgetbv(0);
+	if ((xcr0 & 0x06UI64) != 0x06UI64)
+		return ACCUM_SCALAR;
+
+	__cpuidex(info, 7, 0);
+	if (((info[1] & (1 << 16)) != 0) && ((xcr0 & 0xE6UI64) == 0xE6UI64))	// AVX-512F, & ZMM state
+		return ACCUM_AVX512;
+	if ((info[1] & (1 << 5)) != 0)
+		return ACCUM_AVX2;
+
+	return ACCUM_SCALAR;
+}
+
+/******************************************************************************
+** Function:	Instruction set to use, ACCUM_xxx
+**
+** Notes:		Also for other kernels with AVX-512 or AVX2 versions
+*/
+int ACCUM_level(void)
+{
+	if (ACCUM_simd < 0)
+		ACCUM_simd = accum_detect();
+
+	return ACCUM_simd;
+}
+
+/******************************************************************************
+** Function:	Accumulate into words, which hold the starting value
+**
+** Notes:		carries has length_words entries, & is cleared
+*/
+void ACCUM_init(ACCUM_type* a, uint64* words, int64* carries, int length_words)
+{
+	ACCUM_level();
+
+	a->words = words;
+	a->carries = carries;
+	a->length_words = length_words;
+	a->block_start = ACCUM_BLOCK_WORDS;
+	a->block_word = 0;
+	memset(carries, 0, length_words * sizeof(int64));
+}
+
+/******************************************************************************
+** Function:	Add n words of lo & hi into words & carries, from word i
+**
+** Notes:		One word at a time, for any CPU & for the words left over
+*/
+void accum_add_scalar(ACCUM_type* a, int i, const uint64* lo, const int64* hi, int n)
+{
+	for (int k = 0; k < n; k++)
+	{
+		uint8 c = _addcarry_u64(0, a->words[i + k], lo[k], &a->words[i + k]);
+		a->carries[i + k] += hi[k] + c;
+	}
+}
+
+/******************************************************************************
+** Function:	As accum_add_scalar, 4 words at a time with AVX2
+**
+** Notes:		There's no unsigned compare, so the carry out of each sum is
+**				found by a signed compare with the top bits flipped.
+*/
+void accum_add_avx2(ACCUM_type* a, int i, const uint64* lo, const int64* hi, int n)
+{
+	const __m256i top_bit = _mm256_set1_epi64x((int64)(1UI64 << 63));
+	int k;
+
+	for (k = 0; k + 4 <= n; k += 4)
+	{
+		__m256i x = _mm256_loadu_si256((const __m256i*)&lo[k]);
+		__m256i s = _mm256_add_epi64(_mm256_loadu_si256((const __m256i*)&a->words[i + k]), x);
+		__m256i c = _mm256_cmpgt_epi64(_mm256_xor_si256(x, top_bit), _mm256_xor_si256(s, top_bit));	// -1 where s < x
+		__m256i h = _mm256_add_epi64(_mm256_loadu_si256((const __m256i*)&a->carries[i + k]),
+			_mm256_loadu_si256((const __m256i*)&hi[k]));
+
+		_mm256_storeu_si256((__m256i*)&a->words[i + k], s);
+		_mm256_storeu_si256((__m256i*)&a->carries[i + k], _mm256_sub_epi64(h, c));
+	}
+
+	accum_add_scalar(a, i + k, &lo[k], &hi[k], n - k);
+}
+
+/******************************************************************************
+** Function:	As accum_add_scalar, 8 words at a time with AVX-512
+**
+** Notes:
+*/
+void accum_add_avx512(ACCUM_type* a, int i, const uint64* lo, const int64* hi, int n)
+{
+	const __m512i one = _mm512_set1_epi64(1);
+	int k;
+
+	for (k = 0; k + 8 <= n; k += 8)
+	{
+		__m512i x = _mm512_loadu_si512(&lo[k]);
+		__m512i s = _mm512_add_epi64(_mm512_loadu_si512(&a->words[i + k]), x);
+		__mmask8 c = _mm512_cmplt_epu64_mask(s, x);
+		__m512i h = _mm512_add_epi64(_mm512_loadu_si512(&a->carries[i + k]), _mm512_loadu_si512(&hi[k]));
+
+		_mm512_storeu_si512(&a->words[i + k], s);
+		_mm512_storeu_si512(&a->carries[i + k], _mm512_mask_add_epi64(h, c, h, one));
+	}
+
+	accum_add_scalar(a, i + k, &lo[k], &hi[k], n - k);
+}
+
+/******************************************************************************
+** Function:	Add the words put since the last flush
+**
+** Notes:
+*/
+void ACCUM_flush(ACCUM_type* a)
+{
+	int k = a->block_start;
+	int n = ACCUM_BLOCK_WORDS - k;
+
+	if (n == 0)
+		return;
+
+	TRACE_COUNT(TRACE_COUNTER_LIMBS, n);
+	if (ACCUM_simd == ACCUM_AVX512)
+		accum_add_avx512(a, a->block_word, &a->block_lo[k], &a->block_hi[k], n);
+	else if (ACCUM_simd == ACCUM_AVX2)
+		accum_add_avx2(a, a->block_word, &a->block_lo[k], &a->block_hi[k], n);
+	else
+		accum_add_scalar(a, a->block_word, &a->block_lo[k], &a->block_hi[k], n);
+
+	a->block_start = ACCUM_BLOCK_WORDS;
+}
+
+/******************************************************************************
+** Function:	Flush, then propagate the carries, so words holds the value
+**
+** Notes:		One pass, LS word first. Carries out of the top word are
+**				lost, as with add_u64 & sub_u64. The carries are left clear,
+**				so accumulating can go on.
+*/
+void ACCUM_normalise(ACCUM_type* a)
+{
+	int64 carry = 0;
+
+	ACCUM_flush(a);
+	for (int i = 0; i < a->length_words; i++)
+	{
+		// Add the signed carry in, & pass on what comes out of the word with its own:
+		uint64 w = a->words[i];
+		uint64 x = w + (uint64)carry;
+		int64 out = (carry >= 0) ? (int64)(x < w) : -(int64)(x > w);
+
+		a->words[i] = x;
+		carry = a->carries[i] + out;
+		a->carries[i] = 0;
+	}
+}
@@ -0,0 +1,53 @@
+/******************************************************************************
+** File:	Accum.h
+**
+** Notes:	Carry-save accumulator for the series behind e & pi. Beside each
+**			word of the value is a signed count of carries still to go into
+**			the word above, so words are added without a carry chain: they
+**			are buffered a block at a time & added 8 or 4 to an instruction
+**			with AVX-512 or AVX2 where the CPU has them, or one at a time.
+**			The carries are only propagated when the value is to be read.
+*/
+
+#define ACCUM_BLOCK_WORDS		64			// words buffered before they're added in
+
+// Instruction sets, best last:
+#define ACCUM_SCALAR			0
+#define ACCUM_AVX2				1
+#define ACCUM_AVX512			2
+
+struct ACCUM_type
+{
+	uint64* words;							// the value, LS word first
+	int64* carries;							// carries[i] are still to be added to words[i + 1]
+	int length_words;
+
+	int block_start;						// block_lo & block_hi hold words block_word onwards
+	int block_word;							// from block_start up; empty at ACCUM_BLOCK_WORDS
+	uint64 block_lo[ACCUM_BLOCK_WORDS];
+	int64 block_hi[ACCUM_BLOCK_WORDS];		// signed words above each, i.e. carries
+};
+
+extern int ACCUM_simd;						// ACCUM_xxx used, or -1 before the first ACCUM_init
+
+int ACCUM_level(void);
+void ACCUM_init(ACCUM_type* a, uint64* words, int64* carries, int length_words);
+void ACCUM_flush(ACCUM_type* a);
+void ACCUM_normalise(ACCUM_type* a);
+
+/******************************************************************************
+** Function:	words[i] += lo + hi 2^64
+**
+** Notes:		Words are put MS first, each one below the last, from any
+**				word after a flush; they are only added in by ACCUM_flush.
+*/
+inline void ACCUM_put(ACCUM_type* a, int i, uint64 lo, int64 hi)
+{
+	int k = --a->block_start;
+
+	a->block_lo[k] = lo;
+	a->block_hi[k] = hi;
+	a->block_word = i;
+	if (k == 0)
+		ACCUM_flush(a);
+}
@@ -1,423 +1,851 @@
-/******************************************************************************
-** File:	Alu.cpp
-**
-** Notes:	Very long data word ALU functions		
-*/
-
-#include "stdafx.h"
-#include "Alu.h"
-
-ALU_type ALU;
-
-/******************************************************************************
-** Function:	Set all bytes of register to value
-**
-** Notes:
-*/
-void ALU_type::set(ALU_reg dest, uint8 byte_value)
-{
-	memset(dest, byte_value, ALU_LENGTH_BYTES);
-}
-
-/******************************************************************************
-** Function:	Copy one register to another
-**
-** Notes:
-*/
-void ALU_type::mov(ALU_reg dest, ALU_reg src)
-{
-	memcpy(dest, src, ALU_LENGTH_BYTES);
-}
-
-/******************************************************************************
-** Function:	Shift register right (+ve) or left (-ve), putting result in dest
-**
-** Notes:		Shift count is in 64-bit words, not bits. Src register unaffected
-*/
-void ALU_type::shr(ALU_reg dest, ALU_reg src, int word_count)
-{
-	set(dest, 0x00);
-	if (word_count >= 0)
-		memcpy(&dest[word_count], src, ALU_LENGTH_BYTES - (word_count * sizeof(uint64)));
-	else
-		memcpy(dest, &src[-word_count], ALU_LENGTH_BYTES + (word_count * sizeof(uint64)));
-}
-
-/******************************************************************************
-** Function:	Add with carry
-**
-** Notes:
-*/
-uint8 ALU_type::adc(ALU_reg dest, ALU_reg src, int length_words)
-{
-	uint8 c = 0;
-	for (int i = length_words - 1; i >= 0; i--)
-		c = _addcarry_u64(c, src[i], dest[i], &dest[i]);
-
-	return c;
-}
-
-/******************************************************************************
-** Function:	Compare registers
-**
-** Notes:		Returns true if a >= b, else false
-*/
-bool ALU_type::greater_or_equal(ALU_reg a, ALU_reg b)
-{
-	for (int i = 0; i < ALU_LENGTH_U64; i++)
-	{
-		if (a[i] > b[i])
-			return true;
-
-		if (a[i] < b[i])
-			return false;
-	}
-
-	return true;
-}
-
-/******************************************************************************
-** Function:	dest -= src
-**
-** Notes:
-*/
-uint8 ALU_type::sub(ALU_reg dest, ALU_reg src, int length_words)
-{
-	uint8 b = 0;
-	for (int i = length_words - 1; i >= 0; i--)
-		b = _subborrow_u64(b, dest[i], src[i], &dest[i]);
-
-	return b;
-}
-
-/******************************************************************************
-** Function:	Add U64 value v into register pair at index i
-**
-** Notes:		Propagates carry up the register (or pair) as required
-*/
-void ALU_type::add_u64(ALU_reg dest, int i, uint64 v)
-{
-	uint8 c = _addcarry_u64(0, v, dest[i], &dest[i]);
-
-	while ((c != 0) && (--i >= 0))
-		c = _addcarry_u64(c, 0UI64, dest[i], &dest[i]);
-}
-
-/******************************************************************************
-** Function:	Multiply register by a uint64 & return carry
-**
-** Notes:
-*/
-uint64 ALU_type::mul_u64(ALU_reg r, uint64 v, int length_words)
-{
-	uint64 carry;
-	uint64 c2;
-	int i = length_words - 1;
-	r[i] = _umul128(r[i], v, &carry);
-
-	while (--i >= 0)
-	{
-		r[i] = _umul128(r[i], v, &c2);
-		add_u64(r, i, carry);
-		carry = c2;
-	}
-
-	return carry;
-}
-
-/******************************************************************************
-** Function:
-**
-** Notes:
-*/
-void ALU_type::mul(ALU_reg_pair dest, ALU_reg x, ALU_reg y)
-{
-	uint64 high64;
-
-	memset(dest, 0, sizeof(ALU_reg_pair));
-
-	// For each U64 of multiplier:
-	for (int i = ALU_LENGTH_U64 - 1; i >= 0; i--)
-	{
-		int k = ALU_LENGTH_U64 + i;						// index into result
-
-		// for each byte of multiplicand:
-		for (int j = ALU_LENGTH_U64 - 1; j >= 0; j--)
-		{
-			uint64 low64 = _umul128(x[i], y[j], &high64);
-			add_u64(dest, k--, low64);					// note result index decremented
-			add_u64(dest, k, high64);
-		}
-	}
-}
-
-/******************************************************************************
-** Function:	Divide register by a uint64 & set remainder
-**
-** Notes:		Returns true when result is zero
-*/
-bool ALU_type::div_u64(ALU_reg n, uint64 d, int length_words, uint64* p_remainder)
-{
-	*p_remainder = 0UI64;
-	bool z = true;								// assume result is 0
-
-	if (d == 0UI64)								// trap divide by zero
-	{
-		memset(n, 0xFF, length_words * sizeof(uint64));
-		return false;
-	}
-	// else:
-
-	for (int i = 0; i < length_words; i++)
-	{
-		n[i] = _udiv128(*p_remainder, n[i], d, p_remainder);
-		if ((n[i] | *p_remainder) != 0UI64)
-			z = false;
-	}
-
-	return z;
-}
-
-/******************************************************************************
-** Function:	Divide n by d
-**
-** Notes:
-** Q := 0                  -- Initialize quotient and remainder to zero
-** R := 0                     
-** for i := n - 1 .. 0 do  -- Where n is number of bits in N
-**   R := R << 1           -- Left-shift R by 1 bit
-**   R(0) := N(i)          -- Set the least-significant bit of R equal to bit i of the numerator
-**   if R >= D then
-**     R := R - D
-**     Q(i) := 1
-**   end
-** end
-*/
-void ALU_type::div(ALU_reg_pair dest, ALU_reg n, ALU_reg d)
-{
-	int i;
-	uint64 c, mask;
-
-	memset(dest, 0, sizeof(ALU_reg_pair));	// Q := 0
-	set(w1, 0x00);							// R := 0
-
-	// loop MS down to LS for integer part:
-	for (i = 0; i < ALU_LENGTH_U64; i++)
-	{
-		c = n[i];
-		for (mask = 1UI64 << 63; mask != 0UI64; mask >>= 1)
-		{
-			adc(w1, w1, ALU_LENGTH_U64);			// R <<= 1
-			if ((c & mask) != 0UI64)
-				w1[ALU_LENGTH_U64 - 1] |= 0x01;		// R(0) := N(i)
-
-			if (greater_or_equal(w1, d))			// if R >= D then
-			{
-				sub(w1, d, ALU_LENGTH_U64);			// R := R - D
-				dest[i] |= mask;					// Q(i) := 1
-			}
-		}
-	}
-
-	// continue loop for fractional part:
-	for (i = ALU_LENGTH_U64; i < 2 * ALU_LENGTH_U64; i++)
-	{
-		for (mask = 1UI64 << 63; mask != 0UI64; mask >>= 1)
-		{
-			adc(w1, w1, ALU_LENGTH_U64);			// R <<= 1
-													// R(0) := N(i), but N(i) = 0
-
-			if (greater_or_equal(w1, d))			// if R >= D then
-			{
-				sub(w1, d, ALU_LENGTH_U64);			// R := R - D
-				dest[i] |= mask;					// Q(i) := 1
-			}
-		}
-	}
-}
-
-/******************************************************************************
-** Function:	Get byte from array of u64s
-**
-** Notes:		Array of uint64 values stored big-endian, but each uint64 is little-endian
-**				indices go 7,6,5,4,3,2,1,0,15,14,13,12,11,10,9,8 etc.
-*/
-uint8 ALU_type::get_byte(uint8* p, int i)
-{
-	return p[i ^ 0x07];
-}
-
-/******************************************************************************
-** Function:	Set byte in array of u64s
-**
-** Notes:		Array of uint64 values stored big-endian, but each uint64 is little-endian
-**				indices go 7,6,5,4,3,2,1,0,15,14,13,12,11,10,9,8 etc.
-*/
-void ALU_type::set_byte(uint8 *p, int i, uint8 v)
-{
-	p[i ^ 0x07] = v;
-}
-
-/******************************************************************************
-** Function:
-**
-** Notes:
-*/
-void ALU_type::print_hex(uint8* r, int length_bytes, bool skip_leading_zeroes)
-{
-	int i = 0;
-
-	if (skip_leading_zeroes)
-	{
-		while ((get_byte(r, i) == 0x00) && (i < length_bytes - 1))
-			i++;
-	}
-
-	int c = 0;
-	while (i < length_bytes)
-	{
-		if ((c & 31) == 0)
-			printf("\n%04X: ", i);
-		c++;
-
-		printf("%02X ", get_byte(r, i++));
-	}
-
-	printf("\n\n");
-}
-
-/******************************************************************************
-** Function:
-**
-** Notes:
-*/
-void ALU_type::int_to_bcd(ALU_reg_pair dest, ALU_reg src)
-{
-	memset(dest, 0x00, sizeof(ALU_reg_pair));
-
-	bool ms_digit = false;
-	mov(w1, src);								// don't destroy src
-	int dest_index = 2 * ALU_LENGTH_BYTES - 1;	// NB byte index
-	uint8 digit_pair = 0;
-	uint64 remainder;
-	do
-	{
-		// Get next 4-bit BCD digit in remainder
-		if (div_u64(w1, 10UI64, ALU_LENGTH_U64, &remainder))	// returns true when finished
-			break;												// finished (w1 == 0)
-
-		// Put digit in output
-		if (ms_digit)
-		{
-			digit_pair |= (uint8)remainder << 4;
-			set_byte((uint8*)dest, dest_index--, digit_pair);
-		}
-		else
-		{
-			digit_pair = (uint8)remainder;
-			set_byte((uint8*)dest, dest_index, digit_pair);
-		}
-
-		ms_digit = !ms_digit;
-
-	} while (true);
-}
-
-/******************************************************************************
-** Function:	Fraction to BCD
-**
-** Notes:
-** Two digits per dest_index. Number of hex digits in src = ALU_LENGTH_BYTES * 2.
-** Number of decimal digits = log10(16) = 1.2041
-** So generate 1.2 times 2 * ALU_LENGTH_BYTES of output,
-** i.e. stop when dest_index > ALU_LENGTH_BYTES + ((10 * ALU_LENGTH_BYTES) / 49)
-*/
-void ALU_type::frac_to_bcd(ALU_reg_pair dest, ALU_reg src)
-{
-	memset(dest, 0x00, sizeof(ALU_reg_pair));
-
-	bool ms_digit = true;
-	mov(w1, src);								// don't destroy src
-	int dest_index = 0;							// NB byte index
-	uint8 digit_pair;
-	do
-	{
-		uint8 c = (uint8)mul_u64(w1, 10UI64, ALU_LENGTH_U64);
-
-		// Put digit in output
-		if (ms_digit)
-		{
-			digit_pair = c << 4;
-			set_byte((uint8 *)dest, dest_index, digit_pair);
-		}
-		else
-		{
-			digit_pair |= c;
-			set_byte((uint8*)dest, dest_index++, digit_pair);
-		}
-
-		ms_digit = !ms_digit;
-
-	} while (dest_index < (ALU_LENGTH_BYTES + ((10 * ALU_LENGTH_BYTES) / 49)));
-}
-
-/******************************************************************************
-** Function:
-**
-** Notes:
-*/
-void ALU_type::print_digit(uint8 digit)
-{
-	printf("%1X", digit);
-	if (++col > 59)
-	{
-		printf("\n");
-		col = 0;
-	}
-}
-
-/******************************************************************************
-** Function:	Print integer or fractional value supplied in BCD
-**
-** Notes:		Initialise col according to number of characters already printed
-**				before caqlling
-*/
-void ALU_type::print_bcd(ALU_reg_pair v, bool fraction)
-{
-	uint8 digit_pair;
-	int i = 0;
-	int end_index = 2 * ALU_LENGTH_BYTES;		// index of final pair of digits + 1
-
-	if (!fraction)								// suppress leading zeroes
-	{
-		while ((get_byte((uint8 *)v, i) == 0x00) && (i < end_index))
-			i++;
-
-		digit_pair = get_byte((uint8 *)v, i);
-		if ((digit_pair & 0xF0) == 0x00)		// suppress MS digit of first value
-		{
-			print_digit(digit_pair);
-			i++;
-		}
-	}
-	else										// suppress trailing zeroes
-	{
-		do
-		{
-			if (get_byte((uint8 *)v, --end_index) != 0x00)		// end_index references final non-zero digit pair
-				break;
-		} while (end_index > 1);
-
-		end_index++;							// last non-zero pair + 1
-	}
-
-	// Print pairs of digits:
-	while (i < end_index)
-	{
-		digit_pair = get_byte((uint8 *)v, i++);
-		print_digit(digit_pair >> 4);
-		print_digit(digit_pair & 0x0F);
-	}
-}
-
-
+/******************************************************************************
+** File:	Alu.cpp
+**
+** Notes:	Very long data word ALU functions		
+*/
+
+#include "stdafx.h"
+#include "Accum.h"
+#include "Alu.h"
+#include "Pool.h"
+#include "Ring.h"
+#include "Trace.h"
+
+#define ALU_MUL_PARALLEL_MIN_WORDS	64			// smaller products aren't worth splitting
+#define ALU_MUL_BLOCKS_PER_THREAD	4			// for load balance
+#define ALU_MUL_MAX_BLOCKS			(ALU_MUL_BLOCKS_PER_THREAD * POOL_MAX_THREADS)
+
+typedef struct
+{
+	uint64* dest;
+	uint64* x;
+	uint64* y;
+	int n;
+	const std::atomic<bool>* p_cancel;
+	int n_blocks;
+	int first_column[ALU_MUL_MAX_BLOCKS + 1];
+	uint64 carry[ALU_MUL_MAX_BLOCKS][2];		// out of each block's last column
+} alu_mul_context_type;
+
+#define ALU_DIV_PARALLEL_MIN_WORDS	2048		// shorter divisions aren't worth splitting
+#define ALU_DIV_PARALLEL_MIN_THREADS	3			// twice the divisions, so 2 threads at best break even
+
+typedef struct
+{
+	uint64* n;
+	uint64 d;
+	int length_words;
+	int n_chunks;
+	int pass;
+	uint64 residue[POOL_MAX_THREADS];			// chunk mod d in pass 0, remainder out in pass 1
+	uint64 remainder_in[POOL_MAX_THREADS];
+	bool nonzero[POOL_MAX_THREADS];
+} alu_div_context_type;
+
+ALU_type ALU;
+
+/******************************************************************************
+** Function:	Set all bytes of register to value
+**
+** Notes:
+*/
+void ALU_type::set(ALU_reg dest, uint8 byte_value)
+{
+	memset(dest, byte_value, ALU_LENGTH_BYTES);
+}
+
+/******************************************************************************
+** Function:	Copy one register to another
+**
+** Notes:
+*/
+void ALU_type::mov(ALU_reg dest, ALU_reg src)
+{
+	memcpy(dest, src, ALU_LENGTH_BYTES);
+}
+
+/******************************************************************************
+** Function:	Shift register right (+ve) or left (-ve), putting result in dest
+**
+** Notes:		Shift count is in 64-bit words, not bits. Src register unaffected
+*/
+void ALU_type::shr(ALU_reg dest, ALU_reg src, int word_count)
+{
+	set(dest, 0x00);
+	if (word_count >= 0)
+		memcpy(dest, &src[word_count], ALU_LENGTH_BYTES - (word_count * sizeof(uint64)));
+	else
+		memcpy(&dest[-word_count], src, ALU_LENGTH_BYTES + (word_count * sizeof(uint64)));
+}
+
+/******************************************************************************
+** Function:	Add with carry
+**
+** Notes:
+*/
+uint8 ALU_type::adc(ALU_reg dest, ALU_reg src, int length_words)
+{
+	uint8 c = 0;
+	TRACE_COUNT(TRACE_COUNTER_LIMBS, length_words);
+	for (int i = 0; i < length_words; i++)
+		c = _addcarry_u64(c, src[i], dest[i], &dest[i]);
+
+	return c;
+}
+
+/******************************************************************************
+** Function:	Compare registers
+**
+** Notes:		Returns true if a >= b, else false
+*/
+bool ALU_type::greater_or_equal(ALU_reg a, ALU_reg b)
+{
+	for (int i = ALU_LENGTH_U64 - 1; i >= 0; i--)
+	{
+		if (a[i] > b[i])
+			return true;
+
+		if (a[i] < b[i])
+			return false;
+	}
+
+	return true;
+}
+
+/******************************************************************************
+** Function:	dest -= src
+**
+** Notes:
+*/
+uint8 ALU_type::sub(ALU_reg dest, ALU_reg src, int length_words)
+{
+	uint8 b = 0;
+	TRACE_COUNT(TRACE_COUNTER_LIMBS, length_words);
+	for (int i = 0; i < length_words; i++)
+		b = _subborrow_u64(b, dest[i], src[i], &dest[i]);
+
+	return b;
+}
+
+/******************************************************************************
+** Function:	Add U64 value v into register pair at index i
+**
+** Notes:		Propagates carry up the register (or pair) as required,
+**				as far as its length_words
+*/
+void ALU_type::add_u64(ALU_reg dest, int i, uint64 v, int length_words)
+{
+	uint8 c = _addcarry_u64(0, v, dest[i], &dest[i]);
+
+	while ((c != 0) && (++i < length_words))
+	{
+		c = _addcarry_u64(c, 0UI64, dest[i], &dest[i]);
+		TRACE_COUNT(TRACE_COUNTER_CARRIES, 1);
+	}
+}
+
+/******************************************************************************
+** Function:	Subtract U64 value v from register pair at index i
+**
+** Notes:		Propagates borrow up the register (or pair) as required,
+**				as far as its length_words
+*/
+void ALU_type::sub_u64(ALU_reg dest, int i, uint64 v, int length_words)
+{
+	uint8 b = _subborrow_u64(0, dest[i], v, &dest[i]);
+
+	while ((b != 0) && (++i < length_words))
+	{
+		b = _subborrow_u64(b, dest[i], 0UI64, &dest[i]);
+		TRACE_COUNT(TRACE_COUNTER_CARRIES, 1);
+	}
+}
+
+/******************************************************************************
+** Function:	Multiply register by a uint64 & return carry
+**
+** Notes:
+*/
+uint64 ALU_type::mul_u64(ALU_reg r, uint64 v, int length_words)
+{
+	uint64 carry = 0UI64;
+	uint64 high;
+	TRACE_COUNT(TRACE_COUNTER_LIMBS, length_words);
+
+	for (int i = 0; i < length_words; i++)
+	{
+		uint64 low = _umul128(r[i], v, &high);
+		high += _addcarry_u64(0, low, carry, &r[i]);
+		carry = high;
+	}
+
+	return carry;
+}
+
+/******************************************************************************
+** Function:
+**
+** Notes:
+*/
+void ALU_type::mul(ALU_reg_pair dest, ALU_reg x, ALU_reg y)
+{
+	mul_words(dest, x, y, ALU_LENGTH_U64);
+}
+
+/******************************************************************************
+** Function:	Multiply columns first_column..end_column-1 of x * y into dest
+**
+** Notes:		Product scanning: column k is the sum
+**				of x.y word products of weight 2^(64k), accumulated in 3 words.
+**				Leaves the 2 words carried out of the last column in carry.
+*/
+void alu_mul_columns(alu_mul_context_type* c, int first_column, int end_column, uint64* carry)
+{
+	int n = c->n;
+	uint64 lo = 0UI64, mid = 0UI64, hi = 0UI64;
+	uint64 p_lo, p_hi;
+
+	for (int k = first_column; k < end_column; k++)
+	{
+		if (((k & 63) == 0) && (c->p_cancel != NULL) && c->p_cancel->load(std::memory_order_relaxed))
+			return;
+
+		int a0 = (k < n) ? 0 : k - n + 1;			// word index range in x
+		int a1 = (k < n) ? k : n - 1;
+		uint64* px = &c->x[a0];						// x word a, moving up
+		uint64* py = &c->y[k - a0];					// y word k - a, moving down
+
+		for (int a = a0; a <= a1; a++)
+		{
+			p_lo = _umul128(*px++, *py--, &p_hi);
+			uint8 cy = _addcarry_u64(0, lo, p_lo, &lo);
+			cy = _addcarry_u64(cy, mid, p_hi, &mid);
+			hi += cy;
+		}
+
+		c->dest[k] = lo;
+		lo = mid;
+		mid = hi;
+		hi = 0UI64;
+	}
+
+	carry[0] = lo;
+	carry[1] = mid;
+}
+
+/******************************************************************************
+** Function:	Pool task: one block of product columns
+**
+** Notes:
+*/
+void alu_mul_task(int task, void* p_context)
+{
+	alu_mul_context_type* c = (alu_mul_context_type*)p_context;
+
+	alu_mul_columns(c, c->first_column[task], c->first_column[task + 1], c->carry[task]);
+}
+
+/******************************************************************************
+** Function:	Multiply n-word values x & y into 2n-word dest
+**
+** Notes:		All LS word first. Lets callers work at less than full length,
+**				e.g. Newton iteration with precision doubling.
+**				Large products are split into blocks of columns of about equal
+**				work, run on the thread pool; then each block's carry is
+**				added into the next, LS block first.
+*/
+void ALU_type::mul_words(uint64* dest, uint64* x, uint64* y, int n)
+{
+	alu_mul_context_type c;
+
+	TRACE_SPAN("ALU mul");
+	TRACE_COUNT(TRACE_COUNTER_LIMBS, (uint64)n * n);
+
+	c.dest = dest;
+	c.x = x;
+	c.y = y;
+	c.n = n;
+	c.p_cancel = p_cancel;
+
+	c.n_blocks = 1;
+	if (n >= ALU_MUL_PARALLEL_MIN_WORDS)
+		c.n_blocks = (ALU_MUL_BLOCKS_PER_THREAD * POOL_threads() < ALU_MUL_MAX_BLOCKS) ?
+			ALU_MUL_BLOCKS_PER_THREAD * POOL_threads() : ALU_MUL_MAX_BLOCKS;
+
+	// Column k has min(k + 1, 2n - 1 - k) products; split the n^2 of them evenly:
+	uint64 work = 0UI64;
+	int block = 1;
+	c.first_column[0] = 0;
+	for (int k = 0; (k < 2 * n) && (block < c.n_blocks); k++)
+	{
+		work += (k < n) ? k + 1 : 2 * n - 1 - k;
+		if (work * c.n_blocks >= (uint64)block * n * n)
+			c.first_column[block++] = k + 1;
+	}
+	c.n_blocks = block;
+	c.first_column[c.n_blocks] = 2 * n;
+
+	POOL_run(c.n_blocks, alu_mul_task, &c);
+
+	if (cancelled())
+		return;
+
+	for (int i = 0; i < c.n_blocks - 1; i++)
+	{
+		int k = c.first_column[i + 1];				// first column of the next block
+		add_u64(dest, k, c.carry[i][0], 2 * n);
+		if (k + 1 < 2 * n)
+			add_u64(dest, k + 1, c.carry[i][1], 2 * n);
+	}
+}
+
+/******************************************************************************
+** Function:	(a * b + c) mod d
+**
+** Notes:		a, b, c < d, so the high word of the sum is less than d
+*/
+uint64 alu_mul_add_mod(uint64 a, uint64 b, uint64 c, uint64 d)
+{
+	uint64 high64, r;
+	uint64 low64 = _umul128(a, b, &high64);
+
+	high64 += _addcarry_u64(0, low64, c, &low64);
+	_udiv128(high64, low64, d, &r);
+	return r;
+}
+
+/******************************************************************************
+** Function:	Pool task: one chunk of a parallel div_u64
+**
+** Notes:		Pass 0 finds the chunk's value mod d, as if it stood alone.
+**				Pass 1 divides the chunk, starting from its incoming remainder.
+**				Chunk 0 is the MS chunk; each runs from its top word down.
+*/
+void alu_div_task(int chunk, void* p_context)
+{
+	alu_div_context_type* c = (alu_div_context_type*)p_context;
+	int first = c->length_words - (int)(((int64)(chunk + 1) * c->length_words) / c->n_chunks);
+	int end = c->length_words - (int)(((int64)chunk * c->length_words) / c->n_chunks);
+	uint64 r, any = 0UI64;
+
+	if (c->pass == 0)
+	{
+		r = 0UI64;
+		for (int i = end - 1; i >= first; i--)
+		{
+			any |= c->n[i];
+			_udiv128(r, c->n[i], c->d, &r);
+		}
+		c->residue[chunk] = r;
+		c->nonzero[chunk] = (any != 0UI64);
+	}
+	else
+	{
+		r = c->remainder_in[chunk];
+		for (int i = end - 1; i >= first; i--)
+			c->n[i] = _udiv128(r, c->n[i], c->d, &r);
+		c->residue[chunk] = r;					// remainder out
+	}
+}
+
+/******************************************************************************
+** Function:	Divide register by a uint64 & set remainder
+**
+** Notes:		Returns true when result is zero
+**				Long registers are divided in chunks on the thread pool: each
+**				chunk's value mod d is found in parallel, then a short serial
+**				pass gives each chunk its incoming remainder,
+**					r[j + 1] = (r[j] * 2^(64 * chunk length) + residue[j]) mod d
+**				and finally all chunks are divided in parallel. That is twice
+**				the divisions, so it only pays with ALU_DIV_PARALLEL_MIN_THREADS
+**				or more.
+*/
+bool ALU_type::div_u64(ALU_reg n, uint64 d, int length_words, uint64* p_remainder)
+{
+	*p_remainder = 0UI64;
+	bool z = true;								// assume result is 0
+
+	if (d == 0UI64)								// trap divide by zero
+	{
+		memset(n, 0xFF, length_words * sizeof(uint64));
+		return false;
+	}
+	// else:
+
+	TRACE_COUNT(TRACE_COUNTER_LIMBS, length_words);
+	TRACE_COUNT(TRACE_COUNTER_DIVISIONS, length_words);
+
+	if ((length_words >= ALU_DIV_PARALLEL_MIN_WORDS) && (POOL_threads() >= ALU_DIV_PARALLEL_MIN_THREADS) && (d > 1UI64))
+	{
+		alu_div_context_type c;
+
+		TRACE_COUNT(TRACE_COUNTER_DIVISIONS, length_words);		// the extra pass
+		c.n = n;
+		c.d = d;
+		c.length_words = length_words;
+		c.n_chunks = POOL_threads();
+		c.pass = 0;
+		POOL_run(c.n_chunks, alu_div_task, &c);
+
+		uint64 r = 0UI64;
+		uint64 base;								// 2^64 mod d
+		_udiv128(1UI64, 0UI64, d, &base);
+		for (int j = 0; j < c.n_chunks; j++)
+		{
+			c.remainder_in[j] = r;
+
+			// r = (r * 2^(64 * length) + residue) mod d, by square & multiply:
+			int length = (int)((((int64)(j + 1) * length_words) / c.n_chunks) - (((int64)j * length_words) / c.n_chunks));
+			uint64 power = 1UI64 % d;
+			uint64 square = base;
+			for (; length != 0; length >>= 1)
+			{
+				if ((length & 1) != 0)
+					power = alu_mul_add_mod(power, square, 0UI64, d);
+				square = alu_mul_add_mod(square, square, 0UI64, d);
+			}
+			r = alu_mul_add_mod(r, power, c.residue[j], d);
+
+			if (c.nonzero[j])
+				z = false;
+		}
+
+		c.pass = 1;
+		POOL_run(c.n_chunks, alu_div_task, &c);
+		*p_remainder = c.residue[c.n_chunks - 1];
+		return z;
+	}
+
+	for (int i = length_words - 1; i >= 0; i--)
+	{
+		n[i] = _udiv128(*p_remainder, n[i], d, p_remainder);
+		if ((n[i] | *p_remainder) != 0UI64)
+			z = false;
+	}
+
+	return z;
+}
+
+/******************************************************************************
+** Function:	Put the signed sum of one word of several quotients, to go
+**				into word i of acc
+**
+** Notes:		Quotient words come MS first, so a carry (or borrow) out of
+**				word i would go into words already done; acc keeps it beside
+**				word i instead, until it's normalised.
+*/
+inline void alu_put_sum(ACCUM_type* acc, int i, uint64 plus, uint64 plus_high, uint64 minus, uint64 minus_high)
+{
+	uint64 lo;
+	uint8 b = _subborrow_u64(0, plus, minus, &lo);
+
+	ACCUM_put(acc, i, lo, (int64)(plus_high - minus_high - b));
+}
+
+/******************************************************************************
+** Function:	acc += sum of +/- numerator / divisor, for several terms at once
+**
+** Notes:		Each term's numerator is a single word at top_word; words
+**				above it are zero, so their quotient words are too. All the
+**				quotients are made word by word & added straight into acc,
+**				in one pass, instead of a clear, divide & add pass per term.
+**				Same result as dividing & adding or subtracting each in turn,
+**				once acc is normalised.
+*/
+void ALU_type::div_sum(ACCUM_type* acc, const ALU_term_type* terms, int n_terms, int top_word)
+{
+	uint64 remainder[ALU_MAX_TERMS];
+
+	TRACE_COUNT(TRACE_COUNTER_LIMBS, top_word + 1);
+	TRACE_COUNT(TRACE_COUNTER_DIVISIONS, (uint64)n_terms * (top_word + 1));
+	for (int k = 0; k < n_terms; k++)
+		remainder[k] = 0UI64;
+
+	for (int i = top_word; i >= 0; i--)
+	{
+		uint64 plus = 0UI64, plus_high = 0UI64;
+		uint64 minus = 0UI64, minus_high = 0UI64;
+
+		for (int k = 0; k < n_terms; k++)
+		{
+			uint64 q = _udiv128(remainder[k], (i == top_word) ? terms[k].numerator : 0UI64, terms[k].divisor, &remainder[k]);
+			if (terms[k].negative)
+				minus_high += _addcarry_u64(0, minus, q, &minus);
+			else
+				plus_high += _addcarry_u64(0, plus, q, &plus);
+		}
+
+		alu_put_sum(acc, i, plus, plus_high, minus, minus_high);
+	}
+
+	ACCUM_flush(acc);
+}
+
+/******************************************************************************
+** Function:	t /= divisor[k], then acc += t, for each divisor in turn
+**
+** Notes:		As a run of div_u64 & adc, but in one pass: each word of t
+**				goes through all the divisions while in a machine register.
+**				Words of t above top_word must be zero. acc is as div_sum.
+**				Returns true when t ends up zero.
+*/
+bool ALU_type::div_chain_sum(ACCUM_type* acc, ALU_reg t, const uint64* divisors, int n_divisors, int top_word)
+{
+	uint64 remainder[ALU_MAX_TERMS];
+	uint64 any = 0UI64;
+
+	TRACE_COUNT(TRACE_COUNTER_LIMBS, top_word + 1);
+	TRACE_COUNT(TRACE_COUNTER_DIVISIONS, (uint64)n_divisors * (top_word + 1));
+	for (int k = 0; k < n_divisors; k++)
+		remainder[k] = 0UI64;
+
+	for (int i = top_word; i >= 0; i--)
+	{
+		uint64 x = t[i];
+		uint64 sum = 0UI64, sum_high = 0UI64;
+
+		for (int k = 0; k < n_divisors; k++)
+		{
+			x = _udiv128(remainder[k], x, divisors[k], &remainder[k]);
+			sum_high += _addcarry_u64(0, sum, x, &sum);
+		}
+
+		t[i] = x;
+		any |= x;
+		alu_put_sum(acc, i, sum, sum_high, 0UI64, 0UI64);
+	}
+
+	ACCUM_flush(acc);
+	return any == 0UI64;
+}
+
+/******************************************************************************
+** Function:	Divide n by d
+**
+** Notes:
+** Q := 0                  -- Initialize quotient and remainder to zero
+** R := 0                     
+** for i := n - 1 .. 0 do  -- Where n is number of bits in N
+**   R := R << 1           -- Left-shift R by 1 bit
+**   R(0) := N(i)          -- Set the least-significant bit of R equal to bit i of the numerator
+**   if R >= D then
+**     R := R - D
+**     Q(i) := 1
+**   end
+** end
+*/
+void ALU_type::div(ALU_reg_pair dest, ALU_reg n, ALU_reg d)
+{
+	int i;
+	uint64 c, mask;
+
+	TRACE_SPAN("ALU div");
+	memset(dest, 0, sizeof(ALU_reg_pair));	// Q := 0
+	set(w1, 0x00);							// R := 0
+
+	// loop MS down to LS for integer part; quotient word i (from the MS) is dest[q]:
+	for (i = 0; i < ALU_LENGTH_U64; i++)
+	{
+		int q = (2 * ALU_LENGTH_U64) - 1 - i;
+
+		if (cancelled())
+			return;
+
+		c = n[ALU_LENGTH_U64 - 1 - i];
+		for (mask = 1UI64 << 63; mask != 0UI64; mask >>= 1)
+		{
+			adc(w1, w1, ALU_LENGTH_U64);			// R <<= 1
+			if ((c & mask) != 0UI64)
+				w1[0] |= 0x01;						// R(0) := N(i)
+
+			if (greater_or_equal(w1, d))			// if R >= D then
+			{
+				sub(w1, d, ALU_LENGTH_U64);			// R := R - D
+				dest[q] |= mask;					// Q(i) := 1
+			}
+		}
+
+		if (p_output != NULL)
+			p_output->push(&dest[q], 1, p_cancel);
+	}
+
+	// continue loop for fractional part:
+	for (i = ALU_LENGTH_U64; i < 2 * ALU_LENGTH_U64; i++)
+	{
+		int q = (2 * ALU_LENGTH_U64) - 1 - i;
+
+		if (cancelled())
+			return;
+
+		for (mask = 1UI64 << 63; mask != 0UI64; mask >>= 1)
+		{
+			adc(w1, w1, ALU_LENGTH_U64);			// R <<= 1
+													// R(0) := N(i), but N(i) = 0
+
+			if (greater_or_equal(w1, d))			// if R >= D then
+			{
+				sub(w1, d, ALU_LENGTH_U64);			// R := R - D
+				dest[q] |= mask;					// Q(i) := 1
+			}
+		}
+
+		if (p_output != NULL)
+			p_output->push(&dest[q], 1, p_cancel);
+	}
+}
+
+/******************************************************************************
+** Function:	Set register to an integer given as text
+**
+** Notes:		Decimal, or hex with a 0x prefix. Returns false if the text
+**				isn't a number or the value doesn't fit in the register.
+**				Decimal digits are taken 19 at a time, one mul_u64 each.
+*/
+bool ALU_type::from_text(ALU_reg dest, const char* text)
+{
+	set(dest, 0x00);
+
+	if ((text[0] == '0') && ((text[1] | 0x20) == 'x'))
+	{
+		text += 2;
+		if (*text == '\0')
+			return false;
+
+		for (; *text != '\0'; text++)
+		{
+			int c = *text | 0x20;					// lower case
+			uint64 digit;
+			if ((c >= '0') && (c <= '9'))
+				digit = c - '0';
+			else if ((c >= 'a') && (c <= 'f'))
+				digit = c - 'a' + 10;
+			else
+				return false;
+
+			if ((dest[ALU_LENGTH_U64 - 1] >> 60) != 0UI64)	// would overflow
+				return false;
+
+			mul_u64(dest, 16UI64, ALU_LENGTH_U64);
+			dest[0] |= digit;
+		}
+
+		return true;
+	}
+
+	if (*text == '\0')
+		return false;
+
+	while (*text != '\0')
+	{
+		uint64 chunk = 0UI64;
+		uint64 scale = 1UI64;
+		for (int i = 0; (i < 19) && (*text != '\0'); i++, text++)
+		{
+			if ((*text < '0') || (*text > '9'))
+				return false;
+
+			chunk = (chunk * 10UI64) + (*text - '0');
+			scale *= 10UI64;
+		}
+
+		if (mul_u64(dest, scale, ALU_LENGTH_U64) != 0UI64)
+			return false;
+
+		uint8 c = _addcarry_u64(0, dest[0], chunk, &dest[0]);
+		for (int i = 1; (i < ALU_LENGTH_U64) && (c != 0); i++)
+			c = _addcarry_u64(c, dest[i], 0UI64, &dest[i]);
+
+		if (c != 0)
+			return false;
+	}
+
+	return true;
+}
+
+/******************************************************************************
+** Function:	Get byte i, counting from the MS end, from array of u64s
+**
+** Notes:		Array of uint64 values stored LS first, & each uint64 is little-endian,
+**				so the whole array is one little-endian number & byte i from the
+**				MS end is at (length in bytes - 1 - i)
+*/
+uint8 ALU_type::get_byte(const uint64* r, int length_words, int i)
+{
+	return ALU_view(r, length_words).byte(i);
+}
+
+/******************************************************************************
+** Function:	Set byte i, counting from the MS end, in array of u64s
+**
+** Notes:		As get_byte
+*/
+void ALU_type::set_byte(uint64* r, int length_words, int i, uint8 v)
+{
+	((uint8*)r)[(length_words * sizeof(uint64)) - 1 - i] = v;
+}
+
+/******************************************************************************
+** Function:	Print the first length_bytes of a value, MS byte first
+**
+** Notes:
+*/
+void ALU_type::print_hex(ALU_view_type v, int length_bytes, bool skip_leading_zeroes)
+{
+	int i = 0;
+
+	if (skip_leading_zeroes)
+	{
+		while ((v.byte(i) == 0x00) && (i < length_bytes - 1))
+			i++;
+	}
+
+	int c = 0;
+	while (i < length_bytes)
+	{
+		if ((c & 31) == 0)
+			printf("\n%04X: ", i);
+		c++;
+
+		printf("%02X ", v.byte(i++));
+	}
+
+	printf("\n\n");
+}
+
+/******************************************************************************
+** Function:
+**
+** Notes:
+*/
+void ALU_type::int_to_bcd(ALU_reg_pair dest, ALU_reg src)
+{
+	TRACE_SPAN("ALU int_to_bcd");
+	memset(dest, 0x00, sizeof(ALU_reg_pair));
+
+	bool ms_digit = false;
+	mov(w1, src);								// don't destroy src
+	int dest_index = 2 * ALU_LENGTH_BYTES - 1;	// NB byte index
+	uint8 digit_pair = 0;
+	uint64 remainder;
+	do
+	{
+		// Get next 4-bit BCD digit in remainder
+		if (div_u64(w1, 10UI64, ALU_LENGTH_U64, &remainder))	// returns true when finished
+			break;												// finished (w1 == 0)
+
+		// Put digit in output
+		if (ms_digit)
+		{
+			digit_pair |= (uint8)remainder << 4;
+			set_byte(dest, 2 * ALU_LENGTH_U64, dest_index--, digit_pair);
+		}
+		else
+		{
+			digit_pair = (uint8)remainder;
+			set_byte(dest, 2 * ALU_LENGTH_U64, dest_index, digit_pair);
+		}
+
+		ms_digit = !ms_digit;
+
+	} while (!cancelled());
+}
+
+/******************************************************************************
+** Function:	Fraction to BCD
+**
+** Notes:
+** Two digits per dest_index. Number of hex digits in src = ALU_LENGTH_BYTES * 2.
+** Number of decimal digits = log10(16) = 1.2041
+** So generate 1.2 times 2 * ALU_LENGTH_BYTES of output,
+** i.e. stop when dest_index > ALU_LENGTH_BYTES + ((10 * ALU_LENGTH_BYTES) / 49)
+*/
+void ALU_type::frac_to_bcd(ALU_reg_pair dest, ALU_reg src)
+{
+	TRACE_SPAN("ALU frac_to_bcd");
+	memset(dest, 0x00, sizeof(ALU_reg_pair));
+
+	bool ms_digit = true;
+	mov(w1, src);								// don't destroy src
+	int dest_index = 0;							// NB byte index
+	uint8 digit_pair;
+	do
+	{
+		uint8 c = (uint8)mul_u64(w1, 10UI64, ALU_LENGTH_U64);
+
+		// Put digit in output
+		if (ms_digit)
+		{
+			digit_pair = c << 4;
+			set_byte(dest, 2 * ALU_LENGTH_U64, dest_index, digit_pair);
+		}
+		else
+		{
+			digit_pair |= c;
+			set_byte(dest, 2 * ALU_LENGTH_U64, dest_index++, digit_pair);
+		}
+
+		ms_digit = !ms_digit;
+
+	} while ((dest_index < (ALU_LENGTH_BYTES + ((10 * ALU_LENGTH_BYTES) / 49))) && !cancelled());
+}
+
+/******************************************************************************
+** Function:
+**
+** Notes:
+*/
+void ALU_type::print_digit(uint8 digit)
+{
+	printf("%1X", digit);
+	if (++col > 59)
+	{
+		printf("\n");
+		col = 0;
+	}
+}
+
+/******************************************************************************
+** Function:	Print integer or fractional value supplied in BCD
+**
+** Notes:		Initialise col according to number of characters already printed
+**				before caqlling
+*/
+void ALU_type::print_bcd(ALU_reg_pair v, bool fraction)
+{
+	uint8 digit_pair;
+	int i = 0;
+	int end_index = 2 * ALU_LENGTH_BYTES;		// index of final pair of digits + 1
+
+	if (!fraction)								// suppress leading zeroes
+	{
+		while ((get_byte(v, 2 * ALU_LENGTH_U64, i) == 0x00) && (i < end_index))
+			i++;
+
+		digit_pair = get_byte(v, 2 * ALU_LENGTH_U64, i);
+		if ((digit_pair & 0xF0) == 0x00)		// suppress MS digit of first value
+		{
+			print_digit(digit_pair);
+			i++;
+		}
+	}
+	else										// suppress trailing zeroes
+	{
+		do
+		{
+			if (get_byte(v, 2 * ALU_LENGTH_U64, --end_index) != 0x00)		// end_index references final non-zero digit pair
+				break;
+		} while (end_index > 1);
+
+		end_index++;							// last non-zero pair + 1
+	}
+
+	// Print pairs of digits:
+	while (i < end_index)
+	{
+		digit_pair = get_byte(v, 2 * ALU_LENGTH_U64, i++);
+		print_digit(digit_pair >> 4);
+		print_digit(digit_pair & 0x0F);
+	}
+}
+
+
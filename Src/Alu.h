@@ -1,47 +1,94 @@
-/******************************************************************************
-** File:	Alu.h
-**
-** Notes:	Very long integer ALU functions, big-endian format
-** NB array registers go MS to LS, but each array element (uint64) is little-endian.
-*/
-
-#define ALU_LENGTH_U64		2048
-#define ALU_LENGTH_BYTES	(ALU_LENGTH_U64 * sizeof(uint64))
-
-typedef uint64 ALU_reg[ALU_LENGTH_U64];
-typedef uint64 ALU_reg_pair[2 * ALU_LENGTH_U64];
-
-class ALU_type
-{
-private:
-	ALU_reg w1;
-
-	void print_digit(uint8 digit);
-
-public:
-	int col;
-
-	void set(ALU_reg dest, uint8 byte_value);
-	void mov(ALU_reg dest, ALU_reg src);
-	void shr(ALU_reg dest, ALU_reg src, int word_count);
-	uint8 adc(ALU_reg dest, ALU_reg src, int length_words);
-	void add_u64(ALU_reg dest, int i, uint64 v);
-	uint8 sub(ALU_reg dest, ALU_reg src, int length_words);
-	bool greater_or_equal(ALU_reg a, ALU_reg b);
-
-	uint64 mul_u64(ALU_reg r, uint64 v, int length_words);
-	void mul(ALU_reg_pair dest, ALU_reg x, ALU_reg y);
-	bool div_u64(ALU_reg n, uint64 d, int length_words, uint64 *p_remainder);
-	void div(ALU_reg_pair dest, ALU_reg n, ALU_reg d);
-
-	uint8 get_byte(uint8* p, int i);
-	void set_byte(uint8* p, int i, uint8 v);
-	void print_hex(uint8 *r, int length_bytes, bool skip_leading_zeroes);
-
-	void int_to_bcd(ALU_reg_pair dest, ALU_reg src);
-	void frac_to_bcd(ALU_reg_pair dest, ALU_reg src);
-	void print_bcd(ALU_reg_pair v, bool fraction);
-};
-
-extern ALU_type ALU;
-
+/******************************************************************************
+** File:	Alu.h
+**
+** Notes:	Very long integer ALU functions, little-endian format
+** NB array registers go LS to MS, word 0 least significant, as in other bignum code,
+** so carries run forward through memory. ALU_view_type reads them MS first.
+*/
+
+#define ALU_LENGTH_U64		2048
+#define ALU_LENGTH_BYTES	(ALU_LENGTH_U64 * sizeof(uint64))
+
+typedef uint64 ALU_reg[ALU_LENGTH_U64];
+typedef uint64 ALU_reg_pair[2 * ALU_LENGTH_U64];
+
+#define ALU_MAX_TERMS		8				// terms per div_sum or div_chain_sum
+
+typedef struct
+{
+	uint64 numerator;
+	uint64 divisor;
+	bool negative;							// subtract this term
+} ALU_term_type;
+
+// Big-endian view of an LS-first value: word(0) & byte(0) are its MS word & byte,
+// the order antplots are walked & hex dumps printed in. Only the indices change.
+typedef struct
+{
+	const uint64* p;
+	int length_words;
+
+	uint64 word(int k) const { return p[length_words - 1 - k]; }
+	uint8 byte(int i) const { return ((const uint8*)p)[(length_words * sizeof(uint64)) - 1 - i]; }
+} ALU_view_type;
+
+inline ALU_view_type ALU_view(const uint64* p, int length_words)
+{
+	ALU_view_type v = { p, length_words };
+	return v;
+}
+
+// The MS n_words of a length_words value:
+inline ALU_view_type ALU_view_top(const uint64* p, int length_words, int n_words)
+{
+	ALU_view_type v = { p + length_words - n_words, n_words };
+	return v;
+}
+
+class RING_type;
+struct ACCUM_type;
+
+class ALU_type
+{
+private:
+	ALU_reg w1;
+
+	void print_digit(uint8 digit);
+
+	bool cancelled(void) { return (p_cancel != NULL) && p_cancel->load(std::memory_order_relaxed); }
+
+public:
+	int col;
+	const std::atomic<bool>* p_cancel;		// if set, long operations give up early when it becomes true
+	RING_type* p_output;					// if set, div streams each quotient word here once it is final
+
+	void set(ALU_reg dest, uint8 byte_value);
+	void mov(ALU_reg dest, ALU_reg src);
+	void shr(ALU_reg dest, ALU_reg src, int word_count);
+	uint8 adc(ALU_reg dest, ALU_reg src, int length_words);
+	void add_u64(ALU_reg dest, int i, uint64 v, int length_words);
+	void sub_u64(ALU_reg dest, int i, uint64 v, int length_words);
+	uint8 sub(ALU_reg dest, ALU_reg src, int length_words);
+	bool greater_or_equal(ALU_reg a, ALU_reg b);
+
+	uint64 mul_u64(ALU_reg r, uint64 v, int length_words);
+	void mul(ALU_reg_pair dest, ALU_reg x, ALU_reg y);
+	void mul_words(uint64* dest, uint64* x, uint64* y, int n);
+	bool div_u64(ALU_reg n, uint64 d, int length_words, uint64 *p_remainder);
+	void div_sum(ACCUM_type* acc, const ALU_term_type* terms, int n_terms, int top_word);
+	bool div_chain_sum(ACCUM_type* acc, ALU_reg t, const uint64* divisors, int n_divisors, int top_word);
+	void div(ALU_reg_pair dest, ALU_reg n, ALU_reg d);
+
+	bool from_text(ALU_reg dest, const char* text);
+
+	uint8 get_byte(const uint64* r, int length_words, int i);
+	void set_byte(uint64* r, int length_words, int i, uint8 v);
+	void print_hex(ALU_view_type v, int length_bytes, bool skip_leading_zeroes);
+
+	void int_to_bcd(ALU_reg_pair dest, ALU_reg src);
+	void frac_to_bcd(ALU_reg_pair dest, ALU_reg src);
+	void print_bcd(ALU_reg_pair v, bool fraction);
+};
+
+extern ALU_type ALU;
+
@@ -0,0 +1,298 @@
+/******************************************************************************
+** File:	Anim.cpp
+**
+** Notes:	Frame-batched animation export. The ant walk hands a copy of the
+**			visible part of the framebuffer to an encoder thread every N steps,
+**			so the encoding and writing of frames overlaps with the walk.
+*/
+
+#include "stdafx.h"
+
+#include "Anim.h"
+
+bool anim_enabled;
+int anim_format;
+uint32 anim_interval = 256;					// steps per frame
+char anim_filename[MAX_PATH] = "antplot";
+
+int anim_plot_count;						// numbers the output files
+int anim_frame_count;
+
+const uint32* anim_pixels;					// framebuffer being walked
+int anim_stride;
+int anim_width, anim_height;
+bool anim_recording;
+
+FILE* anim_file;
+uint8* anim_line;							// conversion buffer for one plane or row
+
+uint32* anim_buffer[ANIM_N_BUFFERS];		// ring of captured frames
+int anim_head, anim_tail, anim_count;
+bool anim_finish;
+
+std::mutex anim_mutex;
+std::condition_variable anim_cv;
+std::thread anim_thread;
+
+/******************************************************************************
+** Function:	Write one frame in the selected format
+**
+** Notes:		Runs on the encoder thread. Pixels are 0x00RRGGBB.
+**				Y4M is written as 4:4:4 BT.601 so that any frame size is legal.
+*/
+void anim_write_frame(const uint32* frame)
+{
+	int n_pixels = anim_width * anim_height;
+	int i;
+
+	if (anim_format == ANIM_FORMAT_PPM)
+	{
+		char name[MAX_PATH + 32];
+		sprintf(name, "%s_%03d_%06d.ppm", anim_filename, anim_plot_count, anim_frame_count);
+		anim_file = fopen(name, "wb");
+		if (anim_file == NULL)
+			return;
+
+		fprintf(anim_file, "P6\n%d %d\n255\n", anim_width, anim_height);
+	}
+
+	if (anim_file == NULL)
+		return;
+
+	if (anim_format == ANIM_FORMAT_Y4M)
+	{
+		fprintf(anim_file, "FRAME\n");
+
+		for (i = 0; i < n_pixels; i++)				// Y plane
+		{
+			uint32 c = frame[i];
+			int r = (c >> 16) & 0xFF, g = (c >> 8) & 0xFF, b = c & 0xFF;
+			anim_line[i] = (uint8)(16 + ((66 * r + 129 * g + 25 * b + 128) >> 8));
+		}
+		fwrite(anim_line, 1, n_pixels, anim_file);
+
+		for (i = 0; i < n_pixels; i++)				// U plane
+		{
+			uint32 c = frame[i];
+			int r = (c >> 16) & 0xFF, g = (c >> 8) & 0xFF, b = c & 0xFF;
+			anim_line[i] = (uint8)(128 + ((-38 * r - 74 * g + 112 * b + 128) >> 8));
+		}
+		fwrite(anim_line, 1, n_pixels, anim_file);
+
+		for (i = 0; i < n_pixels; i++)				// V plane
+		{
+			uint32 c = frame[i];
+			int r = (c >> 16) & 0xFF, g = (c >> 8) & 0xFF, b = c & 0xFF;
+			anim_line[i] = (uint8)(128 + ((112 * r - 94 * g - 18 * b + 128) >> 8));
+		}
+		fwrite(anim_line, 1, n_pixels, anim_file);
+	}
+	else											// RGB24, raw or PPM
+	{
+		for (i = 0; i < n_pixels; i++)
+		{
+			uint32 c = frame[i];
+			anim_line[3 * i] = (uint8)(c >> 16);
+			anim_line[3 * i + 1] = (uint8)(c >> 8);
+			anim_line[3 * i + 2] = (uint8)c;
+		}
+		fwrite(anim_line, 3, n_pixels, anim_file);
+	}
+
+	if (anim_format == ANIM_FORMAT_PPM)
+	{
+		fclose(anim_file);
+		anim_file = NULL;
+	}
+
+	anim_frame_count++;
+}
+
+/******************************************************************************
+** Function:	Encoder thread
+**
+** Notes:		Frees each buffer only after it has been written out
+*/
+void anim_encoder(void)
+{
+	do
+	{
+		std::unique_lock<std::mutex> lock(anim_mutex);
+		anim_cv.wait(lock, [] { return (anim_count > 0) || anim_finish; });
+
+		if (anim_count == 0)					// finished & queue drained
+			break;
+
+		uint32* frame = anim_buffer[anim_tail];
+		lock.unlock();
+
+		anim_write_frame(frame);
+
+		lock.lock();
+		anim_tail = (anim_tail + 1) % ANIM_N_BUFFERS;
+		anim_count--;
+		anim_cv.notify_all();
+	} while (true);
+}
+
+/******************************************************************************
+** Function:	Copy the visible part of the framebuffer into the queue
+**
+** Notes:		Blocks only if the encoder has fallen ANIM_N_BUFFERS frames behind
+*/
+void anim_capture(void)
+{
+	std::unique_lock<std::mutex> lock(anim_mutex);
+	anim_cv.wait(lock, [] { return anim_count < ANIM_N_BUFFERS; });
+	uint32* frame = anim_buffer[anim_head];
+	lock.unlock();
+
+	for (int y = 0; y < anim_height; y++)
+		memcpy(&frame[y * anim_width], &anim_pixels[y * anim_stride], anim_width * sizeof(uint32));
+
+	lock.lock();
+	anim_head = (anim_head + 1) % ANIM_N_BUFFERS;
+	anim_count++;
+	anim_cv.notify_all();
+}
+
+/******************************************************************************
+** Function:	Animation export command
+**
+** Notes:		Toggles export; when switching on, prompts for the settings
+*/
+void ANIM_configure(void)
+{
+	int i;
+
+	if (anim_enabled)
+	{
+		anim_enabled = false;
+		printf("\n*** Animation export OFF\n");
+		return;
+	}
+
+	printf("\nSteps per frame (currently %u): ", anim_interval);
+	scanf("%d", &i);
+	if (i < 1)
+	{
+		printf("*** Value out of range. Animation export unchanged.\n");
+		return;
+	}
+	anim_interval = (uint32)i;
+
+	printf("Format (0 = Y4M video, 1 = raw RGB24 stream, 2 = numbered PPM images): ");
+	scanf("%d", &i);
+	if ((i < ANIM_FORMAT_Y4M) || (i > ANIM_FORMAT_PPM))
+	{
+		printf("*** Value out of range. Animation export unchanged.\n");
+		return;
+	}
+	anim_format = i;
+
+	printf("Output file name, without extension: ");
+	scanf("%200s", anim_filename);
+
+	anim_enabled = true;
+	printf("\n*** Animation export ON: one frame every %u steps, written to %s_NNN%s\n", anim_interval,
+		anim_filename, (anim_format == ANIM_FORMAT_Y4M) ? ".y4m" : (anim_format == ANIM_FORMAT_RGB) ? ".rgb" : "_NNNNNN.ppm");
+}
+
+/******************************************************************************
+** Function:	Is export on?
+**
+** Notes:		Plots made ahead aren't recorded, so aren't used while it is
+*/
+bool ANIM_enabled(void)
+{
+	return anim_enabled;
+}
+
+/******************************************************************************
+** Function:	Start recording a plot
+**
+** Notes:		pixels/stride describe the framebuffer; width & height the visible part
+*/
+void ANIM_begin(const uint32* pixels, int stride, int width, int height)
+{
+	if (!anim_enabled || (width < 1) || (height < 1))
+		return;
+
+	anim_pixels = pixels;
+	anim_stride = stride;
+	anim_width = width;
+	anim_height = height;
+	anim_frame_count = 0;
+	anim_plot_count++;
+
+	if (anim_format != ANIM_FORMAT_PPM)
+	{
+		char name[MAX_PATH + 16];
+		sprintf(name, "%s_%03d.%s", anim_filename, anim_plot_count, (anim_format == ANIM_FORMAT_Y4M) ? "y4m" : "rgb");
+		anim_file = fopen(name, "wb");
+		if (anim_file == NULL)
+		{
+			printf("\n*** Unable to create %s. Animation export OFF\n", name);
+			anim_enabled = false;
+			return;
+		}
+
+		if (anim_format == ANIM_FORMAT_Y4M)
+			fprintf(anim_file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, ANIM_FRAME_RATE);
+	}
+
+	for (int i = 0; i < ANIM_N_BUFFERS; i++)
+		anim_buffer[i] = (uint32*)malloc(width * height * sizeof(uint32));
+	anim_line = (uint8*)malloc(width * height * 3);
+
+	anim_head = anim_tail = anim_count = 0;
+	anim_finish = false;
+	anim_recording = true;
+	anim_thread = std::thread(anim_encoder);
+
+	anim_capture();							// first frame shows the empty board
+}
+
+/******************************************************************************
+** Function:	Called after each step of the walk
+**
+** Notes:		Captures a frame every anim_interval steps
+*/
+void ANIM_step(uint32 step)
+{
+	if (anim_recording && ((step % anim_interval) == 0))
+		anim_capture();
+}
+
+/******************************************************************************
+** Function:	Finish recording a plot
+**
+** Notes:		Captures the final frame, then waits for the encoder to drain
+*/
+void ANIM_end(void)
+{
+	if (!anim_recording)
+		return;
+
+	anim_capture();
+
+	{
+		std::lock_guard<std::mutex> lock(anim_mutex);
+		anim_finish = true;
+	}
+	anim_cv.notify_all();
+	anim_thread.join();
+	anim_recording = false;
+
+	if (anim_file != NULL)
+	{
+		fclose(anim_file);
+		anim_file = NULL;
+	}
+
+	for (int i = 0; i < ANIM_N_BUFFERS; i++)
+		free(anim_buffer[i]);
+	free(anim_line);
+
+	printf("\n*** Animation: %d frames of %d x %d written for plot %03d\n", anim_frame_count, anim_width, anim_height, anim_plot_count);
+}
@@ -0,0 +1,18 @@
+/******************************************************************************
+** File:	Anim.h
+**
+** Notes:	Export of antplot animations as Y4M, raw RGB or numbered PPM frames
+*/
+
+#define ANIM_FORMAT_Y4M		0
+#define ANIM_FORMAT_RGB		1
+#define ANIM_FORMAT_PPM		2
+
+#define ANIM_N_BUFFERS		4				// frames queued between walker and encoder
+#define ANIM_FRAME_RATE		30
+
+void ANIM_configure(void);
+bool ANIM_enabled(void);
+void ANIM_begin(const uint32* pixels, int stride, int width, int height);
+void ANIM_step(uint32 step);
+void ANIM_end(void);
@@ -1,812 +1,2115 @@
-/******************************************************************************
-** File:	App.cpp	
-**
-** Notes:	Antplot app for Langton's Ant, reciprocals, factorials, pi and e
-**
-*/
-
-#include "stdafx.h"
-
-#include "Alu.h"
-#include "Fav.h"
-
-#define extern
-#include "App.h"
-#undef extern
-
-#define LANGTONS_ANT_ITERATIONS		12000
-
-HACCEL app_hAccelTable;
-
-bool app_prompt;
-bool app_animate;
-bool app_mode_reciprocal;
-
-uint8 app_direction;			// 0..3
-uint8 app_zoom_level;
-
-int app_favourite_index;
-uint64 app_reciprocal_int;
-uint64 app_factorial_int;
-
-ALU_reg_pair app_f_reg;
-
-ALU_reg ant_trail;
-ALU_reg app_trail_integer;			// first 9977 steps
-ALU_reg app_trail_fraction;			// recurring 13-byte pattern
-ALU_reg app_a;						// Value of A, where L = A / B
-
-ALU_reg r1, r2;
-ALU_reg_pair hl, bc;
-
-uint8 app_board[300][300];
-
-typedef struct
-{
-	int pos_x, pos_y;
-	int dir_x, dir_y;
-} app_ant_type;
-
-typedef struct
-{
-	char command_character;
-	const char *help_string;
-	ptr_to_function p_function;
-} app_command_table_entry_type;
-
-// Command table appears at the end of this file
-extern const app_command_table_entry_type app_command_table[];
-extern const int app_n_commands;
-
-/******************************************************************************
-** Function:
-**
-** Notes:
-*/
-char app_wait_for_keypress(void)
-{
-	MSG msg;
-
-	if (app_prompt)
-	{
-		printf("\nPress command key: > ");
-		fflush(stdin);
-		app_prompt = false;
-	}
-
-	do
-	{
-		// Run the message loop to allow plot window to be moved etc
-		if (PeekMessage(&msg, APP_hWnd, 0, 0, PM_REMOVE))
-		{
-			if (!TranslateAccelerator(msg.hwnd, app_hAccelTable, &msg))
-			{
-				TranslateMessage(&msg);
-				DispatchMessage(&msg);
-			}
-		}
-		else
-			Sleep(50);
-	} while (!_kbhit());
-
-	return _getch();
-}
-
-/******************************************************************************
-** Function:	Paint antplot display to screen
-**
-** Notes:
-*/
-void APP_paint(void)
-{
-	PAINTSTRUCT ps;
-	HDC hdc;
-
-	hdc = BeginPaint(APP_hWnd, &ps);
-
-	StretchBlt(hdc, 0, 0, APP_SCREEN_WIDTH, APP_SCREEN_HEIGHT, APP_hdc, 0, 0,
-		APP_SCREEN_WIDTH / (1 << app_zoom_level), APP_SCREEN_HEIGHT / (1 << app_zoom_level), SRCCOPY);
-
-	EndPaint(APP_hWnd, &ps);
-}
-
-//*****************************************************************************
-// Function:	Plot words supplied in big-endian order
-//
-// Notes: Provide pointer to start of register data
-// Pause after plot if prompt != NULL
-//
-void app_plot(uint64* v, int length_words, const char* prompt, bool wait)
-{
-	int i;
-	app_ant_type ant;
-
-	// Clear screen:
-	RECT r = { 0, 0, APP_SCREEN_WIDTH, APP_SCREEN_HEIGHT };
-	HBRUSH brush = CreateSolidBrush(RGB(50, 85, 100));
-	//HBRUSH brush = CreateSolidBrush(RGB(255, 255, 255));		// (RGB(0, 0, 0));
-	FillRect(APP_hdc, &r, brush);				//(HBRUSH)GetStockObject(DKGRAY_BRUSH));
-	DeleteObject(brush);
-
-	// Set initial position: use centre of screen
-	ant.pos_x = APP_SCREEN_WIDTH / (1 << (app_zoom_level + 1));
-	ant.pos_y = APP_SCREEN_HEIGHT / (1 << (app_zoom_level + 1));
-
-	// Set initial direction: 0 = (-1, 0), 1 = (0, 1), 2 = (1, 0), 3 = (0, -1)
-	ant.dir_x = (~app_direction & 0x01) * (app_direction - 1);
-	ant.dir_y = (app_direction & 0x01) * ((app_direction ^ 0x03) - 1);
-	//printf("\nInitial direction: %d, %d\n\n", ant.dir_x, ant.dir_y);
-
-	// suppress leading zeroes:
-	for (i = 0; i < length_words; i++)			// Find first non-zero word
-	{
-		if (v[i] != 0UI64)
-			break;
-	}
-
-	uint64 c = v[i];
-	uint64 m = 1UI64 << 63;
-	while (((c & m) == 0UI64) && (m != 0UI64))		// find first non-zero bit
-		m >>= 1;
-
-	uint32 step = 0;
-	while (i < length_words)
-	{
-		int s = 1;									// default direction
-		if ((c & m) == 0x00)						// set pixel white
-		{
-			SetPixel(APP_hdc, ant.pos_x, ant.pos_y, RGB(0xFF, 0xFF, 0xFF));
-			if (ant.dir_x != 0)
-				s = -1;
-		}
-		else										// set pixel black
-		{
-			SetPixel(APP_hdc, ant.pos_x, ant.pos_y, RGB(0x00, 0x00, 0x00));
-			if (ant.dir_x == 0)
-				s = -1;
-		}
-
-		int x = ant.dir_x;
-		ant.dir_x = s * ant.dir_y;
-		ant.dir_y = s * x;
-
-		ant.pos_x += ant.dir_x;
-		ant.pos_y += ant.dir_y;
-
-		m >>= 1;
-		if (m == 0UI64)
-		{
-			m = 1UI64 << 63;
-			c = v[++i];
-		}
-
-		if (app_animate)
-		{
-			ShowWindow(APP_hWnd, SW_SHOWNORMAL);
-			InvalidateRect(APP_hWnd, NULL, TRUE);
-			UpdateWindow(APP_hWnd);
-
-			printf("** Step %u. Next step or 'a' >>\n", ++step);
-			if (app_wait_for_keypress() == 'a')
-			{
-				app_animate = false;
-				printf("\n*** Animate mode OFF\n");
-			}
-		}
-	}
-
-	ShowWindow(APP_hWnd, SW_SHOWNORMAL);
-	BringWindowToTop(APP_hWnd);
-	InvalidateRect(APP_hWnd, NULL, TRUE);
-	UpdateWindow(APP_hWnd);
-
-	if (prompt != NULL)
-		printf("\n%s\n\n", prompt);
-
-	if (wait)
-	{
-		printf("Press any key to continue >>> ");
-		app_wait_for_keypress();
-	}
-}
-
-/******************************************************************************
-** Function:	Generate Langton's Ant into ant_trail in big-endian order
-**
-** Notes:
-*/
-void app_generate_ant(int n_steps)
-{
-	app_ant_type ant;
-
-	memset(app_board, 0xFF, sizeof(app_board));			// all white
-
-	ant.pos_x = 150;
-	ant.pos_y = 150;
-	ant.dir_x = 0;
-	ant.dir_y = 1;
-
-	// Get Langton's Ant pattern in the destination register
-	// Recurrent pattern starts after 9977 steps, which is (156 * 64) - 7.
-	// For convenience with 64-bit integer words, set mask so ant starts 7 steps into the first word,
-	// so the non-recurrent part of the ant trail is 156 words long.
-	uint64 mask = 1UI64 << (63 - 7);					// start 7 steps into first word
-	ALU.set(ant_trail, 0);								// initialise 1-dimensional ant trail
-	int i = 0;											// index into ant_trail (uint64 values)
-	for (int step = 0; step < n_steps; step++)
-	{
-		int s = 1;
-		if (app_board[ant.pos_x][ant.pos_y] != 0)		// Pixel is white
-		{
-			app_board[ant.pos_x][ant.pos_y] = 0;		// turn it black
-			if (ant.dir_x != 0)
-				s = -1;
-
-			ant_trail[i] |= mask;						// set 1 wherever we turn pixel black
-		}
-		else											// pixel is black
-		{
-			app_board[ant.pos_x][ant.pos_y] = 1;		// turn it white
-			if (ant.dir_x == 0)
-				s = -1;
-
-			// leave the corresponding bit in ant_trail as 0 (white)
-		}
-
-		int x = ant.dir_x;
-		ant.dir_x = s * ant.dir_y;
-		ant.dir_y = s * x;
-
-		ant.pos_x += ant.dir_x;
-		ant.pos_y += ant.dir_y;
-
-		mask >>= 1;
-		if (mask == 0UI64)								// start the next word in ant_trail
-		{
-			mask = 1UI64 << 63;
-			i++;
-		}
-	}
-}
-
-/******************************************************************************
-** Function:	Plot reciprocal of a 64-bit integer value
-**
-** Notes:
-*/
-void app_plot_reciprocal(uint64 v)
-{
-	// Compute 0.5 / v:
-	uint64 remainder = 0UI64;
-	memset(hl, 0, sizeof(hl));
-	hl[0] = 1UI64 << 63;
-	ALU.div_u64(hl, v, 2 * ALU_LENGTH_U64, &remainder);
-
-	// correct to 1 / v:
-	ALU.adc(hl, hl, 2 * ALU_LENGTH_U64);
-
-	printf("\n1 / %I64d (first 1024 hex digits):\n", v);
-	ALU.col = 0;
-	ALU.print_hex((uint8*)hl, 512, false);
-	printf("\n\n");
-
-	// Print value, and lowest integer which would give the identical pattern:
-	printf("\n1 / %I64d ", v);
-	int power;
-	for (power = 0; power < 64; power++)
-	{
-		if ((v & 1UI64) != 0UI64)
-			break;
-		v >>= 1;
-	}
-	if (power > 0)
-		printf(" (= 1 / (%llu * 2^%d))", v, power);
-	printf(":\n");
-
-	app_plot(hl, 2 * ALU_LENGTH_U64, NULL, false);
-}
-
-/******************************************************************************
-** Function:
-**
-** Notes:
-*/
-void app_plot_factorial(bool calculate_from_scratch)
-{
-	uint64 i = app_factorial_int;									// assume we already have (n - 1)! in app_f_reg
-	
-	if ((app_factorial_int < 2) || calculate_from_scratch)			// redo full calculation
-	{
-		memset(app_f_reg, 0, sizeof(app_f_reg));
-		app_f_reg[N_ELEMENTS(app_f_reg) - 1] = 1UI64;
-		i = 2UI64;
-	}
-
-	for (; i <= app_factorial_int; i++)
-	{
-		if (ALU.mul_u64(app_f_reg, i, N_ELEMENTS(app_f_reg)) != 0UI64)
-		{
-			printf("\n*** Numeric overflow for factorial of %llu\n", app_factorial_int);
-			break;
-		}
-	}
-
-	printf("%llu!:\n", app_factorial_int);
-	ALU.col = 0;
-	
-	ALU.print_hex((uint8 *)app_f_reg, sizeof(app_f_reg), true);
-	// ALU.int_to_bcd(hl, &app_f_reg[ALU_LENGTH_U64]);
-	// ALU.print_bcd(hl, false);
-	
-	printf("\n\n");
-
-	printf("Plotting %llu!\n", app_factorial_int);
-	app_plot(app_f_reg, N_ELEMENTS(app_f_reg), NULL, false);
-}
-
-/******************************************************************************
-** Function:
-**
-** Notes:
-*/
-void app_toggle_animation(void)
-{
-	app_animate = !app_animate;
-	printf("\n*** Animate mode %s\n", app_animate ? "ON" : "OFF");
-}
-
-/******************************************************************************
-** Function: go back 2 values from current factorial or reciprocal
-**
-** Notes:
-*/
-void app_go_back(void)
-{
-	if (app_mode_reciprocal)
-	{
-		app_reciprocal_int = (app_reciprocal_int < 3) ? 0UI64 : app_reciprocal_int - 2;
-		app_plot_reciprocal(app_reciprocal_int);
-	}
-	else
-	{
-		app_factorial_int = (app_factorial_int < 3) ? 0UI64 : app_factorial_int - 2;
-		app_plot_factorial(true);
-	}
-}
-
-/******************************************************************************
-** Function: Calculate A and B, where L = A / B
-**
-** Notes:
-*/
-void app_calculate(void)
-{
-	uint64 remainder;
-
-	app_generate_ant(LANGTONS_ANT_ITERATIONS);
-
-	// Get just the integer & fractional parts
-	// Recurrent pattern starts after 9977 steps, which is (156 * 64) - 7.
-	// Number of 64-bit words = 156
-	// Integer part goes at the LS end of the trail_integer register
-	ALU.shr(app_trail_integer, ant_trail, ALU_LENGTH_U64 - 156);
-	printf("\nAnt trail, Integer part:\n");
-	ALU.print_hex((uint8*)app_trail_integer, ALU_LENGTH_BYTES, true);
-	app_plot(app_trail_integer, ALU_LENGTH_U64, "Integer part", true);
-
-	// Fractional part goes at the MS end of the trail_fraction register
-	ALU.shr(app_trail_fraction, ant_trail, -156);
-	printf("\nAnt trail, Fractional part, first 128 bytes:\n");
-	ALU.print_hex((uint8*)app_trail_fraction, 128, true);
-	app_plot(app_trail_fraction, ALU_LENGTH_U64, "Fractional part", true);
-
-	printf("\nComputing values of A and B, where L = A / B....\n");
-	// Langton's Ant recurrence pattern: 4F 27 9E 5E 87 B7 85 EF 0B D3 0C F3 49
-	// The HCF of the above pattern and 0xFFFFFFFFFFFFFFFFFFFFFFFFFF is 5.
-	// Compute value of C from recurrence pattern divided by 5:
-	ALU.set(r1, 0);
-	r1[ALU_LENGTH_U64 - 2] = app_trail_fraction[0];
-	r1[ALU_LENGTH_U64 - 1] = app_trail_fraction[1] & 0xFFFFFFFFFF000000UI64;
-
-	// r1 now contains recurrent pattern << 24, so divide it by 5 << 24 to get C
-	ALU.div_u64(r1, 5UI64 << 24, ALU_LENGTH_U64, &remainder);	// r1 = C
-
-	// Get value of B in r2, where B = 0xFFFFFFFFFFFFFFFFFFFFFFFFFF / 5:
-	ALU.set(r2, 0);
-	r2[ALU_LENGTH_U64 - 2] = 0x3333333333UI64;
-	r2[ALU_LENGTH_U64 - 1] = 0x3333333333333333UI64;
-
-	ALU.mul(hl, r2, app_trail_integer);								// hl = B.Li
-	ALU.mov(app_a, &hl[ALU_LENGTH_U64]);						// app_a = l
-	ALU.adc(app_a, r1, ALU_LENGTH_U64);							// app_a = B.Li + C
-
-	ALU.div(bc, app_a, r2);										// bc = A/B
-
-	app_plot(bc, 2 * ALU_LENGTH_U64, "Plotting L = A / B", true);
-
-	// Print & Plot A:
-	printf("\nValue of A:\n");
-	ALU.col = 0;
-	ALU.print_hex((uint8*)app_a, ALU_LENGTH_BYTES, true);
-	printf("\n\n");
-	app_plot(app_a, ALU_LENGTH_U64, "Plotting value of A", true);
-
-	// Print & Plot B:
-	printf("\nValue of B:\n");
-	ALU.col = 0;
-	ALU.print_hex((uint8*)r2, ALU_LENGTH_BYTES, true);
-	printf("\n\n");
-	app_plot(r2, ALU_LENGTH_U64, "\nPlotting value of B", true);
-
-	// A as a decimal integer:
-	printf("\n\nA as a decimal integer:\n\n");
-	ALU.int_to_bcd(bc, app_a);
-	ALU.col = 0;
-	ALU.print_bcd(bc, false);
-	printf("\n\n");
-
-	// B as a decimal integer:
-	printf("\n\nB as a decimal integer:\n\n");
-	ALU.int_to_bcd(bc, r2);
-	ALU.col = 0;
-	ALU.print_bcd(bc, false);
-	printf("\n\n");
-}
-
-/******************************************************************************
-** Function:
-**
-** Notes:
-*/
-void app_set_direction(void)
-{
-	int i;
-
-	printf("\nCurrent initial direction = %d\nEnter new initial direction (0..3): ", app_direction);
-	scanf("%d", &i);
-	app_direction = i & 0x03;
-}
-
-/******************************************************************************
-** Function:
-**
-** Notes:
-**
-*/
-void app_calc_e(void)
-{
-	memset(bc, 0, sizeof(bc));		// next term
-	bc[0] = 1UI64 << 63;
-	memset(hl, 0, sizeof(hl));		// value of e
-	hl[0] = 1UI64 << 63;
-
-	uint64 i = 2UI64;
-	uint64 remainder;
-	do
-	{
-		if (ALU.div_u64(bc, i++, 2 * ALU_LENGTH_U64, &remainder))
-			break;
-
-		ALU.adc(hl, bc, 2 * ALU_LENGTH_U64);
-
-		if ((i & 0xFF) == 0UI64)
-			printf("%lld\n", i);
-	} while (true);
-
-	// double it:
-	ALU.adc(hl, hl, 2 * ALU_LENGTH_U64);
-
-	// e as a decimal fraction:
-	printf("e as a decimal fraction:\n");
-	ALU.frac_to_bcd(bc, hl);
-	printf(" 2.");
-	ALU.col = 3;
-	ALU.print_bcd(bc, true);
-	printf("\n\n");
-
-	// Plot it:
-	ALU.div_u64(hl, 4, ALU_LENGTH_U64, &remainder);
-	hl[0] |= 2UI64 << 62;
-	app_plot(hl, ALU_LENGTH_U64, "Plotting e", false);
-}
-
-/******************************************************************************
-** Function:
-**
-** Notes:
-*/
-void app_favourite()
-{
-	if (app_favourite_index >= N_ELEMENTS(app_favourites))
-	{
-		printf("\n\nStart of favourites list\n\n");
-		app_favourite_index = 0;
-	}
-
-	app_plot_reciprocal(app_favourites[app_favourite_index++]);
-}
-
-/******************************************************************************
-** Function:	Help command
-**
-** Notes:
-*/
-void app_help(void)
-{
-	printf("\n*** Antplot App V" APP_VERSION_STRING "\n");
-	printf("\n*** Commands:\n");
-
-	for (int i = 0; i < app_n_commands; i++)
-		printf("*** %c - %s\n", app_command_table[i].command_character, app_command_table[i].help_string);
-}
-
-/******************************************************************************
-** Function:
-**
-** Notes:
-** Langton's Ant recurrence pattern: 4F 27 9E 5E 87 B7 85 EF 0B D3 0C F3 49
-** Starts after 9977 steps (1248 bytes minus 7 steps)
-*/
-void app_langton(void)
-{
-	app_generate_ant(LANGTONS_ANT_ITERATIONS);
-
-	// Plot whole ant trail:
-	printf("\nPlotting %d steps of ant trail\n", LANGTONS_ANT_ITERATIONS);
-	app_plot(ant_trail, (LANGTONS_ANT_ITERATIONS + 63) / 64, NULL, false);
-}
-
-/******************************************************************************
-** Function:
-**
-** Notes:
-*/
-void app_toggle_mode(void)
-{
-	app_mode_reciprocal = !app_mode_reciprocal;
-	printf("\n*** Reciprocal/Factorial mode: %s\n", app_mode_reciprocal ? "RECIPROCAL" : "FACTORIAL");
-}
-
-/******************************************************************************
-** Function:	Next plot of reciprocal or factorial of a 64-bit integer value
-**
-** Notes:
-*/
-void app_next_plot(void)
-{
-	if (app_mode_reciprocal)
-		app_plot_reciprocal(++app_reciprocal_int);
-	else
-	{
-		app_factorial_int++;
-		app_plot_factorial(false);
-	}
-}
-
-/******************************************************************************
-** Function:	Calculate pi using the BBP algorithm
-**
-** Notes:
-*  total = 0;
-*  for (i = 0; i < infinity; i++)
-*  {
-*      n = 8 * i;
-*      r = (4/(n + 1)) - (2/(n + 4)) - (1/(n + 5)) - (1/(n + 6))
-*      total += r >> (4 * i);
-*  }
-*/
-void app_calc_pi(void)
-{
-	memset(bc, 0, sizeof(bc));		// value of pi
-
-	uint64 i = 0;
-	uint64 remainder;
-	bool z;
-	do
-	{
-		uint64 n = i << 3;
-		int index = (int)i >> 4;											// word index
-		if (index >= 2 * ALU_LENGTH_U64)
-			break;
-
-		int shift_count = 61 - (4 * (i & 0x0F));
-
-		memset(hl, 0, sizeof(hl));
-		hl[index] = 4UI64 << shift_count;
-		z = ALU.div_u64(hl, n + 1, 2 * ALU_LENGTH_U64, &remainder);	// hl = (1 / (2 * (n + 1)))
-		ALU.adc(bc, hl, 2 * ALU_LENGTH_U64);						// bc += hl
-		
-		memset(hl, 0, sizeof(hl));
-		hl[index] = 2UI64 << shift_count;
-		ALU.div_u64(hl, n + 4, 2 * ALU_LENGTH_U64, &remainder);		// hl = (1 / (4 * (n + 4)))
-		ALU.sub(bc, hl, 2 * ALU_LENGTH_U64);						// bc -= (1 / (4(n + 4)))
-
-		memset(hl, 0, sizeof(hl));
-		hl[index] = 1UI64 << shift_count;
-		ALU.div_u64(hl, n + 5, 2 * ALU_LENGTH_U64, &remainder);		// hl = (1 / (8 * (n + 5)))
-		ALU.sub(bc, hl, 2 * ALU_LENGTH_U64);						// bc -= 1/(8(n+5))
-
-		memset(hl, 0, sizeof(hl));
-		hl[index] = 1UI64 << shift_count;
-		ALU.div_u64(hl, n + 6, 2 * ALU_LENGTH_U64, &remainder);		// hl = (1 / (8 * (n + 6)))
-		ALU.sub(bc, hl, 2 * ALU_LENGTH_U64);						// bc -= 1/(8(n+6))
-
-		if ((++i & 0xFF) == 0UI64)
-			printf("%lld\n", i);
-
-	} while (!z);
-
-	memcpy(r1, bc, sizeof(r1));
-	ALU.mul_u64(r1, 8, ALU_LENGTH_U64);
-
-	// e as a decimal fraction:
-	printf("pi as a decimal fraction:\n");
-	ALU.frac_to_bcd(bc, r1);
-	printf(" 3.");
-	ALU.col = 3;
-	ALU.print_bcd(bc, true);
-	printf("\n\n");
-
-	// Plot it:
-	app_plot(r1, ALU_LENGTH_U64, "Plotting pi", false);
-}
-
-/******************************************************************************
-** Function:
-**
-** Notes:
-*/
-void app_quit(void)
-{
-	exit(0);
-}
-
-/******************************************************************************
-** Function: Plot a random bit pattern
-**
-** Notes:
-*/
-void app_plot_random(void)
-{
-	for (int i = 0; i < ALU_LENGTH_U64; i++)
-	{
-		r1[i] = 0UI64;
-		for (int j = 0; j < 64; j += 8)
-			r1[i] |= (uint64)(rand() & 0xFF) << j;
-	}
-
-	printf("\nFirst 1024 hex digits of random sequence:\n");
-	ALU.col = 0;
-	ALU.print_hex((uint8*)r1, 512, false);
-	app_plot(r1, ALU_LENGTH_U64, "Plotting random bit sequence", false);
-}
-
-/******************************************************************************
-** Function:
-**
-** Notes:
-*/
-void app_test(void)
-{
-}
-
-/******************************************************************************
-** Function:
-**
-** Notes:
-*/
-void app_set_start_value(void)
-{
-	printf("\n*** Enter start value for %s: ", app_mode_reciprocal ? "reciprocal" : "factorial");
-
-	if (app_mode_reciprocal)
-	{
-		scanf("%" SCNu64, &app_reciprocal_int);
-		app_plot_reciprocal(app_reciprocal_int);
-	}
-	else		// factorial
-	{
-		scanf("%" SCNu64, &app_factorial_int);
-		app_plot_factorial(true);
-	}
-}
-
-/******************************************************************************
-** Function:
-**
-** Notes:
-*/
-void app_set_zoom(void)
-{
-	int i;
-
-	printf("Current zoom level is %d\n\nSet new zoom level (0..255) : ", app_zoom_level);
-	scanf("%d", &i);
-	if ((i < 0) || (i > 255))
-		printf("*** Value out of range. Zoom level unchanged.\n");
-	else
-		app_zoom_level = (uint8)i;
-}
-
-/******************************************************************************
-** Function:	Execute single character command
-**
-** Notes:
-*/
-void app_execute_command(char c)
-{
-	printf("%c\n", c);
-
-	for (int i = 0; i < app_n_commands; i++)
-	{
-		// ensure lower case comparison:
-		if ((app_command_table[i].command_character | 0x20) == c)
-		{
-			app_command_table[i].p_function();
-			return;
-		}
-	}
-
-	printf("*** Unrecognised command key.\n");
-}
-
-/******************************************************************************
-** Function:	Task
-**
-** Notes:
-*/
-void APP_task(void)
-{
-	char keycode = 0;
-
-	app_prompt = true;
-	app_zoom_level = 1;
-	app_help();					// Display help at start
-	app_toggle_mode();			// sets app_mode_reciprocal = true & reports mode
-
-	srand(GetTickCount());		// seed randomizer
-
-	do
-	{
-		if (keycode != 0)
-		{
-			app_execute_command(keycode);
-			keycode = 0;
-			app_prompt = true;
-		}
-
-		keycode = app_wait_for_keypress();
-	} while (true);
-}
-
-/******************************************************************************
-** Command table:
-*/
-const app_command_table_entry_type app_command_table[] =
-{
-	{ 'a', "Toggle animation mode on/off", app_toggle_animation },
-	{ 'b', "Go back 2 values", app_go_back },
-	{ 'c', "Calculate integer expression for Langton's ant", app_calculate },
-	{ 'd', "Set initial ant direction", app_set_direction },
-	{ 'e', "Calculate & plot e", app_calc_e },
-	{ 'f', "Next favourite", app_favourite },
-	{ 'h', "Help", app_help },
-	{ 'l', "Langton's Ant", app_langton },
-	{ 'm', "Mode (factorial or reciprocal)", app_toggle_mode },
-	{ 'n', "Next factorial or reciprocal plot", app_next_plot },
-	{ 'p', "Calculate & plot pi", app_calc_pi },
-	{ 'q', "Quit", app_quit },
-	{ 'r', "Plot a random bit sequence", app_plot_random },
-	// { 't', "Test", app_test },
-	{ 'v', "Set value for reciprocal or factorial", app_set_start_value },
-	{ 'z', "Set zoom factor", app_set_zoom }
-};
-
-const int app_n_commands = N_ELEMENTS(app_command_table);
-
-
-
-
-
-
-
+/******************************************************************************
+** File:	App.cpp	
+**
+** Notes:	Antplot app for Langton's Ant, reciprocals, factorials, pi and e
+**
+*/
+
+#include "stdafx.h"
+
+#include "Alu.h"
+#include "Anim.h"
+#include "Bench.h"
+#include "Calc.h"
+#include "Cycle.h"
+#include "Fav.h"
+#include "Filemap.h"
+#include "Pool.h"
+#include "Random.h"
+#include "Ring.h"
+#include "Seq.h"
+#include "Serve.h"
+#include "Stats.h"
+#include "Store.h"
+#include "Trace.h"
+#include "Turmite.h"
+
+#define extern
+#include "App.h"
+#undef extern
+
+// Pixel colours in APP_pixels format (0x00RRGGBB):
+#define APP_COLOUR_BACKGROUND		0x00325564UL		// RGB(50, 85, 100)
+#define APP_COLOUR_WHITE			0x00FFFFFFUL
+#define APP_COLOUR_BLACK			0x00000000UL
+
+#define APP_BACKGROUND_TICK_MS		10			// main thread poll interval while a job runs
+#define APP_REFRESH_TICKS			10			// redraw plot window every 100 ms
+#define APP_PROGRESS_TICKS			100			// report progress every second
+
+#define APP_MAX_INTEGER_TEXT		40000		// characters, enough for a register in decimal
+
+#define APP_MONTE_CARLO_SAMPLES		1000000		// default random strings for 'k'
+#define APP_MONTE_CARLO_WORDS		64			// default length of each
+
+#define APP_CYCLE_PERIODS			1000000000000UI64	// default periods of 1 / v for 'y'
+#define APP_CYCLE_MAX_MOVE			(1UI64 << 62)		// furthest the ant is followed, in cells
+
+#define APP_SEQUENCE_BASE			3			// default a, for a^n
+
+#define APP_CHECKPOINT_SECONDS		1.0			// factorials taking longer are stored at once, others at exit
+
+#define APP_SPECULATE_TARGETS		3			// n + 1, n + 2 & n - 2, as n & b show next
+#define APP_SPECULATE_ENTRIES		4			// plots kept; at least APP_SPECULATE_TARGETS
+
+// Modes of 'n', 'b' & 'v', in the order 'm' steps through them:
+#define APP_MODE_RECIPROCAL			0
+#define APP_MODE_FACTORIAL			1
+#define APP_MODE_SEQUENCE			2			// + SEQ_x
+#define APP_N_MODES					(APP_MODE_SEQUENCE + SEQ_N_KINDS)
+
+HACCEL app_hAccelTable;
+
+bool app_prompt;
+bool app_animate;
+int app_mode;
+
+uint8 app_direction;			// 0..3
+uint8 app_zoom_level;
+
+int app_favourite_index;
+uint64 app_reciprocal_int;
+uint64 app_factorial_int;
+bool app_factorial_ok;
+uint64 app_sequence_int;
+uint64 app_sequence_base;				// a, for a^n
+bool app_sequence_ok;
+SEQ_type app_sequence;
+
+CALC_job_type* app_job;				// registers for the interactive commands
+std::atomic<bool> app_worker_done;
+
+ALU_view_type app_walk_view;			// argument for app_walk
+uint64 app_walk_reciprocal;			// argument for the streamed reciprocal plot
+uint64 app_rational_words;			// fraction words for the rational plot
+bool app_rational_ok;
+uint64 app_window_k;					// first bit of the window of 1 / v
+bool app_root_ok;
+uint64 app_turmite_steps;				// argument for the turmite plot
+uint64 app_pre_bits;					// arguments for A / B of a repeating trail
+uint64 app_period_bits;
+uint64 app_random_seed;					// random plots & Monte Carlo strings are streams of this
+uint64 app_random_stream;				// next stream for a random plot
+uint64 app_monte_carlo_samples;			// arguments for the Monte Carlo run
+uint64 app_monte_carlo_from;			// sweep 1 / v from here, or 0 for random strings
+int app_monte_carlo_words;
+STATS_result_type app_monte_carlo_result;
+uint64 app_cycle_v;						// arguments for the long-range plot of 1 / v
+uint64 app_cycle_periods;
+CYCLE_reciprocal_type app_cycle;
+CALC_ant_type app_cycle_start;			// where & which way the walk of app_cycle began
+FILEMAP_type app_file;					// file for the file plot
+bool app_file_ok;						// all of it was streamed
+int app_serve_port;
+bool app_serve_ok;
+
+const char* const app_mode_names[APP_N_MODES] =
+	{ "RECIPROCAL", "FACTORIAL", "POWER a^n", "FIBONACCI", "PRIMORIAL", "CENTRAL BINOMIAL C(2n, n)" };
+
+RING_type app_ring;					// words streamed from a generator to the walk
+
+typedef struct
+{
+	CALC_ant_type ant;
+	bool started;						// leading zeroes have been skipped
+	uint32 step;
+	uint32* pixels;						// APP_pixels, or a plot made ahead
+	CALC_job_type* job;					// walk stops when this is cancelled
+	bool on_screen;						// steps can be animated & recorded
+} app_walker_type;
+
+typedef struct
+{
+	int mode;							// key: value n as plotted in mode, with base,
+	uint64 n;							// from direction & at zoom_level
+	uint64 base;
+	uint8 direction;
+	uint8 zoom_level;
+	bool ready;
+	std::vector<uint32> pixels;			// as APP_pixels
+	uint64 value[SEQ_WORDS];			// register plotted, LS word first
+	uint64 next[SEQ_WORDS];				// Fibonacci: F(n + 1)
+	int n_words;						// sequences: as SEQ_type
+	uint64 prime;
+} app_speculation_type;
+
+app_speculation_type app_speculations[APP_SPECULATE_ENTRIES];	// plots made ahead for n & b
+CALC_job_type* app_speculate_job;		// own registers, so it runs beside app_job
+SEQ_type app_speculate_sequence;
+std::thread app_speculator;
+int app_speculate_order[APP_SPECULATE_TARGETS];		// entries to make, first first
+int app_n_speculate;
+std::atomic<int> app_speculate_slot;	// entry being made, or -1
+std::atomic<bool> app_speculate_finish;	// stop after the entry being made
+
+typedef struct
+{
+	char command_character;
+	const char *help_string;
+	ptr_to_function p_function;
+} app_command_table_entry_type;
+
+// Command table appears at the end of this file
+extern const app_command_table_entry_type app_command_table[];
+extern const int app_n_commands;
+
+// Plots made ahead appear after the walker
+void app_speculate_cancel(void);
+
+/******************************************************************************
+** Function:
+**
+** Notes:
+*/
+char app_wait_for_keypress(void)
+{
+	MSG msg;
+
+	if (app_prompt)
+	{
+		printf("\nPress command key: > ");
+		fflush(stdin);
+		app_prompt = false;
+	}
+
+	do
+	{
+		// Run the message loop to allow plot window to be moved etc
+		if (PeekMessage(&msg, APP_hWnd, 0, 0, PM_REMOVE))
+		{
+			if (!TranslateAccelerator(msg.hwnd, app_hAccelTable, &msg))
+			{
+				TranslateMessage(&msg);
+				DispatchMessage(&msg);
+			}
+		}
+		else
+			Sleep(50);
+	} while (!_kbhit());
+
+	return _getch();
+}
+
+/******************************************************************************
+** Function:	Run function on a background worker thread
+**
+** Notes:		Keeps the message loop running, redraws the plot window
+**				progressively if refresh is set, and reports app_job progress.
+**				Any keypress cancels the job. Returns false if cancelled.
+**				Plots being made ahead are abandoned.
+*/
+bool app_background(ptr_to_function p_function, bool refresh)
+{
+	MSG msg;
+	uint32 ticks = 0;
+	uint64 last_progress = 0UI64;
+
+	app_speculate_cancel();					// the job has the cores to itself
+	app_job->cancel = false;
+	app_job->progress = 0UI64;
+	app_job->progress_total = 0UI64;
+	app_worker_done = false;
+
+	GdiFlush();								// GDI batches per thread, so a pipeline can't flush ours
+	std::thread worker([p_function] { p_function(); app_worker_done = true; });
+
+	while (!app_worker_done)
+	{
+		while (PeekMessage(&msg, APP_hWnd, 0, 0, PM_REMOVE))
+		{
+			if (!TranslateAccelerator(msg.hwnd, app_hAccelTable, &msg))
+			{
+				TranslateMessage(&msg);
+				DispatchMessage(&msg);
+			}
+		}
+
+		if (_kbhit() && !app_job->cancel)
+		{
+			_getch();								// key is consumed, not taken as a command
+			app_job->cancel = true;
+			printf("\n*** Cancelling...\n");
+		}
+
+		Sleep(APP_BACKGROUND_TICK_MS);
+		ticks++;
+
+		if (refresh && ((ticks % APP_REFRESH_TICKS) == 0))
+		{
+			InvalidateRect(APP_hWnd, NULL, FALSE);
+			UpdateWindow(APP_hWnd);
+		}
+
+		uint64 progress = app_job->progress;
+		uint64 progress_total = app_job->progress_total;	// once, as the job may change it
+		if (((ticks % APP_PROGRESS_TICKS) == 0) && (progress != last_progress))
+		{
+			if (progress_total != 0UI64)
+				printf("%llu of %llu (%d%%)\n", progress, progress_total, (int)((100 * progress) / progress_total));
+			else
+				printf("%llu\n", progress);
+			last_progress = progress;
+		}
+	}
+
+	worker.join();
+
+	if (app_job->cancel)
+	{
+		printf("*** Cancelled\n");
+		return false;
+	}
+
+	return true;
+}
+
+/******************************************************************************
+** Function:	Paint antplot display to screen
+**
+** Notes:
+*/
+void APP_paint(void)
+{
+	PAINTSTRUCT ps;
+	HDC hdc;
+
+	hdc = BeginPaint(APP_hWnd, &ps);
+
+	StretchBlt(hdc, 0, 0, APP_SCREEN_WIDTH, APP_SCREEN_HEIGHT, APP_hdc, 0, 0,
+		APP_SCREEN_WIDTH / (1 << app_zoom_level), APP_SCREEN_HEIGHT / (1 << app_zoom_level), SRCCOPY);
+
+	EndPaint(APP_hWnd, &ps);
+}
+
+/******************************************************************************
+** Function:	Set pixel in the walker's bitmap
+**
+** Notes:		Clips to the bitmap, as SetPixel did
+*/
+void app_set_pixel(app_walker_type* w, int x, int y, uint32 colour)
+{
+	if (((unsigned)x < APP_SCREEN_WIDTH) && ((unsigned)y < APP_SCREEN_HEIGHT))
+		w->pixels[y * APP_SCREEN_WIDTH + x] = colour;
+}
+
+/******************************************************************************
+** Function:	Start a walk into a bitmap laid out as APP_pixels: clear it
+**				and place the ant
+**
+** Notes:		For plots made ahead, off screen, by job
+*/
+void app_walker_start(app_walker_type* w, uint32* pixels, CALC_job_type* job)
+{
+	for (int i = 0; i < APP_SCREEN_WIDTH * APP_SCREEN_HEIGHT; i++)
+		pixels[i] = APP_COLOUR_BACKGROUND;
+
+	w->pixels = pixels;
+	w->job = job;
+	w->on_screen = false;
+
+	// Set initial position: use centre of screen
+	w->ant.pos_x = APP_SCREEN_WIDTH / (1 << (app_zoom_level + 1));
+	w->ant.pos_y = APP_SCREEN_HEIGHT / (1 << (app_zoom_level + 1));
+
+	// Set initial direction: 0 = (-1, 0), 1 = (0, 1), 2 = (1, 0), 3 = (0, -1)
+	w->ant.dir_x = (~app_direction & 0x01) * (app_direction - 1);
+	w->ant.dir_y = (app_direction & 0x01) * ((app_direction ^ 0x03) - 1);
+	//printf("\nInitial direction: %d, %d\n\n", w->ant.dir_x, w->ant.dir_y);
+
+	w->started = false;
+	w->step = 0;
+}
+
+/******************************************************************************
+** Function:	Start a walk: clear the plot bitmap and place the ant
+**
+** Notes:
+*/
+void app_walker_begin(app_walker_type* w)
+{
+	GdiFlush();									// finish this thread's GDI drawing before direct access
+	app_walker_start(w, APP_pixels, app_job);
+	w->on_screen = true;
+
+	ANIM_begin(APP_pixels, APP_SCREEN_WIDTH,
+		APP_SCREEN_WIDTH / (1 << app_zoom_level), APP_SCREEN_HEIGHT / (1 << app_zoom_level));
+}
+
+/******************************************************************************
+** Function:	Walk the ant over the n_bits MS bits of c, MS bit first
+**
+** Notes:		Leading zeroes are suppressed, however many words they span.
+**				The bits of c below the n_bits must be zero.
+**				Returns false if w->job is cancelled.
+*/
+bool app_walker_bits(app_walker_type* w, uint64 c, int n_bits)
+{
+	uint64 m = 1UI64 << 63;
+	uint64 end = (n_bits < 64) ? m >> n_bits : 0UI64;
+
+	if (!w->started)
+	{
+		if (c == 0UI64)
+			return !w->job->cancel;
+
+		while ((c & m) == 0UI64)				// find first non-zero bit
+			m >>= 1;
+		w->started = true;
+	}
+
+	for (; m != end; m >>= 1)
+	{
+		bool bit = ((c & m) != 0UI64);
+
+		app_set_pixel(w, w->ant.pos_x, w->ant.pos_y, bit ? APP_COLOUR_BLACK : APP_COLOUR_WHITE);
+		CALC_ant_step(&w->ant, bit);
+
+		if (!w->on_screen)
+			continue;
+
+		ANIM_step(++w->step);
+
+		if (app_animate)
+		{
+			ShowWindow(APP_hWnd, SW_SHOWNORMAL);
+			InvalidateRect(APP_hWnd, NULL, TRUE);
+			UpdateWindow(APP_hWnd);
+
+			printf("** Step %u. Next step or 'a' >>\n", w->step);
+			if (app_wait_for_keypress() == 'a')
+			{
+				app_animate = false;
+				printf("\n*** Animate mode OFF\n");
+			}
+		}
+	}
+
+	return !w->job->cancel;
+}
+
+/******************************************************************************
+** Function:	Walk the ant over the next word of a value, MS bit first
+**
+** Notes:		As app_walker_bits
+*/
+bool app_walker_word(app_walker_type* w, uint64 c)
+{
+	return app_walker_bits(w, c, 64);
+}
+
+/******************************************************************************
+** Function:	Walk the ant over the next words of a stream, MS word first
+**
+** Notes:		As app_walker_word
+*/
+bool app_walker_feed(app_walker_type* w, const uint64* v, int length_words)
+{
+	for (int i = 0; i < length_words; i++)
+	{
+		if (!app_walker_word(w, v[i]))
+			return false;
+	}
+
+	return true;
+}
+
+/******************************************************************************
+** Function:	Finish a walk
+**
+** Notes:
+*/
+void app_walker_end(app_walker_type* w)
+{
+	TRACE_COUNT(TRACE_COUNTER_PIXELS, w->step);
+	ANIM_end();
+}
+
+/******************************************************************************
+** Function:	Walk the ant over app_walk_view, drawing into the plot bitmap
+**
+** Notes:		Runs on the worker thread unless animating step by step.
+**				Stops early if app_job is cancelled.
+*/
+void app_walk(void)
+{
+	app_walker_type walker;
+
+	app_walker_begin(&walker);
+	{
+		TRACE_SPAN("plot walk");
+		for (int k = 0; k < app_walk_view.length_words; k++)
+		{
+			if (!app_walker_word(&walker, app_walk_view.word(k)))
+				break;
+		}
+	}
+	app_walker_end(&walker);
+}
+
+/******************************************************************************
+** Function:	Walk the ant over v into pixels, a bitmap laid out as APP_pixels
+**
+** Notes:		On this thread & off screen, for timing the walk alone:
+**				app_plot adds a worker thread & the window
+*/
+void app_walk_off_screen(ALU_view_type v, uint32* pixels, CALC_job_type* job)
+{
+	app_walker_type walker;
+
+	app_walker_start(&walker, pixels, job);
+	for (int k = 0; k < v.length_words; k++)
+	{
+		if (!app_walker_word(&walker, v.word(k)))
+			break;
+	}
+}
+
+/******************************************************************************
+** Function:	Generate a value & plot it at the same time
+**
+** Notes:		p_generator runs on its own thread, and must stream each word of
+**				its value to app_job->alu.p_output as soon as it is final.
+**				This thread walks the words as they arrive through app_ring,
+**				so the plot takes about as long as the slower of the two.
+*/
+void app_pipeline(ptr_to_function p_generator)
+{
+	app_walker_type walker;
+	uint64 block[RING_BLOCK_U64];
+	int n;
+
+	app_ring.reset();
+	app_job->alu.p_output = &app_ring;
+	std::thread generator([p_generator] { p_generator(); app_ring.close(); });
+
+	app_walker_begin(&walker);
+	{
+		TRACE_SPAN("plot walk (streamed)");
+		while ((n = app_ring.pop(block, RING_BLOCK_U64, &app_job->cancel)) > 0)
+		{
+			if (!app_walker_feed(&walker, block, n))
+				break;
+		}
+	}
+	app_walker_end(&walker);
+
+	generator.join();
+	app_job->alu.p_output = NULL;
+}
+
+/******************************************************************************
+** Function:	Bring the finished plot to the front
+**
+** Notes:		Pause after plot if prompt != NULL
+*/
+void app_show_plot(const char* prompt, bool wait)
+{
+	ShowWindow(APP_hWnd, SW_SHOWNORMAL);
+	BringWindowToTop(APP_hWnd);
+	InvalidateRect(APP_hWnd, NULL, TRUE);
+	UpdateWindow(APP_hWnd);
+
+	if (prompt != NULL)
+		printf("\n%s\n\n", prompt);
+
+	if (wait)
+	{
+		printf("Press any key to continue >>> ");
+		app_wait_for_keypress();
+	}
+}
+
+//*****************************************************************************
+// Function:	Plot a value, MS word first
+//
+// Notes: Provide a view of the register data, e.g. ALU_view_top for its MS words
+// Pause after plot if prompt != NULL
+// The walk is shown progressively, and can be cancelled with a keypress
+//
+void app_plot(ALU_view_type v, const char* prompt, bool wait)
+{
+	app_walk_view = v;
+
+	ShowWindow(APP_hWnd, SW_SHOWNORMAL);
+	if (app_animate)
+	{
+		app_job->cancel = false;
+		app_walk();
+	}
+	else
+		app_background(app_walk, true);
+
+	app_show_plot(prompt, wait);
+}
+
+/******************************************************************************
+** Function:	Is entry e plot n of the mode, as it would be drawn now?
+**
+** Notes:		The mode being plotted, which f can make differ from app_mode
+*/
+bool app_speculation_matches(const app_speculation_type* e, int mode, uint64 n)
+{
+	return (e->mode == mode) && (e->n == n) && (e->direction == app_direction) && (e->zoom_level == app_zoom_level) &&
+		((mode != APP_MODE_SEQUENCE + SEQ_POWER) || (e->base == app_sequence_base));
+}
+
+/******************************************************************************
+** Function:	Make the plots in app_speculate_order, first first
+**
+** Notes:		Runs on its own thread with app_speculate_job, while the user
+**				looks at the plot on screen. Stops when the job is cancelled,
+**				or after the plot being made when asked to finish.
+*/
+void app_speculate(void)
+{
+	CALC_job_type* job = app_speculate_job;
+
+	for (int k = 0; (k < app_n_speculate) && !app_speculate_finish; k++)
+	{
+		app_speculation_type* e = &app_speculations[app_speculate_order[k]];
+		bool ok = true;
+
+		app_speculate_slot = app_speculate_order[k];
+		switch (e->mode)
+		{
+		case APP_MODE_RECIPROCAL:
+			CALC_reciprocal(job, e->n);
+			memcpy(e->value, job->hl, sizeof(e->value));
+			break;
+
+		case APP_MODE_FACTORIAL:
+			ok = CALC_factorial(job, e->n);
+			memcpy(e->value, job->f_reg, sizeof(e->value));
+			break;
+
+		default:
+			SEQ_set(&app_speculate_sequence, e->mode - APP_MODE_SEQUENCE, e->base);
+			ok = SEQ_term(&app_speculate_sequence, job, e->n);
+			memcpy(e->value, app_speculate_sequence.value, sizeof(e->value));
+			memcpy(e->next, app_speculate_sequence.next, sizeof(e->next));
+			e->n_words = app_speculate_sequence.n_words;
+			e->prime = app_speculate_sequence.prime;
+			break;
+		}
+
+		if (ok && !job->cancel)
+		{
+			app_walker_type walker;
+			ALU_view_type v = ALU_view(e->value, SEQ_WORDS);
+
+			TRACE_SPAN("plot walk (ahead)");
+			app_walker_start(&walker, e->pixels.data(), job);
+			for (int i = 0; i < v.length_words; i++)
+			{
+				if (!app_walker_word(&walker, v.word(i)))
+					break;
+			}
+		}
+
+		e->ready = ok && !job->cancel;
+		app_speculate_slot = -1;
+		if (job->cancel)
+			break;
+	}
+}
+
+/******************************************************************************
+** Function:	Stop making plots ahead, but finish plot n of the mode
+**				first if it's the one being made
+**
+** Notes:		So n & b can show it. Plots already made are kept.
+*/
+void app_speculate_wait(int mode, uint64 n)
+{
+	if (!app_speculator.joinable())
+		return;
+
+	app_speculate_finish = true;			// then no plot is started after this one
+	int slot = app_speculate_slot;
+	if ((slot < 0) || !app_speculation_matches(&app_speculations[slot], mode, n))
+		app_speculate_job->cancel = true;
+
+	app_speculator.join();
+}
+
+/******************************************************************************
+** Function:	Stop making plots ahead
+**
+** Notes:		Also called at exit, as a running thread can't be destroyed
+*/
+void app_speculate_cancel(void)
+{
+	if (!app_speculator.joinable())
+		return;
+
+	app_speculate_finish = true;
+	app_speculate_job->cancel = true;
+	app_speculator.join();
+}
+
+/******************************************************************************
+** Function:	Start making the plots n & b would show next
+**
+** Notes:		n + 1, n + 2 & n - 2 for the value n on screen, in the
+**				background; plots already made are kept. Not while animating
+**				or exporting frames, which need the plots walked step by step.
+*/
+void app_speculate_start(void)
+{
+	uint64 n = (app_mode == APP_MODE_RECIPROCAL) ? app_reciprocal_int :
+		(app_mode == APP_MODE_FACTORIAL) ? app_factorial_int : app_sequence_int;
+	uint64 targets[APP_SPECULATE_TARGETS] = { n + 1, n + 2, (n < 3) ? 0UI64 : n - 2 };
+	int slots[APP_SPECULATE_TARGETS];
+	bool used[APP_SPECULATE_ENTRIES] = {};
+
+	app_speculate_cancel();
+	if (app_animate || ANIM_enabled())
+		return;
+
+	for (int t = 0; t < APP_SPECULATE_TARGETS; t++)
+	{
+		slots[t] = -1;
+		for (int i = 0; i < APP_SPECULATE_ENTRIES; i++)
+		{
+			if (app_speculations[i].ready && app_speculation_matches(&app_speculations[i], app_mode, targets[t]))
+				slots[t] = i;
+		}
+		if (slots[t] >= 0)
+			used[slots[t]] = true;
+	}
+
+	// The rest go in entries not kept:
+	app_n_speculate = 0;
+	for (int t = 0; t < APP_SPECULATE_TARGETS; t++)
+	{
+		if (slots[t] >= 0)
+			continue;
+
+		int i = 0;
+		while (used[i])
+			i++;
+		used[i] = true;
+
+		app_speculation_type* e = &app_speculations[i];
+		e->mode = app_mode;
+		e->n = targets[t];
+		e->base = app_sequence_base;
+		e->direction = app_direction;
+		e->zoom_level = app_zoom_level;
+		e->ready = false;
+		e->pixels.resize(APP_SCREEN_WIDTH * APP_SCREEN_HEIGHT);
+		app_speculate_order[app_n_speculate++] = i;
+	}
+
+	if (app_n_speculate == 0)
+		return;
+
+	// Carry on from the value on screen:
+	if ((app_mode == APP_MODE_FACTORIAL) && app_job->f_valid)
+	{
+		memcpy(app_speculate_job->f_reg, app_job->f_reg, sizeof(app_job->f_reg));
+		app_speculate_job->f_n = app_job->f_n;
+		app_speculate_job->f_valid = true;
+	}
+	else if (app_mode >= APP_MODE_SEQUENCE)
+		app_speculate_sequence = app_sequence;
+
+	app_speculate_job->cancel = false;
+	app_speculate_finish = false;
+	app_speculate_slot = -1;
+	app_speculator = std::thread(app_speculate);
+}
+
+/******************************************************************************
+** Function:	Show plot n of the mode, if it was made ahead
+**
+** Notes:		Puts its value in the registers the mode prints & carries on
+**				from, & its bitmap on screen. Returns false if it wasn't made.
+*/
+bool app_speculated(int mode, uint64 n)
+{
+	app_speculation_type* e = NULL;
+
+	if (app_animate || ANIM_enabled())
+		return false;
+
+	app_speculate_wait(mode, n);
+	for (int i = 0; i < APP_SPECULATE_ENTRIES; i++)
+	{
+		if (app_speculations[i].ready && app_speculation_matches(&app_speculations[i], mode, n))
+			e = &app_speculations[i];
+	}
+
+	if (e == NULL)
+		return false;
+
+	switch (mode)
+	{
+	case APP_MODE_RECIPROCAL:
+		memcpy(app_job->hl, e->value, sizeof(app_job->hl));
+		break;
+
+	case APP_MODE_FACTORIAL:
+		memcpy(app_job->f_reg, e->value, sizeof(app_job->f_reg));
+		app_job->f_n = n;
+		app_job->f_valid = true;
+		break;
+
+	default:
+		SEQ_set(&app_sequence, mode - APP_MODE_SEQUENCE, e->base);
+		memcpy(app_sequence.value, e->value, sizeof(e->value));
+		memcpy(app_sequence.next, e->next, sizeof(e->next));
+		app_sequence.n = n;
+		app_sequence.n_words = e->n_words;
+		app_sequence.prime = e->prime;
+		app_sequence.valid = true;
+		break;
+	}
+
+	GdiFlush();
+	memcpy(APP_pixels, e->pixels.data(), APP_SCREEN_WIDTH * APP_SCREEN_HEIGHT * sizeof(uint32));
+	return true;
+}
+
+/******************************************************************************
+** Function:	Plot reciprocal of a 64-bit integer value
+**
+** Notes:		Unless animating, the plot is drawn while the value is computed,
+**				or shown at once if it was made ahead
+*/
+void app_plot_reciprocal(uint64 v)
+{
+	app_walk_reciprocal = v;
+	if (app_animate)
+		CALC_reciprocal(app_job, v);
+	else if (!app_speculated(APP_MODE_RECIPROCAL, v))
+	{
+		ShowWindow(APP_hWnd, SW_SHOWNORMAL);
+		if (!app_background([] { app_pipeline([] { CALC_reciprocal(app_job, app_walk_reciprocal); }); }, true))
+			return;
+	}
+
+	printf("\n1 / %I64d (first 1024 hex digits):\n", v);
+	ALU.col = 0;
+	ALU.print_hex(ALU_view(app_job->hl, 2 * ALU_LENGTH_U64), 512, false);
+	printf("\n\n");
+
+	// Print value, and lowest integer which would give the identical pattern:
+	printf("\n1 / %I64d ", v);
+	int power;
+	for (power = 0; power < 64; power++)
+	{
+		if ((v & 1UI64) != 0UI64)
+			break;
+		v >>= 1;
+	}
+	if (power > 0)
+		printf(" (= 1 / (%llu * 2^%d))", v, power);
+	printf(":\n");
+
+	if (app_animate)
+		app_plot(ALU_view(app_job->hl, 2 * ALU_LENGTH_U64), NULL, false);
+	else
+		app_show_plot(NULL, false);
+}
+
+/******************************************************************************
+** Function:	Screen move for a move in the axes of a CYCLE_motion_type
+**
+** Notes:		The axes are set by the heading of the walk at start
+*/
+void app_cycle_axes(const CALC_ant_type* start, int64 x, int64 y, int64* p_x, int64* p_y)
+{
+	*p_x = x * start->dir_x - y * start->dir_y;
+	*p_y = x * start->dir_y + y * start->dir_x;
+}
+
+/******************************************************************************
+** Function:	Screen box of the cells a period of app_cycle visits, when
+**				motion s from start brings the ant to its first cell
+**
+** Notes:		box is min x, min y, max x, max y
+*/
+void app_cycle_box(const CALC_ant_type* start, const CYCLE_motion_type* s, int64* box)
+{
+	box[0] = box[1] = INT64_MAX;
+	box[2] = box[3] = INT64_MIN;
+
+	for (int i = 0; i < 4; i++)
+	{
+		int64 x = ((i & 1) != 0) ? app_cycle.max_x : app_cycle.min_x;
+		int64 y = ((i & 2) != 0) ? app_cycle.max_y : app_cycle.min_y;
+		CYCLE_turn(s->turns, &x, &y);
+		app_cycle_axes(start, s->x + x, s->y + y, &x, &y);
+		x += start->pos_x;
+		y += start->pos_y;
+
+		box[0] = (x < box[0]) ? x : box[0];
+		box[1] = (y < box[1]) ? y : box[1];
+		box[2] = (x > box[2]) ? x : box[2];
+		box[3] = (y > box[3]) ? y : box[3];
+	}
+}
+
+/******************************************************************************
+** Function:	a / b rounded down, for b > 0
+**
+** Notes:
+*/
+int64 app_floor_div(int64 a, int64 b)
+{
+	return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+/******************************************************************************
+** Function:	Narrow [*p_j0, *p_j1] to the j for which [lo, hi] + j * d
+**				meets [0, limit]
+**
+** Notes:		Leaves *p_j0 > *p_j1 if there are none
+*/
+void app_cycle_range(int64 lo, int64 hi, int64 d, int64 limit, int64* p_j0, int64* p_j1)
+{
+	int64 j0, j1;
+
+	if (d == 0)
+	{
+		if ((hi >= 0) && (lo <= limit))
+			return;
+		j0 = 1;
+		j1 = 0;
+	}
+	else if (d > 0)
+	{
+		j0 = -app_floor_div(hi, d);								// hi + j * d >= 0
+		j1 = app_floor_div(limit - lo, d);						// lo + j * d <= limit
+	}
+	else
+	{
+		j0 = -app_floor_div(limit - lo, -d);
+		j1 = app_floor_div(hi, -d);
+	}
+
+	*p_j0 = (j0 > *p_j0) ? j0 : *p_j0;
+	*p_j1 = (j1 < *p_j1) ? j1 : *p_j1;
+}
+
+/******************************************************************************
+** Function:	Walk 1 / app_cycle_v for app_cycle_periods periods, drawing
+**				into the plot bitmap
+**
+** Notes:		Draws the first word, then only the periods which leave cells
+**				on screen, each from the motion of the periods before it. If
+**				the path closes after k periods, the last k periods colour
+**				every cell it visits last, so they are all that are drawn;
+**				otherwise each period moves the same way, & the periods on
+**				screen are a range found by division. So the walk takes about
+**				the same time however many periods there are.
+*/
+void app_walk_cycle(void)
+{
+	app_walker_type walker;
+	CALC_ant_type start;
+	CYCLE_motion_type m, s;
+	int64 box[4];
+	uint64 remainder = 1UI64;
+	int64 j0 = 0;
+	int64 j1 = (int64)app_cycle_periods - 1;
+
+	app_walker_begin(&walker);
+	start = app_cycle_start = walker.ant;
+
+	TRACE_SPAN("cycle walk");
+	app_walker_word(&walker, CYCLE_reciprocal_word(app_cycle.v, &remainder));
+
+	uint64 loop = CYCLE_loop_periods(&app_cycle.period);
+	if (loop != 0UI64)
+	{
+		if (app_cycle_periods > loop)
+			j0 = (int64)(app_cycle_periods - loop);
+	}
+	else
+	{
+		// Period j is period 0 moved j times by the screen move of a period:
+		int64 dx = app_cycle.period.x;
+		int64 dy = app_cycle.period.y;
+		CYCLE_turn(app_cycle.first.turns, &dx, &dy);
+		app_cycle_axes(&start, dx, dy, &dx, &dy);
+
+		app_cycle_box(&start, &app_cycle.first, box);
+		app_cycle_range(box[0], box[2], dx, APP_SCREEN_WIDTH - 1, &j0, &j1);
+		app_cycle_range(box[1], box[3], dy, APP_SCREEN_HEIGHT - 1, &j0, &j1);
+	}
+
+	for (int64 j = j0; (j <= j1) && !app_job->cancel; j++)
+	{
+		CYCLE_power(&m, &app_cycle.period, (uint64)j);
+		CYCLE_then(&s, &app_cycle.first, &m);
+
+		app_cycle_box(&start, &s, box);
+		if ((box[2] < 0) || (box[0] >= APP_SCREEN_WIDTH) || (box[3] < 0) || (box[1] >= APP_SCREEN_HEIGHT))
+			continue;
+
+		int64 x, y;
+		app_cycle_axes(&start, s.x, s.y, &x, &y);
+		walker.ant.pos_x = start.pos_x + (int)x;
+		walker.ant.pos_y = start.pos_y + (int)y;
+		x = 1;
+		y = 0;
+		CYCLE_turn(s.turns, &x, &y);
+		app_cycle_axes(&start, x, y, &x, &y);
+		walker.ant.dir_x = (int)x;
+		walker.ant.dir_y = (int)y;
+
+		remainder = app_cycle.period_remainder;
+		for (uint64 k = 0; k < app_cycle.period_words; k++)
+		{
+			if (!app_walker_word(&walker, CYCLE_reciprocal_word(app_cycle.v, &remainder)))
+				break;
+		}
+	}
+
+	app_walker_end(&walker);
+}
+
+/******************************************************************************
+** Function:	Plot & report 1 / v over any number of periods
+**
+** Notes:		The plot of 'v' stops at 2 * ALU_LENGTH_U64 words; this one
+**				goes on for as many periods as asked, e.g. 10^12, at the cost
+**				of one period to find the motion & a few more to draw.
+*/
+void app_plot_cycle(void)
+{
+	printf("\n1 / v for v (0 for %llu): ", app_reciprocal_int);
+	scanf("%" SCNu64, &app_cycle_v);
+	if (app_cycle_v == 0UI64)
+		app_cycle_v = app_reciprocal_int;
+	if (app_cycle_v < 2UI64)
+	{
+		printf("\n*** v must be 2 or more\n");
+		return;
+	}
+
+	printf("Periods to walk after the first word (0 for %llu): ", APP_CYCLE_PERIODS);
+	scanf("%" SCNu64, &app_cycle_periods);
+	if (app_cycle_periods == 0UI64)
+		app_cycle_periods = APP_CYCLE_PERIODS;
+	if (app_cycle_periods > APP_CYCLE_MAX_MOVE)
+		app_cycle_periods = APP_CYCLE_MAX_MOVE;
+
+	if (!app_background([] { CYCLE_reciprocal(&app_cycle, app_cycle_v, &app_job->progress, &app_job->cancel); }, false))
+		return;
+	if (app_cycle.period_words == 0UI64)
+	{
+		printf("\n*** The period of 1 / %llu is over %d words\n", app_cycle_v, CYCLE_MAX_PERIOD_WORDS);
+		return;
+	}
+
+	ShowWindow(APP_hWnd, SW_SHOWNORMAL);
+	if (app_animate)
+	{
+		app_job->cancel = false;
+		app_walk_cycle();
+	}
+	else
+		app_background(app_walk_cycle, true);
+
+	// Report the motion of a period, on screen from the start of the first:
+	const CALC_ant_type* start = &app_cycle_start;
+	int64 dx = app_cycle.period.x;
+	int64 dy = app_cycle.period.y;
+	CYCLE_turn(app_cycle.first.turns, &dx, &dy);
+	app_cycle_axes(start, dx, dy, &dx, &dy);
+
+	printf("\n1 / %llu repeats every %llu words (%llu bits) after its first word.\n",
+		app_cycle_v, app_cycle.period_words, 64 * app_cycle.period_words);
+	printf("Each period turns the ant %d quarter turns, the way a 1 bit turns it; the first moves it (%lld, %lld).\n",
+		app_cycle.period.turns, dx, dy);
+
+	uint64 loop = CYCLE_loop_periods(&app_cycle.period);
+	if (loop != 0UI64)
+		printf("The path closes after %llu periods & retraces itself from then on.\n", loop);
+	else
+		printf("The path never closes: it builds a highway, moving (%lld, %lld) every period.\n", dx, dy);
+
+	// Where the ant ends up; the move only grows without a loop:
+	uint64 move = (uint64)((app_cycle.period.x < 0) ? -app_cycle.period.x : app_cycle.period.x) +
+		(uint64)((app_cycle.period.y < 0) ? -app_cycle.period.y : app_cycle.period.y);
+	if ((loop == 0UI64) && (app_cycle_periods > APP_CYCLE_MAX_MOVE / move))
+		printf("After %llu periods the ant is more than 2^62 cells away.\n", app_cycle_periods);
+	else
+	{
+		CYCLE_motion_type m, s;
+		CYCLE_power(&m, &app_cycle.period, app_cycle_periods);
+		CYCLE_then(&s, &app_cycle.first, &m);
+
+		int64 x, y, hx = 1, hy = 0;
+		app_cycle_axes(start, s.x, s.y, &x, &y);
+		CYCLE_turn(s.turns, &hx, &hy);
+		app_cycle_axes(start, hx, hy, &hx, &hy);
+		printf("After %llu periods (%.6g steps) the ant is at (%lld, %lld) from its start, heading (%lld, %lld).\n",
+			app_cycle_periods, app_cycle.first_bits + 64.0 * app_cycle.period_words * app_cycle_periods, x, y, hx, hy);
+	}
+
+	app_show_plot(NULL, false);
+}
+
+/******************************************************************************
+** Function:	Walk the ant over app_file, drawing into the plot bitmap
+**
+** Notes:		As app_pipeline, with the file streamed on its own thread; the
+**				last word may be padded, so only its bits from the file are
+**				walked.
+*/
+void app_walk_file(void)
+{
+	app_walker_type walker;
+	uint64 block[RING_BLOCK_U64];
+	uint64 n_words = 0UI64;
+	int n;
+
+	app_job->progress_total = app_file.size;
+	app_ring.reset();
+	std::thread generator([] { app_file_ok = FILEMAP_stream(&app_file, &app_ring, &app_job->progress, &app_job->cancel); app_ring.close(); });
+
+	app_walker_begin(&walker);
+	{
+		TRACE_SPAN("plot walk (file)");
+		while ((n = app_ring.pop(block, RING_BLOCK_U64, &app_job->cancel)) > 0)
+		{
+			n_words += n;
+			if (n_words == app_file.n_words)
+			{
+				if (app_walker_feed(&walker, block, n - 1))
+					app_walker_bits(&walker, block[n - 1], app_file.tail_bits);
+				break;
+			}
+
+			if (!app_walker_feed(&walker, block, n))
+				break;
+		}
+	}
+	app_walker_end(&walker);
+
+	generator.join();
+}
+
+/******************************************************************************
+** Function:	Plot any file as a bit string
+**
+** Notes:		Memory use doesn't grow with the file, so files of many
+**				gigabytes can be plotted; the walk takes 8 steps a byte.
+*/
+void app_plot_file(void)
+{
+	static char filename[MAX_PATH];
+	FILEMAP_order_type order;
+	char c;
+
+	printf("\nFile to plot: ");
+	scanf(" %259[^\n]", filename);								// width is MAX_PATH - 1
+
+	printf("Bits of each byte MS bit first or LS bit first (m / l): ");
+	scanf(" %c", &c);
+	order.lsb_first = ((c | 0x20) == 'l');
+
+	printf("Word size in bytes (1, 2, 4 or 8): ");
+	scanf("%d", &order.word_bytes);
+	if ((order.word_bytes != 1) && (order.word_bytes != 2) && (order.word_bytes != 4) && (order.word_bytes != 8))
+		order.word_bytes = 1;
+
+	order.little_endian = false;
+	if (order.word_bytes > 1)
+	{
+		printf("Bytes of each word big-endian, as stored, or little-endian (b / l): ");
+		scanf(" %c", &c);
+		order.little_endian = ((c | 0x20) == 'l');
+	}
+
+	printf("Words from the start or the end of the file (s / e): ");
+	scanf(" %c", &c);
+	order.reverse = ((c | 0x20) == 'e');
+
+	if (!FILEMAP_open(&app_file, filename, &order))
+	{
+		printf("\n*** Can't open %s, or it is empty\n", filename);
+		return;
+	}
+
+	printf("\n%s: %llu bytes, %s bit first, %d-byte %s-endian words, from the %s\n", filename, app_file.size,
+		order.lsb_first ? "LS" : "MS", order.word_bytes, order.little_endian ? "little" : "big", order.reverse ? "end" : "start");
+
+	auto t0 = std::chrono::steady_clock::now();
+	ShowWindow(APP_hWnd, SW_SHOWNORMAL);
+	if (app_animate)
+	{
+		app_job->cancel = false;
+		app_walk_file();
+	}
+	else
+		app_background(app_walk_file, true);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+	if (!app_file_ok)
+		printf("\n*** Couldn't map all of %s\n", filename);
+	else if (!app_job->cancel)
+		printf("%.3f s, %.1f MB per second\n", seconds, app_file.size / (seconds * 1e6));
+	FILEMAP_close(&app_file);
+
+	app_show_plot(NULL, false);
+}
+
+/******************************************************************************
+** Function:	Serve antplots to other tools until a key is pressed
+**
+** Notes:		Only connections from this machine are accepted
+*/
+void app_serve(void)
+{
+	char text[1024];
+
+	printf("\nPort to serve antplots on (0 for %d): ", SERVE_DEFAULT_PORT);
+	scanf("%d", &app_serve_port);
+	if ((app_serve_port <= 0) || (app_serve_port > 65535))
+		app_serve_port = SERVE_DEFAULT_PORT;
+
+	printf("\nServing on %d threads; press any key to stop. Try\n", POOL_threads());
+	printf("    http://127.0.0.1:%d/plot?mode=reciprocal&value=113&dir=0&size=512&format=bmp\n", app_serve_port);
+	printf("    http://127.0.0.1:%d/plot?mode=factorial&from=100&to=115&size=256&format=pgm\n", app_serve_port);
+	printf("    http://127.0.0.1:%d/stats\n", app_serve_port);
+	printf("Connections so far:\n");
+
+	app_serve_ok = true;
+	app_background([] { app_serve_ok = SERVE_run(app_serve_port, &app_job->progress, &app_job->cancel); }, false);
+	if (!app_serve_ok)
+	{
+		printf("\n*** Can't listen on port %d\n", app_serve_port);
+		return;
+	}
+
+	SERVE_stats_text(text, sizeof(text));
+	printf("\n%s", text);
+}
+
+/******************************************************************************
+** Function:	Read a big integer from the console into r
+**
+** Notes:		Returns false if it isn't a valid value
+*/
+bool app_read_integer(const char* name, ALU_reg r)
+{
+	static char text[APP_MAX_INTEGER_TEXT + 1];
+
+	printf("\n%s (decimal, 0x hex, or A or B from 'c' or 'u'): ", name);
+	scanf("%40000s", text);								// width is APP_MAX_INTEGER_TEXT
+
+	if (((text[0] | 0x20) == 'a') && (text[1] == '\0'))
+		ALU.mov(r, app_job->a);
+	else if (((text[0] | 0x20) == 'b') && (text[1] == '\0'))
+		ALU.mov(r, app_job->r2);
+	else if (!ALU.from_text(r, text))
+	{
+		printf("*** Not a number, or too big\n");
+		return false;
+	}
+
+	return true;
+}
+
+/******************************************************************************
+** Function:	Plot a / b for big integers a & b
+**
+** Notes:		The expansion is streamed to the plot, so it can be any length.
+**				Only the first 2 * ALU_LENGTH_U64 words are kept for printing,
+**				and for animation, which plots from the register.
+*/
+void app_plot_rational(void)
+{
+	if (!app_read_integer("Numerator a", app_job->num) || !app_read_integer("Denominator b", app_job->den))
+		return;
+
+	printf("\nWords after the binary point (0 for %d): ", ALU_LENGTH_U64);
+	scanf("%" SCNu64, &app_rational_words);
+	if (app_rational_words == 0UI64)
+		app_rational_words = ALU_LENGTH_U64;
+
+	if (app_animate && (app_rational_words > ALU_LENGTH_U64))
+	{
+		app_rational_words = ALU_LENGTH_U64;
+		printf("*** Limited to %d words while animating\n", ALU_LENGTH_U64);
+	}
+
+	ShowWindow(APP_hWnd, SW_SHOWNORMAL);
+	bool completed;
+	if (app_animate)
+		completed = app_background([] { app_rational_ok = CALC_rational(app_job, app_rational_words); }, false);
+	else
+		completed = app_background([] { app_pipeline([] { app_rational_ok = CALC_rational(app_job, app_rational_words); }); }, true);
+	if (!completed)
+		return;
+
+	if (!app_rational_ok)
+	{
+		printf("\n*** Denominator is zero\n");
+		return;
+	}
+
+	printf("\na / b, integer part:\n");
+	ALU.col = 0;
+	ALU.print_hex(ALU_view(&app_job->hl[ALU_LENGTH_U64], ALU_LENGTH_U64), ALU_LENGTH_BYTES, true);
+	printf("a / b, first 1024 hex digits after the point:\n");
+	ALU.print_hex(ALU_view(app_job->hl, ALU_LENGTH_U64), 512, false);
+
+	if (app_animate)
+		app_plot(ALU_view_top(app_job->hl, 2 * ALU_LENGTH_U64, ALU_LENGTH_U64 + (int)app_rational_words), "Plotting a / b", false);
+	else
+		app_show_plot("Plotting a / b", false);
+}
+
+/******************************************************************************
+** Function:	Plot 1 / v from any bit k after the point, for a big integer v
+**
+** Notes:		The bits before k aren't calculated, so k can be as large as
+**				2^64 - 1. Streamed as app_plot_rational, with the window in
+**				place of the fraction.
+*/
+void app_plot_window(void)
+{
+	if (!app_read_integer("Denominator v", app_job->den))
+		return;
+
+	printf("First bit after the point, k: ");
+	scanf("%" SCNu64, &app_window_k);
+
+	printf("Words from bit k (0 for %d): ", ALU_LENGTH_U64);
+	scanf("%" SCNu64, &app_rational_words);
+	if (app_rational_words == 0UI64)
+		app_rational_words = ALU_LENGTH_U64;
+
+	if (app_animate && (app_rational_words > ALU_LENGTH_U64))
+	{
+		app_rational_words = ALU_LENGTH_U64;
+		printf("*** Limited to %d words while animating\n", ALU_LENGTH_U64);
+	}
+
+	ShowWindow(APP_hWnd, SW_SHOWNORMAL);
+	bool completed;
+	if (app_animate)
+		completed = app_background([] { app_rational_ok = CALC_reciprocal_window(app_job, app_window_k, app_rational_words); }, false);
+	else
+		completed = app_background([] { app_pipeline([] { app_rational_ok = CALC_reciprocal_window(app_job, app_window_k, app_rational_words); }); }, true);
+	if (!completed)
+		return;
+
+	if (!app_rational_ok)
+	{
+		printf("\n*** v is zero, or over %d words once its factors of 2 are taken out\n", CALC_WINDOW_MAX_WORDS);
+		return;
+	}
+
+	printf("\n1 / v from bit %llu, first 1024 hex digits:\n", app_window_k);
+	ALU.col = 0;
+	ALU.print_hex(ALU_view(app_job->hl, ALU_LENGTH_U64), 512, false);
+
+	if (app_animate)
+		app_plot(ALU_view_top(app_job->hl, 2 * ALU_LENGTH_U64, ALU_LENGTH_U64 + (int)app_rational_words), "Plotting 1 / v from bit k", false);
+	else
+		app_show_plot("Plotting 1 / v from bit k", false);
+}
+
+/******************************************************************************
+** Function:	Calculate & plot a k-th root of n, or a root of a polynomial
+**
+** Notes:		k-th roots are the positive root of x^k - n
+*/
+void app_calc_root(void)
+{
+	int k;
+	uint64 n;
+
+	printf("\nEnter k (2..%d) for the k-th root of n, or 0 for a root of a polynomial: ", CALC_MAX_DEGREE);
+	scanf("%d", &k);
+
+	if ((k >= 2) && (k <= CALC_MAX_DEGREE))
+	{
+		printf("n: ");
+		scanf("%" SCNu64, &n);
+		if (n > (uint64)INT64_MAX)
+		{
+			printf("*** n must be below 2^63\n");
+			return;
+		}
+
+		memset(app_job->poly, 0, sizeof(app_job->poly));
+		app_job->poly_degree = k;
+		app_job->poly[k] = 1;
+		app_job->poly[0] = -(int64)n;
+		app_job->poly_guess = pow((double)n, 1.0 / k);
+		printf("\nRoot %d of %llu:\n", k, n);
+	}
+	else if (k == 0)
+	{
+		printf("Degree (1..%d): ", CALC_MAX_DEGREE);
+		scanf("%d", &app_job->poly_degree);
+		if ((app_job->poly_degree < 1) || (app_job->poly_degree > CALC_MAX_DEGREE))
+		{
+			printf("*** Value out of range\n");
+			return;
+		}
+
+		printf("Integer coefficients, highest power first: ");
+		for (int i = app_job->poly_degree; i >= 0; i--)
+			scanf("%" SCNd64, &app_job->poly[i]);
+
+		printf("Starting guess for the root: ");
+		scanf("%lf", &app_job->poly_guess);
+	}
+	else
+	{
+		printf("*** Value out of range\n");
+		return;
+	}
+
+	if (!app_background([]
+		{
+			app_root_ok = CALC_poly_root(app_job);
+			if (app_root_ok)
+			{
+				app_job->alu.shr(app_job->hl, app_job->r1, -1);			// fractional part only
+				app_job->alu.frac_to_bcd(app_job->bc, app_job->hl);
+			}
+		}, false))
+		return;
+
+	if (!app_root_ok)
+	{
+		printf("\n*** No simple root found near the guess, or it's too big\n");
+		return;
+	}
+
+	// As a decimal:
+	ALU.col = printf(" %s%llu.", app_job->root_negative ? "-" : "", app_job->r1[ALU_LENGTH_U64 - 1]);
+	ALU.print_bcd(app_job->bc, true);
+	printf("\n\n");
+
+	app_plot(ALU_view(app_job->r1, ALU_LENGTH_U64), "Plotting root", false);
+}
+
+/******************************************************************************
+** Function:	Store f_reg, if it's further on than the stored factorial
+**
+** Notes:		After long calculations & at exit, rather than for every 'n',
+**				as each store writes & renames a file
+*/
+void app_checkpoint_factorial(void)
+{
+	uint64 stored_n;
+
+	if ((app_job == NULL) || !app_job->f_valid)
+		return;
+
+	if ((STORE_get(STORE_FACTORIAL, &stored_n) == NULL) || (app_job->f_n > stored_n))
+		STORE_put(STORE_FACTORIAL, app_job->f_reg, app_job->f_n);
+}
+
+/******************************************************************************
+** Function:	Calculate & plot app_factorial_int!
+**
+** Notes:		Shown at once if it was made ahead
+*/
+void app_plot_factorial(bool calculate_from_scratch)
+{
+	bool speculated = !calculate_from_scratch && app_speculated(APP_MODE_FACTORIAL, app_factorial_int);
+
+	if (calculate_from_scratch)
+		app_job->f_valid = false;
+
+	if (speculated)
+		app_factorial_ok = true;
+	else
+	{
+		// Start from the stored checkpoint if it's nearer than what we have:
+		uint64 stored_n;
+		const uint64* p_stored = STORE_get(STORE_FACTORIAL, &stored_n);
+		bool usable = app_job->f_valid && ((app_job->f_n <= app_factorial_int) ||
+			(app_job->f_n - app_factorial_int <= CALC_FACTORIAL_MAX_BACK));
+		if ((p_stored != NULL) && (stored_n <= app_factorial_int) && (!usable || ((app_job->f_n <= app_factorial_int) && (stored_n > app_job->f_n))))
+		{
+			memcpy(app_job->f_reg, p_stored, sizeof(app_job->f_reg));
+			app_job->f_n = stored_n;
+			app_job->f_valid = true;
+		}
+
+		auto t0 = std::chrono::steady_clock::now();
+		bool completed = app_background([] { app_factorial_ok = CALC_factorial(app_job, app_factorial_int); }, false);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+		// Checkpoint a long calculation now, even if cancelled, as f_reg still holds f_n!:
+		if (seconds >= APP_CHECKPOINT_SECONDS)
+			app_checkpoint_factorial();
+
+		if (!completed)
+			return;
+	}
+
+	if (!app_factorial_ok)
+		printf("\n*** Numeric overflow for factorial of %llu\n", app_factorial_int);
+
+	printf("%llu!:\n", app_factorial_int);
+	ALU.col = 0;
+	
+	ALU.print_hex(ALU_view(app_job->f_reg, N_ELEMENTS(app_job->f_reg)), sizeof(app_job->f_reg), true);
+	// ALU.int_to_bcd(app_job->hl, app_job->f_reg);
+	// ALU.print_bcd(app_job->hl, false);
+	
+	printf("\n\n");
+
+	printf("Plotting %llu!\n", app_factorial_int);
+	if (speculated)
+		app_show_plot(NULL, false);
+	else
+		app_plot(ALU_view(app_job->f_reg, N_ELEMENTS(app_job->f_reg)), NULL, false);
+}
+
+/******************************************************************************
+** Function:	Calculate & plot term app_sequence_int of the mode's sequence
+**
+** Notes:		Steps from the term last plotted if it's near, else jumps.
+**				Shown at once if it was made ahead.
+*/
+void app_plot_sequence(void)
+{
+	char text[64];
+	bool speculated = app_speculated(app_mode, app_sequence_int);
+
+	if (speculated)
+		app_sequence_ok = true;
+	else
+	{
+		SEQ_set(&app_sequence, app_mode - APP_MODE_SEQUENCE, app_sequence_base);
+		if (!app_background([] { app_sequence_ok = SEQ_term(&app_sequence, app_job, app_sequence_int); }, false))
+			return;
+	}
+
+	if (!app_sequence_ok)
+	{
+		printf("\n*** Numeric overflow for term %llu of %s\n", app_sequence_int, SEQ_names[app_sequence.kind]);
+		return;
+	}
+
+	SEQ_text(&app_sequence, text, sizeof(text));
+	printf("%s:\n", text);
+	ALU.col = 0;
+	ALU.print_hex(ALU_view(app_sequence.value, SEQ_WORDS), SEQ_WORDS * sizeof(uint64), true);
+	printf("\n\n");
+
+	printf("Plotting %s\n", text);
+	if (speculated)
+		app_show_plot(NULL, false);
+	else
+		app_plot(ALU_view(app_sequence.value, SEQ_WORDS), NULL, false);
+}
+
+/******************************************************************************
+** Function:
+**
+** Notes:
+*/
+void app_toggle_animation(void)
+{
+	app_animate = !app_animate;
+	printf("\n*** Animate mode %s\n", app_animate ? "ON" : "OFF");
+}
+
+/******************************************************************************
+** Function: go back 2 values from current factorial, reciprocal or sequence term
+**
+** Notes:
+*/
+void app_go_back(void)
+{
+	if (app_mode == APP_MODE_RECIPROCAL)
+	{
+		app_reciprocal_int = (app_reciprocal_int < 3) ? 0UI64 : app_reciprocal_int - 2;
+		app_plot_reciprocal(app_reciprocal_int);
+	}
+	else if (app_mode == APP_MODE_FACTORIAL)
+	{
+		app_factorial_int = (app_factorial_int < 3) ? 0UI64 : app_factorial_int - 2;
+		app_plot_factorial(false);
+	}
+	else
+	{
+		app_sequence_int = (app_sequence_int < 3) ? 0UI64 : app_sequence_int - 2;
+		app_plot_sequence();
+	}
+
+	app_speculate_start();
+}
+
+/******************************************************************************
+** Function: Calculate A and B, where L = A / B
+**
+** Notes:
+*/
+void app_calculate(void)
+{
+	CALC_ant_parts(app_job);
+
+	printf("\nAnt trail, Integer part:\n");
+	ALU.print_hex(ALU_view(app_job->trail_integer, ALU_LENGTH_U64), ALU_LENGTH_BYTES, true);
+	app_plot(ALU_view(app_job->trail_integer, ALU_LENGTH_U64), "Integer part", true);
+
+	printf("\nAnt trail, Fractional part, first 128 bytes:\n");
+	ALU.print_hex(ALU_view(app_job->trail_fraction, ALU_LENGTH_U64), 128, true);
+	app_plot(ALU_view(app_job->trail_fraction, ALU_LENGTH_U64), "Fractional part", true);
+
+	const uint64* p_a = STORE_get(STORE_A, NULL);
+	const uint64* p_b = STORE_get(STORE_B, NULL);
+	const uint64* p_l = STORE_get(STORE_L, NULL);
+	if ((p_a != NULL) && (p_b != NULL) && (p_l != NULL))
+	{
+		printf("\nValues of A and B, where L = A / B, from store\n");
+		memcpy(app_job->a, p_a, sizeof(app_job->a));
+		memcpy(app_job->r2, p_b, sizeof(app_job->r2));
+		memcpy(app_job->bc, p_l, sizeof(app_job->bc));
+		app_plot(ALU_view(app_job->bc, 2 * ALU_LENGTH_U64), "Plotting L = A / B", true);
+	}
+	else if (app_animate)
+	{
+		if (!app_background([] { CALC_ant_ab(app_job); }, false))
+			return;
+
+		app_plot(ALU_view(app_job->bc, 2 * ALU_LENGTH_U64), "Plotting L = A / B", true);
+	}
+	else
+	{
+		// L is plotted as the division produces it:
+		ShowWindow(APP_hWnd, SW_SHOWNORMAL);
+		if (!app_background([] { app_pipeline([] { CALC_ant_ab(app_job); }); }, true))
+			return;
+
+		app_show_plot("Plotting L = A / B", true);
+	}
+
+	// Store whichever are missing, so one lost entry is written again:
+	if (p_a == NULL)
+		STORE_put(STORE_A, app_job->a, 0UI64);
+	if (p_b == NULL)
+		STORE_put(STORE_B, app_job->r2, 0UI64);
+	if (p_l == NULL)
+		STORE_put(STORE_L, app_job->bc, 0UI64);
+
+	// Print & Plot A:
+	printf("\nValue of A:\n");
+	ALU.col = 0;
+	ALU.print_hex(ALU_view(app_job->a, ALU_LENGTH_U64), ALU_LENGTH_BYTES, true);
+	printf("\n\n");
+	app_plot(ALU_view(app_job->a, ALU_LENGTH_U64), "Plotting value of A", true);
+
+	// Print & Plot B:
+	printf("\nValue of B:\n");
+	ALU.col = 0;
+	ALU.print_hex(ALU_view(app_job->r2, ALU_LENGTH_U64), ALU_LENGTH_BYTES, true);
+	printf("\n\n");
+	app_plot(ALU_view(app_job->r2, ALU_LENGTH_U64), "\nPlotting value of B", true);
+
+	// A as a decimal integer:
+	printf("\n\nA as a decimal integer:\n\n");
+	if (!app_background([] { app_job->alu.int_to_bcd(app_job->bc, app_job->a); }, false))
+		return;
+	ALU.col = 0;
+	ALU.print_bcd(app_job->bc, false);
+	printf("\n\n");
+
+	// B as a decimal integer:
+	printf("\n\nB as a decimal integer:\n\n");
+	ALU.int_to_bcd(app_job->bc, app_job->r2);
+	ALU.col = 0;
+	ALU.print_bcd(app_job->bc, false);
+	printf("\n\n");
+}
+
+/******************************************************************************
+** Function:
+**
+** Notes:
+*/
+void app_set_direction(void)
+{
+	int i;
+
+	printf("\nCurrent initial direction = %d\nEnter new initial direction (0..3): ", app_direction);
+	scanf("%d", &i);
+	app_speculate_cancel();
+	app_direction = i & 0x03;
+}
+
+/******************************************************************************
+** Function:
+**
+** Notes:
+**
+*/
+void app_calc_e(void)
+{
+	uint64 remainder;
+
+	TRACE_SPAN("calc e");
+	const uint64* p_e = STORE_get(STORE_E, NULL);
+	const uint64* p_decimal = STORE_get(STORE_E_DECIMAL, NULL);
+	if ((p_e != NULL) && (p_decimal != NULL))
+	{
+		printf("\n*** e from store\n");
+		memcpy(&app_job->hl[ALU_LENGTH_U64], p_e, ALU_LENGTH_BYTES);
+		memcpy(app_job->bc, p_decimal, sizeof(app_job->bc));
+	}
+	else
+	{
+		if (!app_background([] { CALC_e(app_job); app_job->alu.frac_to_bcd(app_job->bc, &app_job->hl[ALU_LENGTH_U64]); }, false))
+			return;
+
+		STORE_put(STORE_E, &app_job->hl[ALU_LENGTH_U64], 0UI64);
+		STORE_put(STORE_E_DECIMAL, app_job->bc, 0UI64);
+	}
+
+	// e as a decimal fraction:
+	printf("e as a decimal fraction:\n");
+	printf(" 2.");
+	ALU.col = 3;
+	ALU.print_bcd(app_job->bc, true);
+	printf("\n\n");
+
+	// Plot it, from the MS half of hl:
+	ALU.div_u64(&app_job->hl[ALU_LENGTH_U64], 4, ALU_LENGTH_U64, &remainder);
+	app_job->hl[2 * ALU_LENGTH_U64 - 1] |= 2UI64 << 62;
+	app_plot(ALU_view(&app_job->hl[ALU_LENGTH_U64], ALU_LENGTH_U64), "Plotting e", false);
+}
+
+/******************************************************************************
+** Function:
+**
+** Notes:
+*/
+void app_favourite()
+{
+	if (app_favourite_index >= N_ELEMENTS(app_favourites))
+	{
+		printf("\n\nStart of favourites list\n\n");
+		app_favourite_index = 0;
+	}
+
+	app_plot_reciprocal(app_favourites[app_favourite_index++]);
+}
+
+/******************************************************************************
+** Function:	Help command
+**
+** Notes:
+*/
+void app_help(void)
+{
+	printf("\n*** Antplot App V" APP_VERSION_STRING "\n");
+	printf("\n*** Commands:\n");
+
+	for (int i = 0; i < app_n_commands; i++)
+		printf("*** %c - %s\n", app_command_table[i].command_character, app_command_table[i].help_string);
+}
+
+/******************************************************************************
+** Function:
+**
+** Notes:
+** Langton's Ant recurrence pattern: 4F 27 9E 5E 87 B7 85 EF 0B D3 0C F3 49
+** Starts after 9977 steps (1248 bytes minus 7 steps)
+*/
+void app_langton(void)
+{
+	CALC_generate_ant(app_job, CALC_LANGTON_ITERATIONS);
+
+	// Plot whole ant trail:
+	printf("\nPlotting %d steps of ant trail\n", CALC_LANGTON_ITERATIONS);
+	app_plot(ALU_view_top(app_job->ant_trail, ALU_LENGTH_U64, (CALC_LANGTON_ITERATIONS + 63) / 64), NULL, false);
+}
+
+/******************************************************************************
+** Function:	Plot the trail of a multi-colour ant, e.g. RLR or LLRR
+**
+** Notes:		The trail is streamed to the plot, so it can be any length.
+**				The first ALU_LENGTH_U64 words are kept in ant_trail.
+*/
+void app_turmite(void)
+{
+	char rule[TURMITE_MAX_COLOURS + 1];
+
+	printf("\nRule, one of L, R, N or U for each colour (RL is Langton's Ant): ");
+	scanf("%16s", rule);										// width is TURMITE_MAX_COLOURS
+	if (!TURMITE_set_rule(CALC_get_turmite(app_job), rule))
+	{
+		printf("*** Not a valid rule\n");
+		return;
+	}
+
+	printf("Number of steps (0 for %d): ", 64 * ALU_LENGTH_U64);
+	scanf("%" SCNu64, &app_turmite_steps);
+	if (app_turmite_steps == 0UI64)
+		app_turmite_steps = 64 * ALU_LENGTH_U64;
+
+	if (app_animate && (app_turmite_steps > 64 * ALU_LENGTH_U64))
+	{
+		app_turmite_steps = 64 * ALU_LENGTH_U64;
+		printf("*** Limited to %d steps while animating\n", 64 * ALU_LENGTH_U64);
+	}
+
+	printf("\nPlotting %llu steps of %s trail (%s step loop)\n", app_turmite_steps, app_job->turmite->rule,
+		TURMITE_compiled(app_job->turmite) ? "compiled" : "general");
+
+	ShowWindow(APP_hWnd, SW_SHOWNORMAL);
+	auto t0 = std::chrono::steady_clock::now();
+	if (app_animate)
+		app_background([] { CALC_turmite(app_job, app_turmite_steps, 64); }, false);
+	else
+		app_background([] { app_pipeline([] { CALC_turmite(app_job, app_turmite_steps, 64); }); }, true);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+	printf("\n%llu steps in %.3f s\n", app_job->turmite->steps, seconds);
+
+	if (app_animate)
+		app_plot(ALU_view_top(app_job->ant_trail, ALU_LENGTH_U64, (int)((app_turmite_steps + 63) / 64)), NULL, false);
+	else
+		app_show_plot(NULL, false);
+
+	// If the trail ends up repeating, it is a rational A / B:
+	if ((app_job->turmite->steps != app_turmite_steps) || (app_turmite_steps > 64 * ALU_LENGTH_U64))
+		return;
+
+	if (!CALC_find_period(app_job->ant_trail, ALU_LENGTH_U64, app_turmite_steps, 0UI64, CALC_MAX_PERIOD,
+		&app_pre_bits, &app_period_bits))
+	{
+		printf("\nNo period of up to %d steps found\n", CALC_MAX_PERIOD);
+		return;
+	}
+
+	printf("\nTrail repeats every %llu steps after step %llu\n", app_period_bits, app_pre_bits);
+	if (!app_background([] { CALC_periodic(app_job, app_job->ant_trail, ALU_LENGTH_U64, 0UI64, app_pre_bits, app_period_bits); }, false))
+		return;
+
+	printf("\nA, where trail = A / B:\n");
+	ALU.col = 0;
+	ALU.print_hex(ALU_view(app_job->a, ALU_LENGTH_U64), ALU_LENGTH_BYTES, true);
+	printf("\nB:\n");
+	ALU.col = 0;
+	ALU.print_hex(ALU_view(app_job->r2, ALU_LENGTH_U64), ALU_LENGTH_BYTES, true);
+	printf("\n(Enter A or B in 'x' to plot A / B)\n");
+}
+
+/******************************************************************************
+** Function:
+**
+** Notes:
+*/
+void app_toggle_mode(void)
+{
+	app_speculate_cancel();
+	app_mode = (app_mode + 1) % APP_N_MODES;
+	printf("\n*** Mode: %s\n", app_mode_names[app_mode]);
+}
+
+/******************************************************************************
+** Function:	Next plot of reciprocal, factorial or sequence term of a 64-bit integer value
+**
+** Notes:
+*/
+void app_next_plot(void)
+{
+	if (app_mode == APP_MODE_RECIPROCAL)
+		app_plot_reciprocal(++app_reciprocal_int);
+	else if (app_mode == APP_MODE_FACTORIAL)
+	{
+		app_factorial_int++;
+		app_plot_factorial(false);
+	}
+	else
+	{
+		app_sequence_int++;
+		app_plot_sequence();
+	}
+
+	app_speculate_start();
+}
+
+/******************************************************************************
+** Function:	Calculate & plot pi
+**
+** Notes:
+*/
+void app_calc_pi(void)
+{
+	TRACE_SPAN("calc pi");
+	const uint64* p_pi = STORE_get(STORE_PI, NULL);
+	const uint64* p_decimal = STORE_get(STORE_PI_DECIMAL, NULL);
+	if ((p_pi != NULL) && (p_decimal != NULL))
+	{
+		printf("\n*** pi from store\n");
+		memcpy(app_job->r1, p_pi, sizeof(app_job->r1));
+		memcpy(app_job->bc, p_decimal, sizeof(app_job->bc));
+	}
+	else
+	{
+		if (!app_background([] { CALC_pi(app_job); app_job->alu.frac_to_bcd(app_job->bc, app_job->r1); }, false))
+			return;
+
+		STORE_put(STORE_PI, app_job->r1, 0UI64);
+		STORE_put(STORE_PI_DECIMAL, app_job->bc, 0UI64);
+	}
+
+	// pi as a decimal fraction:
+	printf("pi as a decimal fraction:\n");
+	printf(" 3.");
+	ALU.col = 3;
+	ALU.print_bcd(app_job->bc, true);
+	printf("\n\n");
+
+	// Plot it:
+	app_plot(ALU_view(app_job->r1, ALU_LENGTH_U64), "Plotting pi", false);
+}
+
+/******************************************************************************
+** Function:
+**
+** Notes:
+*/
+void app_quit(void)
+{
+	app_speculate_cancel();
+	exit(0);
+}
+
+/******************************************************************************
+** Function: Plot a random bit pattern
+**
+** Notes:
+*/
+void app_plot_random(void)
+{
+	RANDOM_fill(app_job->r1, ALU_LENGTH_U64, app_random_seed, app_random_stream++);
+
+	printf("\nFirst 1024 hex digits of random sequence:\n");
+	ALU.col = 0;
+	ALU.print_hex(ALU_view(app_job->r1, ALU_LENGTH_U64), 512, false);
+	app_plot(ALU_view(app_job->r1, ALU_LENGTH_U64), "Plotting random bit sequence", false);
+}
+
+/******************************************************************************
+** Function:	Monte Carlo baseline: walk many random strings & summarise,
+**				or sweep 1 / v over a range of v
+**
+** Notes:		Strings are split across the thread pool, & can be cancelled
+*/
+void app_monte_carlo(void)
+{
+	printf("\nSweep 1 / v from v = (0 for random strings): ");
+	scanf("%" SCNu64, &app_monte_carlo_from);
+	if (app_monte_carlo_from == 1UI64)
+	{
+		printf("\n*** v must be 2 or more\n");
+		return;
+	}
+
+	printf((app_monte_carlo_from != 0UI64) ? "Values of v to walk (0 for %d): " : "Random strings to walk (0 for %d): ", APP_MONTE_CARLO_SAMPLES);
+	scanf("%" SCNu64, &app_monte_carlo_samples);
+	if (app_monte_carlo_samples == 0UI64)
+		app_monte_carlo_samples = APP_MONTE_CARLO_SAMPLES;
+	if ((app_monte_carlo_from >= STATS_SWEEP_MAX_V) || (app_monte_carlo_samples > STATS_SWEEP_MAX_V - app_monte_carlo_from))
+	{
+		printf("\n*** v must stay below 2^63\n");
+		return;
+	}
+
+	printf("Words per string, up to %d (0 for %d): ", ALU_LENGTH_U64, APP_MONTE_CARLO_WORDS);
+	scanf("%d", &app_monte_carlo_words);
+	if ((app_monte_carlo_words <= 0) || (app_monte_carlo_words > ALU_LENGTH_U64))
+		app_monte_carlo_words = APP_MONTE_CARLO_WORDS;
+
+	auto t0 = std::chrono::steady_clock::now();
+	if (!app_background([]
+		{
+			app_job->progress_total = app_monte_carlo_samples;
+			if (app_monte_carlo_from != 0UI64)
+				STATS_sweep(&app_monte_carlo_result, app_monte_carlo_from, app_monte_carlo_samples, app_monte_carlo_words,
+					&app_job->progress, &app_job->cancel);
+			else
+				STATS_run(&app_monte_carlo_result, app_monte_carlo_samples, app_monte_carlo_words, app_random_seed,
+					&app_job->progress, &app_job->cancel);
+		}, false))
+		return;
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+	STATS_print(&app_monte_carlo_result);
+	printf("%.3f s, %.0f %s per second on %d threads\n", seconds, app_monte_carlo_result.n_samples / seconds,
+		(app_monte_carlo_from != 0UI64) ? "values" : "strings", POOL_threads());
+}
+
+/******************************************************************************
+** Function:
+**
+** Notes:
+*/
+void app_set_start_value(void)
+{
+	app_speculate_cancel();
+	if (app_mode == APP_MODE_SEQUENCE + SEQ_POWER)
+	{
+		printf("\n*** Enter base a for a^n (2 and up): ");
+		scanf("%" SCNu64, &app_sequence_base);
+		if (app_sequence_base < 2UI64)
+		{
+			printf("*** Value out of range\n");
+			app_sequence_base = APP_SEQUENCE_BASE;
+			return;
+		}
+	}
+
+	printf("\n*** Enter start value for %s: ", (app_mode == APP_MODE_RECIPROCAL) ? "reciprocal" :
+		(app_mode == APP_MODE_FACTORIAL) ? "factorial" : SEQ_names[app_mode - APP_MODE_SEQUENCE]);
+
+	if (app_mode == APP_MODE_RECIPROCAL)
+	{
+		scanf("%" SCNu64, &app_reciprocal_int);
+		app_plot_reciprocal(app_reciprocal_int);
+	}
+	else if (app_mode == APP_MODE_FACTORIAL)
+	{
+		scanf("%" SCNu64, &app_factorial_int);
+		app_plot_factorial(true);
+	}
+	else
+	{
+		scanf("%" SCNu64, &app_sequence_int);
+		app_plot_sequence();
+	}
+
+	app_speculate_start();
+}
+
+/******************************************************************************
+** Function:
+**
+** Notes:
+*/
+void app_set_zoom(void)
+{
+	int i;
+
+	printf("Current zoom level is %d\n\nSet new zoom level (0..255) : ", app_zoom_level);
+	scanf("%d", &i);
+	if ((i < 0) || (i > 255))
+		printf("*** Value out of range. Zoom level unchanged.\n");
+	else
+	{
+		app_speculate_cancel();
+		app_zoom_level = (uint8)i;
+	}
+}
+
+/******************************************************************************
+** Function:	Execute single character command
+**
+** Notes:
+*/
+void app_execute_command(char c)
+{
+	printf("%c\n", c);
+
+	for (int i = 0; i < app_n_commands; i++)
+	{
+		// ensure lower case comparison:
+		if ((app_command_table[i].command_character | 0x20) == c)
+		{
+			TRACE_command(app_command_table[i].help_string, app_command_table[i].p_function);
+			return;
+		}
+	}
+
+	printf("*** Unrecognised command key.\n");
+}
+
+/******************************************************************************
+** Function:	Task
+**
+** Notes:
+*/
+void APP_task(void)
+{
+	char keycode = 0;
+
+	app_prompt = true;
+	app_zoom_level = 1;
+	app_job = CALC_create_job();
+	app_speculate_job = CALC_create_job();
+	atexit(app_speculate_cancel);	// the speculator mustn't be running at exit
+	app_help();					// Display help at start
+	STORE_init();				// map values stored by earlier sessions
+	atexit(app_checkpoint_factorial);
+	POOL_set_threads((int)std::thread::hardware_concurrency());
+	app_sequence_base = APP_SEQUENCE_BASE;
+	app_mode = APP_N_MODES - 1;
+	app_toggle_mode();			// steps app_mode round to reciprocal & reports mode
+
+	app_random_seed = GetTickCount();	// seed randomizer
+
+	do
+	{
+		if (keycode != 0)
+		{
+			app_execute_command(keycode);
+			keycode = 0;
+			app_prompt = true;
+		}
+
+		keycode = app_wait_for_keypress();
+	} while (true);
+}
+
+/******************************************************************************
+** Command table:
+*/
+const app_command_table_entry_type app_command_table[] =
+{
+	{ '#', "Serve antplots to other tools on a localhost port", app_serve },
+	{ 'a', "Toggle animation mode on/off", app_toggle_animation },
+	{ 'b', "Go back 2 values", app_go_back },
+	{ 'c', "Calculate integer expression for Langton's ant", app_calculate },
+	{ 'd', "Set initial ant direction", app_set_direction },
+	{ 'e', "Calculate & plot e", app_calc_e },
+	{ 'f', "Next favourite", app_favourite },
+	{ 'g', "Plot any file, e.g. a genome, an archive or a firmware image", app_plot_file },
+	{ 'h', "Help", app_help },
+	{ 'i', "Instrumentation: tracing on/off (writes " TRACE_OUTPUT_FILENAME ")", TRACE_toggle },
+	{ 'j', "Set number of threads for long operations", POOL_configure },
+	{ 'k', "Monte Carlo statistics of random antplots, or of 1 / v", app_monte_carlo },
+	{ 'l', "Langton's Ant", app_langton },
+	{ 'm', "Mode (reciprocal, factorial, a^n, Fibonacci, primorial or central binomial)", app_toggle_mode },
+	{ 'n', "Next reciprocal, factorial or sequence plot", app_next_plot },
+	{ 'o', "Output animation frames to video file on/off", ANIM_configure },
+	{ 'p', "Calculate & plot pi", app_calc_pi },
+	{ 'q', "Quit", app_quit },
+	{ 'r', "Plot a random bit sequence", app_plot_random },
+	{ 's', "Square root, cube root etc, or root of a polynomial", app_calc_root },
+	{ 't', "Timing benchmark (writes " BENCH_OUTPUT_FILENAME ")", BENCH_run },
+	{ 'u', "Multi-colour ant (turmite) trail, e.g. RLR or LLRR", app_turmite },
+	{ 'v', "Set value for reciprocal, factorial or sequence", app_set_start_value },
+	{ 'w', "Plot 1 / v from any bit k, for a big integer v", app_plot_window },
+	{ 'x', "Plot a / b for big integers a & b", app_plot_rational },
+	{ 'y', "Plot 1 / v over any number of periods, e.g. 10^12", app_plot_cycle },
+	{ 'z', "Set zoom factor", app_set_zoom }
+};
+
+const int app_n_commands = N_ELEMENTS(app_command_table);
+
+
+
+
+
+
+
@@ -0,0 +1,475 @@
+/******************************************************************************
+** File:	Bench.cpp
+**
+** Notes:	Timing benchmark of ALU kernels, conversions and the ant walk.
+**			Results are written as JSON, one result per line, and can be
+**			compared against a JSON file saved from an earlier run. Before
+**			timing, results are checked against hashes of known-good ones,
+**			so a faster kernel that gets the wrong answer is caught.
+*/
+
+#include "stdafx.h"
+
+#include "Accum.h"
+#include "Alu.h"
+#include "App.h"
+#include "Bench.h"
+#include "Calc.h"
+#include "Fixed.h"
+
+#define BENCH_SIZE_LENGTH		0			// length_words argument
+#define BENCH_SIZE_X			1			// significant words of x
+#define BENCH_SIZE_Y			2			// significant words of y
+
+// App & Calc functions under test:
+void app_walk_off_screen(ALU_view_type v, uint32* pixels, CALC_job_type* job);
+int calc_gcd(CALC_job_type* job, uint64* u, uint64* v, int n);
+
+typedef struct
+{
+	const char* name;
+	const char* unit;						// what size counts: "words" or "steps"
+	void (*p_function)(int size);
+	int sized;								// what size sets: BENCH_SIZE_xxx
+	bool reload;							// function destroys its operand
+	int sizes[5];							// 0 terminates list
+} bench_case_type;
+
+typedef struct
+{
+	char name[32];
+	int size;
+	double ns_per_call;
+} bench_result_type;
+
+typedef struct
+{
+	const char* name;
+	uint64 (*p_function)(CALC_job_type* job);	// returns hash of the result
+	uint64 hash;							// for ALU_LENGTH_U64 words
+} bench_check_type;
+
+ALU_reg_pair bench_x;						// operand, overwritten by result
+ALU_reg_pair bench_y;
+ALU_reg_pair bench_src;						// copy of bench_x for reloading
+ALU_reg_pair bench_dest;
+CALC_job_type* bench_job;
+ACCUM_type bench_acc;						// carry-saves bench_x
+int64 bench_carries[2 * ALU_LENGTH_U64];
+uint32 bench_pixels[APP_SCREEN_WIDTH * APP_SCREEN_HEIGHT];	// the walk draws here, not on screen
+
+bench_result_type bench_baseline[64];
+int bench_n_baseline;
+
+/******************************************************************************
+** Function:	Fill register with pseudo-random words, MS words zero
+**
+** Notes:		Deterministic, so that runs are comparable
+*/
+void bench_fill(uint64* r, int length_words, int significant_words, uint64 seed)
+{
+	uint64 x = 0x9E3779B97F4A7C15UI64 ^ seed;
+
+	for (int i = 0; i < length_words; i++)
+	{
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+		r[i] = (i < significant_words) ? x : 0UI64;
+	}
+}
+
+/******************************************************************************
+** Functions under test
+**
+** Notes:		size is the operand length, or number of significant words for
+**				the functions which always work on the full register
+*/
+void bench_adc(int size) { ALU.adc(bench_x, bench_y, size); }
+void bench_sub(int size) { ALU.sub(bench_x, bench_y, size); }
+void bench_mul_u64(int size) { ALU.mul_u64(bench_x, 0xC6A4A7935BD1E995UI64, size); }
+void bench_mul(int size) { ALU.mul(bench_dest, bench_x, bench_y); }
+void bench_div(int size) { ALU.div(bench_dest, bench_x, bench_y); }
+void bench_int_to_bcd(int size) { ALU.int_to_bcd(bench_dest, bench_x); }
+void bench_frac_to_bcd(int size) { ALU.frac_to_bcd(bench_dest, bench_x); }
+void bench_generate_ant(int size) { CALC_generate_ant(bench_job, size); }
+void bench_walk(int size) { app_walk_off_screen(ALU_view(bench_x, size), bench_pixels, bench_job); }
+
+void bench_fixed_mul(int size)
+{
+	ALU_fixed_type<2 + CALC_ANT_INTEGER_WORDS> p = ALU_fixed_mul(ALU_fixed_type<2>::from_reg(bench_y),
+		ALU_fixed_type<CALC_ANT_INTEGER_WORDS>::from_reg(bench_x));
+	p.to_reg(bench_dest);
+}
+
+void bench_div_u64(int size)
+{
+	uint64 remainder;
+	ALU.div_u64(bench_x, 0xFFFFFFFFFFFFFFC5UI64, size, &remainder);
+}
+
+void bench_div_sum(int size)
+{
+	const ALU_term_type terms[8] =
+	{
+		{ 4UI64 << 61, 8001, false }, { 2UI64 << 61, 8004, true }, { 1UI64 << 61, 8005, true }, { 1UI64 << 61, 8006, true },
+		{ 4UI64 << 57, 8009, false }, { 2UI64 << 57, 8012, true }, { 1UI64 << 57, 8013, true }, { 1UI64 << 57, 8014, true }
+	};
+	ACCUM_init(&bench_acc, bench_x, bench_carries, size);
+	ALU.div_sum(&bench_acc, terms, 8, size - 1);
+	ACCUM_normalise(&bench_acc);
+}
+
+void bench_accum(int size)
+{
+	ACCUM_init(&bench_acc, bench_x, bench_carries, size);
+	for (int i = size - 1; i >= 0; i--)
+		ACCUM_put(&bench_acc, i, bench_y[i], 1);
+	ACCUM_normalise(&bench_acc);
+}
+
+const bench_case_type bench_cases[] =
+{
+	{ "adc", "words", bench_adc, BENCH_SIZE_LENGTH, false, { 64, 256, 1024, ALU_LENGTH_U64, 2 * ALU_LENGTH_U64 } },
+	{ "sub", "words", bench_sub, BENCH_SIZE_LENGTH, false, { 64, 256, 1024, ALU_LENGTH_U64, 2 * ALU_LENGTH_U64 } },
+	{ "mul_u64", "words", bench_mul_u64, BENCH_SIZE_LENGTH, false, { 64, 256, 1024, ALU_LENGTH_U64, 2 * ALU_LENGTH_U64 } },
+	{ "div_u64", "words", bench_div_u64, BENCH_SIZE_LENGTH, true, { 64, 256, 1024, ALU_LENGTH_U64, 2 * ALU_LENGTH_U64 } },
+	{ "div_sum_8", "words", bench_div_sum, BENCH_SIZE_LENGTH, false, { 64, 256, 1024, ALU_LENGTH_U64, 2 * ALU_LENGTH_U64 } },
+	{ "accum_put", "words", bench_accum, BENCH_SIZE_LENGTH, false, { 64, 256, 1024, ALU_LENGTH_U64, 2 * ALU_LENGTH_U64 } },
+	{ "mul", "words", bench_mul, BENCH_SIZE_X, false, { ALU_LENGTH_U64 } },
+	{ "fixed_mul_2x156", "words", bench_fixed_mul, BENCH_SIZE_X, false, { CALC_ANT_INTEGER_WORDS } },
+	{ "div", "words", bench_div, BENCH_SIZE_Y, false, { 2, 64, ALU_LENGTH_U64 } },
+	{ "int_to_bcd", "words", bench_int_to_bcd, BENCH_SIZE_X, false, { 16, 64, 256 } },
+	{ "frac_to_bcd", "words", bench_frac_to_bcd, BENCH_SIZE_X, false, { ALU_LENGTH_U64 } },
+	{ "app_generate_ant", "steps", bench_generate_ant, BENCH_SIZE_LENGTH, false, { 1000, 4000, 12000 } },
+	{ "app_walk", "words", bench_walk, BENCH_SIZE_LENGTH, false, { 64, 1024, ALU_LENGTH_U64, 2 * ALU_LENGTH_U64 } }
+};
+
+/******************************************************************************
+** Function:	Time one benchmark case at one size
+**
+** Notes:		Returns best mean time per call over BENCH_N_SAMPLES samples.
+**				Functions which destroy their operand are reloaded between calls,
+**				outside the timed region.
+*/
+double bench_time(const bench_case_type* p_case, int size)
+{
+	double best = 0.0;
+
+	for (int sample = 0; sample < BENCH_N_SAMPLES; sample++)
+	{
+		double elapsed = 0.0;
+		uint64 calls = 0;
+
+		do
+		{
+			if (p_case->reload)
+			{
+				memcpy(bench_x, bench_src, sizeof(bench_x));
+				auto t0 = std::chrono::steady_clock::now();
+				p_case->p_function(size);
+				elapsed += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+				calls++;
+			}
+			else
+			{
+				uint64 batch = (calls == 0) ? 1 : calls;		// double batch size each time round
+				auto t0 = std::chrono::steady_clock::now();
+				for (uint64 n = 0; n < batch; n++)
+					p_case->p_function(size);
+				elapsed += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+				calls += batch;
+			}
+		} while (elapsed < BENCH_MIN_TIME_NS);
+
+		double t = elapsed / (double)calls;
+		if ((sample == 0) || (t < best))
+			best = t;
+	}
+
+	return best;
+}
+
+/******************************************************************************
+** Function:	Load results from a JSON file written by an earlier run
+**
+** Notes:		Relies on the one-result-per-line layout written by BENCH_run
+*/
+bool bench_load_baseline(const char* filename)
+{
+	char line[256];
+
+	bench_n_baseline = 0;
+	FILE* f = fopen(filename, "r");
+	if (f == NULL)
+		return false;
+
+	while ((fgets(line, sizeof(line), f) != NULL) && (bench_n_baseline < N_ELEMENTS(bench_baseline)))
+	{
+		bench_result_type* p = &bench_baseline[bench_n_baseline];
+		if (sscanf(line, " { \"name\": \"%31[^\"]\", \"unit\": \"%*[^\"]\", \"size\": %d, \"ns_per_call\": %lf",
+			p->name, &p->size, &p->ns_per_call) == 3)
+		{
+			bench_n_baseline++;
+		}
+	}
+
+	fclose(f);
+	return true;
+}
+
+/******************************************************************************
+** Function:	Find baseline time for a case
+**
+** Notes:		Returns 0 if not present
+*/
+double bench_baseline_time(const char* name, int size)
+{
+	for (int i = 0; i < bench_n_baseline; i++)
+	{
+		if ((strcmp(bench_baseline[i].name, name) == 0) && (bench_baseline[i].size == size))
+			return bench_baseline[i].ns_per_call;
+	}
+
+	return 0.0;
+}
+
+/******************************************************************************
+** Function:	FNV-1a hash of n words, MS word first
+**
+** Notes:
+*/
+uint64 bench_hash(const uint64* p, int n)
+{
+	uint64 h = 0xCBF29CE484222325UI64;
+
+	for (int i = n - 1; i >= 0; i--)
+	{
+		h ^= p[i];
+		h *= 0x00000100000001B3UI64;
+	}
+	return h;
+}
+
+/******************************************************************************
+** Self-checks
+**
+** Notes:		Each computes a result in a fresh job & hashes it, MS word
+**				first. The hashes are of the results the original global-
+**				register code gave, for ALU_LENGTH_U64 of 2048, or of the
+**				known answer.
+*/
+uint64 bench_check_reciprocal_113(CALC_job_type* job)
+{
+	CALC_reciprocal(job, 113);
+	return bench_hash(job->hl, 2 * ALU_LENGTH_U64);
+}
+
+uint64 bench_check_reciprocal_1000003(CALC_job_type* job)
+{
+	CALC_reciprocal(job, 1000003);
+	return bench_hash(job->hl, 2 * ALU_LENGTH_U64);
+}
+
+uint64 bench_check_factorial_700(CALC_job_type* job)
+{
+	CALC_factorial(job, 700);
+	return bench_hash(job->f_reg, 2 * ALU_LENGTH_U64);
+}
+
+uint64 bench_check_e(CALC_job_type* job)
+{
+	CALC_e(job);
+	return bench_hash(&job->hl[ALU_LENGTH_U64], ALU_LENGTH_U64);
+}
+
+uint64 bench_check_pi(CALC_job_type* job)
+{
+	CALC_pi(job);
+	return bench_hash(job->r1, ALU_LENGTH_U64);
+}
+
+uint64 bench_check_a(CALC_job_type* job)
+{
+	CALC_ant_parts(job);
+	CALC_ant_ab(job);
+	return bench_hash(job->a, ALU_LENGTH_U64);
+}
+
+uint64 bench_check_b(CALC_job_type* job)
+{
+	CALC_ant_parts(job);
+	CALC_ant_ab(job);
+	return bench_hash(job->r2, ALU_LENGTH_U64);
+}
+
+uint64 bench_check_l(CALC_job_type* job)
+{
+	CALC_ant_parts(job);
+	CALC_ant_ab(job);
+	return bench_hash(job->bc, 2 * ALU_LENGTH_U64);
+}
+
+void bench_mul_2x1(uint64* dest, const uint64* g, uint64 m)
+{
+	uint64 high64;
+
+	dest[0] = _umul128(g[0], m, &dest[1]);
+	uint64 low64 = _umul128(g[1], m, &high64);
+	dest[2] = high64 + _addcarry_u64(0, dest[1], low64, &dest[1]);
+}
+
+uint64 bench_check_gcd(CALC_job_type* job)
+{
+	// gcd(g m, g n) for coprime m & n, where n is so much smaller that
+	// Lehmer's first pass stops after one step, leaving cofactors (0, 1):
+	const uint64 g[2] = { 0xB7E81F51B8DE767DUI64, 0x01DABFD3C293BBABUI64 };
+
+	bench_mul_2x1(job->gcd_u, g, 1019909684598967671UI64);
+	bench_mul_2x1(job->gcd_v, g, 7349834701UI64);
+	calc_gcd(job, job->gcd_u, job->gcd_v, 3);
+	return bench_hash(job->gcd_u, CALC_GCD_WORDS);			// of g
+}
+
+const bench_check_type bench_checks[] =
+{
+	{ "1 / 113", bench_check_reciprocal_113, 0xFFA5282AB6173D94UI64 },
+	{ "1 / 1000003", bench_check_reciprocal_1000003, 0x8E0D2A2276E6D22FUI64 },
+	{ "700!", bench_check_factorial_700, 0x61BD835AC84BF60CUI64 },
+	{ "e", bench_check_e, 0xD22E67B4DC420842UI64 },
+	{ "pi", bench_check_pi, 0x141429B9B0490038UI64 },
+	{ "A", bench_check_a, 0x6911618FB82A14ABUI64 },
+	{ "B", bench_check_b, 0x3EC9256CD019E7FBUI64 },
+	{ "L = A / B", bench_check_l, 0x9D6DED7066A1B228UI64 },
+	{ "Lehmer GCD", bench_check_gcd, 0x7B651267EA422A1BUI64 }
+};
+
+/******************************************************************************
+** Function:	Check results against known-good hashes
+**
+** Notes:		Returns number of failures. Skipped, with a note, unless
+**				ALU_LENGTH_U64 is the length the hashes were made for.
+*/
+int bench_self_check(void)
+{
+	int n_failed = 0;
+
+	if (ALU_LENGTH_U64 != 2048)
+	{
+		printf("\n*** Self-check skipped: hashes are for ALU_LENGTH_U64 of 2048\n");
+		return 0;
+	}
+
+	printf("\nSelf-check:\n");
+	for (int c = 0; c < N_ELEMENTS(bench_checks); c++)
+	{
+		CALC_job_type* job = CALC_create_job();
+		uint64 hash = bench_checks[c].p_function(job);
+		CALC_destroy_job(job);
+
+		bool ok = (hash == bench_checks[c].hash);
+		printf("%-18s %016llX %s\n", bench_checks[c].name, hash, ok ? "ok" : "** WRONG");
+		if (!ok)
+			n_failed++;
+	}
+	return n_failed;
+}
+
+/******************************************************************************
+** Function:	Benchmark command
+**
+** Notes:		Writes BENCH_OUTPUT_FILENAME. Enter '-' to skip comparison.
+*/
+void BENCH_run(void)
+{
+	char baseline_filename[MAX_PATH];
+	int n_regressions = 0;
+
+	printf("\nBaseline JSON file to compare against (- for none): ");
+	scanf("%200s", baseline_filename);
+
+	bool compare = false;
+	if (strcmp(baseline_filename, "-") != 0)
+	{
+		compare = bench_load_baseline(baseline_filename);
+		if (!compare)
+			printf("*** Unable to read %s. No comparison.\n", baseline_filename);
+	}
+
+	FILE* f = fopen(BENCH_OUTPUT_FILENAME, "w");
+	if (f == NULL)
+	{
+		printf("*** Unable to create " BENCH_OUTPUT_FILENAME "\n");
+		return;
+	}
+
+	if (bench_job == NULL)
+		bench_job = CALC_create_job();
+
+	int n_failed = bench_self_check();
+
+	fprintf(f, "{\n  \"alu_length_u64\": %d,\n  \"results\": [\n", ALU_LENGTH_U64);
+
+	printf("\n%-18s %8s %16s %12s", "Function", "Size", "ns/call", "ns/unit");
+	if (compare)
+		printf(" %16s %8s", "Baseline", "Ratio");
+	printf("\n");
+
+	bool first = true;
+	for (int c = 0; c < N_ELEMENTS(bench_cases); c++)
+	{
+		const bench_case_type* p_case = &bench_cases[c];
+
+		for (int s = 0; (s < N_ELEMENTS(p_case->sizes)) && (p_case->sizes[s] != 0); s++)
+		{
+			int size = p_case->sizes[s];
+
+			// Operands are full of random words, except that size may set the
+			// number of significant (LS) words of x or y
+			bench_fill(bench_x, 2 * ALU_LENGTH_U64, 2 * ALU_LENGTH_U64, 1);
+			bench_fill(bench_y, 2 * ALU_LENGTH_U64, 2 * ALU_LENGTH_U64, 2);
+			if (p_case->sized == BENCH_SIZE_X)
+				bench_fill(bench_x, ALU_LENGTH_U64, size, 1);
+			if (p_case->sized == BENCH_SIZE_Y)
+				bench_fill(bench_y, ALU_LENGTH_U64, size, 2);
+			memcpy(bench_src, bench_x, sizeof(bench_src));
+
+			double t = bench_time(p_case, size);
+
+			printf("%-18s %8d %16.1f %12.3f", p_case->name, size, t, t / size);
+			fprintf(f, "%s    { \"name\": \"%s\", \"unit\": \"%s\", \"size\": %d, \"ns_per_call\": %.1f, \"ns_per_unit\": %.4f }",
+				first ? "" : ",\n", p_case->name, p_case->unit, size, t, t / size);
+			first = false;
+
+			if (compare)
+			{
+				double t_base = bench_baseline_time(p_case->name, size);
+				if (t_base > 0.0)
+				{
+					double ratio = t / t_base;
+					printf(" %16.1f %8.3f", t_base, ratio);
+					if (ratio > 1.0 + BENCH_TOLERANCE)
+					{
+						printf("  ** REGRESSION");
+						n_regressions++;
+					}
+					else if (ratio < 1.0 - BENCH_TOLERANCE)
+						printf("  faster");
+				}
+				else
+					printf(" %16s", "-");
+			}
+
+			printf("\n");
+		}
+	}
+
+	fprintf(f, "\n  ]\n}\n");
+	fclose(f);
+
+	printf("\n*** Results written to " BENCH_OUTPUT_FILENAME "\n");
+	if (n_failed > 0)
+		printf("*** %d self-check(s) WRONG: timings are of kernels giving wrong results\n", n_failed);
+	if (compare)
+		printf("*** %d regression(s) beyond %d%% against %s\n", n_regressions, (int)(BENCH_TOLERANCE * 100), baseline_filename);
+}
@@ -0,0 +1,13 @@
+/******************************************************************************
+** File:	Bench.h
+**
+** Notes:	Timing benchmark of ALU kernels, conversions and the ant walk,
+**			after a self-check of the results behind the plots
+*/
+
+#define BENCH_OUTPUT_FILENAME	"antplot_bench.json"
+#define BENCH_MIN_TIME_NS		250000000.0		// time each sample for at least 0.25 s
+#define BENCH_N_SAMPLES			3				// best of
+#define BENCH_TOLERANCE			0.10			// ratio change reported as a regression/gain
+
+void BENCH_run(void);
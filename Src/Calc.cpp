@@ -0,0 +1,1357 @@
+/******************************************************************************
+** File:	Calc.cpp
+**
+** Notes:	Computations behind the antplots: Langton's Ant & other turmites, reciprocals,
+**			rationals, roots, factorials, pi and e. Everything works in the job passed in.
+*/
+
+#include "stdafx.h"
+
+#include "Accum.h"
+#include "Alu.h"
+#include "Calc.h"
+#include "Fixed.h"
+#include "Ring.h"
+#include "Trace.h"
+#include "Turmite.h"
+
+/******************************************************************************
+** Function:	Create job
+**
+** Notes:		Registers start zeroed. Jobs are large, so they live on the heap.
+**				The turmite board is only made when a job first needs it.
+*/
+CALC_job_type* CALC_create_job(void)
+{
+	CALC_job_type* job = new CALC_job_type();		// value-initialised, i.e. zeroed
+	job->alu.p_cancel = &job->cancel;
+	return job;
+}
+
+/******************************************************************************
+** Function:
+**
+** Notes:
+*/
+void CALC_destroy_job(CALC_job_type* job)
+{
+	if (job->turmite != NULL)
+	{
+		TURMITE_free(job->turmite);
+		delete job->turmite;
+	}
+	delete job;
+}
+
+/******************************************************************************
+** Function:	Job's turmite, made on first use
+**
+** Notes:		The board is 16 MB, which most jobs never touch
+*/
+TURMITE_type* CALC_get_turmite(CALC_job_type* job)
+{
+	if (job->turmite == NULL)
+	{
+		job->turmite = new TURMITE_type();
+		TURMITE_init(job->turmite);
+	}
+	return job->turmite;
+}
+
+/******************************************************************************
+** Function:	Run the turmite from a clear board, trail into ant_trail
+**
+** Notes:		MS-first bit order: the first step is the MS bit of ant_trail
+**				that is used, as the first word holds only first_word_bits
+**				steps, in its LS bits. Words past the end of
+**				ant_trail are only streamed to alu.p_output, so n_steps can be
+**				any number. Set the rule in CALC_get_turmite(job) first.
+*/
+void CALC_turmite(CALC_job_type* job, uint64 n_steps, int first_word_bits)
+{
+	uint64 block[RING_BLOCK_U64];
+	int n_block = 0;
+	int bits = first_word_bits;
+
+	TRACE_SPAN("turmite");
+
+	TURMITE_reset(CALC_get_turmite(job));
+	job->alu.set(job->ant_trail, 0);
+	job->progress_total = n_steps;
+	for (uint64 i = 0; n_steps != 0UI64; i++)
+	{
+		int n = (n_steps < (uint64)bits) ? (int)n_steps : bits;
+		uint64 w = TURMITE_steps(job->turmite, n) << (bits - n);
+		n_steps -= n;
+		bits = 64;
+
+		if (i < ALU_LENGTH_U64)
+			job->ant_trail[ALU_LENGTH_U64 - 1 - i] = w;
+
+		block[n_block++] = w;
+		if ((n_block == RING_BLOCK_U64) || (n_steps == 0UI64))
+		{
+			if (job->cancel)
+				break;
+
+			if (job->alu.p_output != NULL)
+				job->alu.p_output->push(block, n_block, &job->cancel);
+			n_block = 0;
+			job->progress = job->turmite->steps;
+		}
+	}
+}
+
+/******************************************************************************
+** Function:	Generate Langton's Ant into ant_trail, first step MS
+**
+** Notes:
+*/
+void CALC_generate_ant(CALC_job_type* job, int n_steps)
+{
+	TRACE_SPAN("generate ant");
+
+	// Get Langton's Ant pattern in the destination register
+	// Recurrent pattern starts after 9977 steps, which is (156 * 64) - 7.
+	// For convenience with 64-bit integer words, start the ant 7 steps into the first word,
+	// so the non-recurrent part of the ant trail is 156 words long.
+	TURMITE_set_rule(CALC_get_turmite(job), "RL");
+	CALC_turmite(job, n_steps, 64 - 7);
+}
+
+/******************************************************************************
+** Function:	Split Langton's Ant trail into integer & fractional parts
+**
+** Notes:
+*/
+void CALC_ant_parts(CALC_job_type* job)
+{
+	CALC_generate_ant(job, CALC_LANGTON_ITERATIONS);
+
+	// Get just the integer & fractional parts
+	// Recurrent pattern starts after 9977 steps, which is (156 * 64) - 7.
+	// Number of 64-bit words = 156
+	// Integer part goes at the LS end of the trail_integer register
+	job->alu.shr(job->trail_integer, job->ant_trail, ALU_LENGTH_U64 - CALC_ANT_INTEGER_WORDS);
+
+	// Fractional part goes at the MS end of the trail_fraction register
+	job->alu.shr(job->trail_fraction, job->ant_trail, -CALC_ANT_INTEGER_WORDS);
+}
+
+/******************************************************************************
+** Function:	Calculate A and B, where L = A / B
+**
+** Notes:		Needs CALC_ant_parts first. Leaves A in a, B in r2 and L in bc.
+**				L is the trail as a binary number: the steps before the trail
+**				repeats are the integer part, & the repeats the fraction.
+*/
+void CALC_ant_ab(CALC_job_type* job)
+{
+	TRACE_SPAN("A & B");
+
+	// The ant starts 7 steps into the first word of ant_trail:
+	CALC_periodic(job, job->ant_trail, ALU_LENGTH_U64, 7, CALC_LANGTON_PRE_PERIOD, CALC_LANGTON_PERIOD);
+
+	job->alu.div(job->bc, job->a, job->r2);								// bc = A/B
+}
+
+/******************************************************************************
+** Function:	Stream an LS-word-first value to alu.p_output, MS word first
+**
+** Notes:		The ring holds words in the order the antplot walks them,
+**				so the value is reversed a block at a time
+*/
+void calc_push(CALC_job_type* job, const uint64* v, int length_words)
+{
+	uint64 block[RING_BLOCK_U64];
+
+	if (job->alu.p_output == NULL)
+		return;
+
+	for (int i = 0; i < length_words; i += RING_BLOCK_U64)
+	{
+		int n = (length_words - i < RING_BLOCK_U64) ? length_words - i : RING_BLOCK_U64;
+		for (int j = 0; j < n; j++)
+			block[j] = v[length_words - 1 - i - j];
+
+		job->alu.p_output->push(block, n, &job->cancel);
+	}
+}
+
+/******************************************************************************
+** Function:	Reciprocal of a 64-bit integer value into hl
+**
+** Notes:		For v > 1, long division of 1 by v, MS word first, so each word
+**				is final as soon as it is produced and can be streamed to
+**				alu.p_output while later words are still being computed.
+**				The LS bit is left clear, matching 2 * (0.5 / v) as before.
+*/
+void CALC_reciprocal(CALC_job_type* job, uint64 v)
+{
+	TRACE_SPAN("reciprocal");
+	uint64 block[RING_BLOCK_U64];
+	uint64 remainder = 0UI64;
+
+	if (v < 2UI64)									// 1 / 1 has no fractional bits; 1 / 0 traps
+	{
+		// Compute 0.5 / v:
+		memset(job->hl, 0, sizeof(job->hl));
+		job->hl[2 * ALU_LENGTH_U64 - 1] = 1UI64 << 63;
+		job->alu.div_u64(job->hl, v, 2 * ALU_LENGTH_U64, &remainder);
+
+		// correct to 1 / v:
+		job->alu.adc(job->hl, job->hl, 2 * ALU_LENGTH_U64);
+
+		calc_push(job, job->hl, 2 * ALU_LENGTH_U64);
+		return;
+	}
+
+	TRACE_COUNT(TRACE_COUNTER_LIMBS, 2 * ALU_LENGTH_U64);
+	TRACE_COUNT(TRACE_COUNTER_DIVISIONS, 2 * ALU_LENGTH_U64);
+	remainder = 1UI64;
+	for (int i = 0; i < 2 * ALU_LENGTH_U64; i += RING_BLOCK_U64)
+	{
+		if (job->cancel)
+			return;
+
+		for (int j = 0; j < RING_BLOCK_U64; j++)
+			block[j] = _udiv128(remainder, 0UI64, v, &remainder);
+
+		if (i + RING_BLOCK_U64 == 2 * ALU_LENGTH_U64)
+			block[RING_BLOCK_U64 - 1] &= ~1UI64;
+
+		for (int j = 0; j < RING_BLOCK_U64; j++)
+			job->hl[2 * ALU_LENGTH_U64 - 1 - i - j] = block[j];
+
+		if (job->alu.p_output != NULL)
+			job->alu.p_output->push(block, RING_BLOCK_U64, &job->cancel);
+	}
+}
+
+/******************************************************************************
+** Function:	One quotient word of a multi-word division
+**
+** Notes:		Knuth's Algorithm D, step D3 to D6. u holds n + 1 words and
+**				d holds n words, both LS word first, with d normalised (MS bit
+**				set) and u < d << 64. Returns u / d and leaves the remainder in
+**				u[0..n-1], with u[n] = 0.
+*/
+uint64 calc_div_step(uint64* u, const uint64* d, int n)
+{
+	uint64 qhat, rhat, hi, lo;
+	bool rhat_overflow = false;
+
+	if (n == 1)
+	{
+		qhat = _udiv128(u[1], u[0], d[0], &u[0]);
+		u[1] = 0UI64;
+		return qhat;
+	}
+
+	// Estimate from the top two words of u & top word of d. Never too small, at most 2 too big:
+	if (u[n] == d[n - 1])
+	{
+		qhat = ~0UI64;
+		rhat = u[n - 1] + d[n - 1];
+		rhat_overflow = (rhat < d[n - 1]);
+	}
+	else
+		qhat = _udiv128(u[n], u[n - 1], d[n - 1], &rhat);
+
+	// Correct using the second word of d:
+	while (!rhat_overflow)
+	{
+		lo = _umul128(qhat, d[n - 2], &hi);
+		if ((hi < rhat) || ((hi == rhat) && (lo <= u[n - 2])))
+			break;
+
+		qhat--;
+		rhat += d[n - 1];
+		rhat_overflow = (rhat < d[n - 1]);
+	}
+
+	// u -= qhat * d:
+	uint64 carry = 0UI64;
+	uint8 borrow = 0;
+	for (int i = 0; i < n; i++)
+	{
+		lo = _umul128(qhat, d[i], &hi);
+		carry = hi + _addcarry_u64(0, lo, carry, &lo);
+		borrow = _subborrow_u64(borrow, u[i], lo, &u[i]);
+	}
+	borrow = _subborrow_u64(borrow, u[n], carry, &u[n]);
+
+	if (borrow != 0)								// rare: qhat was still 1 too big, so add d back
+	{
+		uint8 c = 0;
+		qhat--;
+		for (int i = 0; i < n; i++)
+			c = _addcarry_u64(c, u[i], d[i], &u[i]);
+		u[n] = 0UI64;
+	}
+
+	TRACE_COUNT(TRACE_COUNTER_LIMBS, n);
+	TRACE_COUNT(TRACE_COUNTER_DIVISIONS, 1);
+	return qhat;
+}
+
+/******************************************************************************
+** Function:	Word k of num << s, MS word first
+**
+** Notes:		Word 0 holds the bits shifted out of the top of num. Words
+**				beyond the end of num are 0.
+*/
+uint64 calc_dividend_word(CALC_job_type* job, uint64 k, int s)
+{
+	uint64 w = ((k >= 1) && (k <= ALU_LENGTH_U64)) ? (job->num[ALU_LENGTH_U64 - k] << s) : 0UI64;
+
+	if ((s != 0) && (k < ALU_LENGTH_U64))
+		w |= job->num[ALU_LENGTH_U64 - 1 - k] >> (64 - s);
+
+	return w;
+}
+
+/******************************************************************************
+** Function:	Binary expansion of num / den
+**
+** Notes:		Same layout as ALU div: ALU_LENGTH_U64 integer words above
+**				fraction_words words after the point. Word-at-a-time long
+**				division, so the cost is O(words of den) per output word.
+**				The first 2 * ALU_LENGTH_U64 words are kept in hl, MS word at
+**				the top, as a value with the point in the middle; all words
+**				are streamed to alu.p_output if set, so the expansion can be
+**				longer than hl. Returns false if den is zero.
+*/
+bool CALC_rational(CALC_job_type* job, uint64 fraction_words)
+{
+	uint64 block[RING_BLOCK_U64];
+	int top, s, i;
+
+	TRACE_SPAN("rational");
+
+	for (top = ALU_LENGTH_U64 - 1; top >= 0; top--)		// find MS word of den
+	{
+		if (job->den[top] != 0UI64)
+			break;
+	}
+	if (top < 0)
+		return false;
+
+	int n = top + 1;									// words in den
+	for (s = 0; ((job->den[top] << s) >> 63) == 0UI64; s++)		// normalising shift
+		;
+
+	// Normalise den:
+	for (i = 0; i < n; i++)
+	{
+		job->rat_d[i] = job->den[i] << s;
+		if ((s != 0) && (i > 0))
+			job->rat_d[i] |= job->den[i - 1] >> (64 - s);
+	}
+	memset(job->rat_u, 0, sizeof(job->rat_u));
+
+	job->rat_u[0] = calc_dividend_word(job, 0, s);
+	calc_div_step(job->rat_u, job->rat_d, n);			// top word of quotient is always 0
+
+	uint64 total = ALU_LENGTH_U64 + fraction_words;
+	job->progress_total = total;
+	for (uint64 k = 0; k < total; k += RING_BLOCK_U64)
+	{
+		if (job->cancel)
+			return true;
+
+		int count = (total - k < RING_BLOCK_U64) ? (int)(total - k) : RING_BLOCK_U64;
+		for (i = 0; i < count; i++)
+		{
+			memmove(&job->rat_u[1], &job->rat_u[0], n * sizeof(uint64));
+			job->rat_u[0] = calc_dividend_word(job, k + i + 1, s);
+			block[i] = calc_div_step(job->rat_u, job->rat_d, n);
+
+			if (k + i < 2 * ALU_LENGTH_U64)
+				job->hl[2 * ALU_LENGTH_U64 - 1 - (k + i)] = block[i];
+		}
+
+		if (job->alu.p_output != NULL)
+			job->alu.p_output->push(block, count, &job->cancel);
+		job->progress = k + count;
+	}
+
+	// Clear any part of hl not reached:
+	if (total < 2 * ALU_LENGTH_U64)
+		memset(job->hl, 0, (2 * ALU_LENGTH_U64 - total) * sizeof(uint64));
+
+	return true;
+}
+
+/******************************************************************************
+** Function:	Is x >= m? Both n words, LS word first
+**
+** Notes:
+*/
+bool calc_at_least(const uint64* x, const uint64* m, int n)
+{
+	for (int i = n - 1; i >= 0; i--)
+	{
+		if (x[i] != m[i])
+			return x[i] > m[i];
+	}
+
+	return true;
+}
+
+/******************************************************************************
+** Function:	x = x - m, n words, LS word first
+**
+** Notes:
+*/
+void calc_sub_words(uint64* x, const uint64* m, int n)
+{
+	uint8 borrow = 0;
+
+	for (int i = 0; i < n; i++)
+		borrow = _subborrow_u64(borrow, x[i], m[i], &x[i]);
+}
+
+/******************************************************************************
+** Function:	x = 2 x mod m
+**
+** Notes:		x < m, both n words, LS word first
+*/
+void calc_mod_double(uint64* x, const uint64* m, int n)
+{
+	uint64 top = x[n - 1] >> 63;
+
+	for (int i = n - 1; i > 0; i--)
+		x[i] = (x[i] << 1) | (x[i - 1] >> 63);
+	x[0] <<= 1;
+
+	if ((top != 0UI64) || calc_at_least(x, m, n))
+		calc_sub_words(x, m, n);
+}
+
+/******************************************************************************
+** Function:	x = x y / 2^(64 n) mod m, by Montgomery multiplication
+**
+** Notes:		m is odd, & m_inv = -1 / m mod 2^64. x, y & m have n words,
+**				LS word first, with x & y < m; y may be x. t holds n + 2
+**				words. Each word of y is added in & a multiple of m cleared
+**				from the bottom word in turn, so there's no division.
+*/
+void calc_mont_mul(uint64* x, const uint64* y, const uint64* m, uint64 m_inv, uint64* t, int n)
+{
+	uint64 hi, lo, c;
+
+	memset(t, 0, (n + 2) * sizeof(uint64));
+	for (int i = 0; i < n; i++)
+	{
+		// t += x * y[i]:
+		c = 0UI64;
+		for (int j = 0; j < n; j++)
+		{
+			lo = _umul128(x[j], y[i], &hi);
+			hi += _addcarry_u64(0, lo, c, &lo);
+			c = hi + _addcarry_u64(0, t[j], lo, &t[j]);
+		}
+		t[n + 1] = _addcarry_u64(0, t[n], c, &t[n]);
+
+		// t = (t + q * m) / 2^64, with q making the bottom word 0:
+		uint64 q = t[0] * m_inv;
+		lo = _umul128(q, m[0], &hi);
+		c = hi + _addcarry_u64(0, t[0], lo, &lo);
+		for (int j = 1; j < n; j++)
+		{
+			lo = _umul128(q, m[j], &hi);
+			hi += _addcarry_u64(0, lo, c, &lo);
+			c = hi + _addcarry_u64(0, t[j], lo, &t[j - 1]);
+		}
+		t[n] = t[n + 1] + _addcarry_u64(0, t[n], c, &t[n - 1]);
+		t[n + 1] = 0UI64;
+	}
+
+	TRACE_COUNT(TRACE_COUNTER_LIMBS, 2 * n * n);
+
+	// t < 2 m:
+	if ((t[n] != 0UI64) || calc_at_least(t, m, n))
+		calc_sub_words(t, m, n);
+	memcpy(x, t, n * sizeof(uint64));
+}
+
+/******************************************************************************
+** Function:	mont_x = 2^e mod mont_m
+**
+** Notes:		mont_m has n words & is odd. Left to right binary powering in
+**				Montgomery form, where doubling is as cheap as mod m. Gives up
+**				if the job is cancelled.
+*/
+void calc_pow2_mod(CALC_job_type* job, uint64 e, int n)
+{
+	uint64* m = job->mont_m;
+	uint64* x = job->mont_x;
+
+	// -1 / m mod 2^64 by Newton's method; m is its own inverse mod 8, & each step doubles the bits:
+	uint64 m_inv = m[0];
+	for (int i = 0; i < 5; i++)
+		m_inv *= 2UI64 - m[0] * m_inv;
+	m_inv = 0UI64 - m_inv;
+
+	// 2^(64 n) mod m, which is 1 in Montgomery form:
+	memset(x, 0, n * sizeof(uint64));
+	x[0] = ((n == 1) && (m[0] == 1UI64)) ? 0UI64 : 1UI64;
+	for (int i = 0; i < 64 * n; i++)
+		calc_mod_double(x, m, n);
+
+	for (int bit = 63; bit >= 0; bit--)
+	{
+		if (job->cancel)
+			return;
+
+		calc_mont_mul(x, x, m, m_inv, job->mont_t, n);
+		if (((e >> bit) & 1UI64) != 0UI64)
+			calc_mod_double(x, m, n);
+	}
+
+	// Out of Montgomery form:
+	memset(job->mont_y, 0, n * sizeof(uint64));
+	job->mont_y[0] = 1UI64;
+	calc_mont_mul(x, job->mont_y, m, m_inv, job->mont_t, n);
+}
+
+/******************************************************************************
+** Function:	Binary expansion of 1 / den from bit k after the point
+**
+** Notes:		As CALC_rational, with num = 2^k mod den: bits k onwards of
+**				1 / den are the expansion of (2^k mod den) / den. Where den
+**				= m 2^s with m odd, 2^k mod den = 2^s (2^(k - s) mod m) for
+**				k >= s, found by Montgomery multiplication mod m in O(log k)
+**				products, so a window far along doesn't cost the bits before
+**				it. Returns false if den is zero, or m is more than
+**				CALC_WINDOW_MAX_WORDS words.
+*/
+bool CALC_reciprocal_window(CALC_job_type* job, uint64 k, uint64 fraction_words)
+{
+	int low, top, i;
+	unsigned long low_bit;
+
+	TRACE_SPAN("reciprocal window");
+
+	for (low = 0; (low < ALU_LENGTH_U64) && (job->den[low] == 0UI64); low++)
+		;
+	if (low == ALU_LENGTH_U64)
+		return false;
+
+	for (top = ALU_LENGTH_U64 - 1; job->den[top] == 0UI64; top--)
+		;
+
+	// m = den >> s:
+	_BitScanForward64(&low_bit, job->den[low]);
+	int b = (int)low_bit;
+	uint64 s = 64 * (uint64)low + b;
+	int n = top - low + 1;
+	if ((b != 0) && ((job->den[top] >> b) == 0UI64))
+		n--;
+	if (n > CALC_WINDOW_MAX_WORDS)
+		return false;
+
+	for (i = 0; i < n; i++)
+	{
+		job->mont_m[i] = job->den[low + i] >> b;
+		if ((b != 0) && (low + i + 1 <= top))
+			job->mont_m[i] |= job->den[low + i + 1] << (64 - b);
+	}
+
+	memset(job->num, 0, sizeof(job->num));
+	if (k < s)
+		job->num[k >> 6] = 1UI64 << (k & 63);
+	else
+	{
+		calc_pow2_mod(job, k - s, n);
+		if (job->cancel)
+			return true;
+
+		// num = mont_x << s, which is below den:
+		for (i = 0; i < n; i++)
+		{
+			job->num[low + i] |= job->mont_x[i] << b;
+			if ((b != 0) && (low + i + 1 < ALU_LENGTH_U64))
+				job->num[low + i + 1] |= job->mont_x[i] >> (64 - b);
+		}
+	}
+
+	return CALC_rational(job, fraction_words);
+}
+
+/******************************************************************************
+** Function:	64 bits of the bit string of v, from bit pos
+**
+** Notes:		The bit string is v MS bit first: bit 0 is the MS bit of
+**				v[length_words - 1]. Bits outside v are 0.
+*/
+uint64 calc_bits(const uint64* v, int length_words, int64 pos)
+{
+	ALU_view_type view = ALU_view(v, length_words);
+	int64 k = pos >> 6;
+	int s = (int)(pos & 63);
+	uint64 high64 = ((k >= 0) && (k < length_words)) ? view.word((int)k) : 0UI64;
+	uint64 low64 = ((k + 1 >= 0) && (k + 1 < length_words)) ? view.word((int)k + 1) : 0UI64;
+
+	return (s == 0) ? high64 : (high64 << s) | (low64 >> (64 - s));
+}
+
+/******************************************************************************
+** Function:	dest = bits [pos, pos + n_bits) of the bit string of v
+**
+** Notes:		dest is LS word first, CALC_GCD_WORDS long. Returns its length in words.
+*/
+int calc_get_bits(uint64* dest, const uint64* v, int length_words, int64 pos, int64 n_bits)
+{
+	int n = (int)((n_bits + 63) / 64);
+
+	memset(dest, 0, CALC_GCD_WORDS * sizeof(uint64));
+	for (int i = 0; i < n; i++)
+	{
+		int64 end = pos + n_bits - (64 * (int64)i);			// bit after the LS bit of word i
+		dest[i] = calc_bits(v, length_words, end - 64);
+	}
+
+	if ((n_bits & 63) != 0)
+		dest[n - 1] &= (1UI64 << (n_bits & 63)) - 1;
+
+	return n;
+}
+
+/******************************************************************************
+** Function:	dest = 2^n_bits - 1
+**
+** Notes:		dest is LS word first, CALC_GCD_WORDS long. Returns its length in words.
+*/
+int calc_ones(uint64* dest, int64 n_bits)
+{
+	int n = (int)((n_bits + 63) / 64);
+
+	memset(dest, 0, CALC_GCD_WORDS * sizeof(uint64));
+	memset(dest, 0xFF, n * sizeof(uint64));
+	if ((n_bits & 63) != 0)
+		dest[n - 1] = (1UI64 << (n_bits & 63)) - 1;
+
+	return n;
+}
+
+/******************************************************************************
+** Function:	Length of x in words, without leading zero words
+**
+** Notes:		LS word first
+*/
+int calc_length(const uint64* x, int n)
+{
+	while ((n > 0) && (x[n - 1] == 0UI64))
+		n--;
+
+	return n;
+}
+
+/******************************************************************************
+** Function:	Copy a value of n words to a register
+**
+** Notes:		Returns false if it doesn't fit
+*/
+bool calc_to_reg(ALU_reg dest, const uint64* x, int n)
+{
+	n = calc_length(x, n);
+	if (n > ALU_LENGTH_U64)
+		return false;
+
+	memset(dest, 0, ALU_LENGTH_BYTES);
+	memcpy(dest, x, n * sizeof(uint64));
+
+	return true;
+}
+
+/******************************************************************************
+** Function:	dest = a * x + b * y, all n words, LS word first
+**
+** Notes:		a & b have opposite signs, or one is 0, and the result must be
+**				between 0 and 2^(64 n). dest may be x or y. The term added is
+**				picked by the sign of the nonzero one, as after a single
+**				Lehmer step a is 0 & b is 1.
+*/
+void calc_lin_comb(uint64* dest, const uint64* x, int64 a, const uint64* y, int64 b, int n)
+{
+	bool add_x = (a > 0) || (b < 0);
+	const uint64* p = add_x ? x : y;						// the term added
+	const uint64* q = add_x ? y : x;						// the term subtracted
+	uint64 m_p = add_x ? (uint64)a : (uint64)b;
+	uint64 m_q = add_x ? (uint64)-b : (uint64)-a;
+	uint64 carry_p = 0UI64, carry_q = 0UI64;
+	uint64 low_p, low_q, high64;
+	uint8 borrow = 0;
+
+	TRACE_COUNT(TRACE_COUNTER_LIMBS, n);
+	for (int i = 0; i < n; i++)
+	{
+		low_p = _umul128(m_p, p[i], &high64);
+		carry_p = high64 + _addcarry_u64(0, low_p, carry_p, &low_p);
+
+		low_q = _umul128(m_q, q[i], &high64);
+		carry_q = high64 + _addcarry_u64(0, low_q, carry_q, &low_q);
+
+		borrow = _subborrow_u64(borrow, low_p, low_q, &dest[i]);
+	}
+}
+
+/******************************************************************************
+** Function:	u = u mod v, LS word first
+**
+** Notes:		u has nu words & room for one more; v has nv words, nv <= nu,
+**				& its top word isn't 0. Knuth's Algorithm D, using calc_div_step.
+*/
+void calc_mod(CALC_job_type* job, uint64* u, int nu, const uint64* v, int nv)
+{
+	unsigned long top_bit;
+	int i;
+
+	_BitScanReverse64(&top_bit, v[nv - 1]);
+	int s = 63 - (int)top_bit;
+
+	// Normalise, so the top bit of the divisor is set:
+	for (i = nv - 1; i >= 0; i--)
+		job->gcd_d[i] = (s == 0) ? v[i] : (v[i] << s) | ((i > 0) ? v[i - 1] >> (64 - s) : 0UI64);
+
+	u[nu] = (s == 0) ? 0UI64 : u[nu - 1] >> (64 - s);
+	for (i = nu - 1; i >= 0; i--)
+		u[i] = (s == 0) ? u[i] : (u[i] << s) | ((i > 0) ? u[i - 1] >> (64 - s) : 0UI64);
+
+	for (i = nu - nv; i >= 0; i--)
+		calc_div_step(&u[i], job->gcd_d, nv);
+
+	// Remainder is in u[0..nv - 1]:
+	for (i = 0; i < nv; i++)
+		u[i] = (s == 0) ? u[i] : (u[i] >> s) | ((i < nv - 1) ? u[i + 1] << (64 - s) : 0UI64);
+	memset(&u[nv], 0, (nu + 1 - nv) * sizeof(uint64));
+}
+
+/******************************************************************************
+** Function:	Top 64 bits of the n-word value x, from s bits below the top
+**
+** Notes:		LS word first
+*/
+uint64 calc_top(const uint64* x, int n, int s)
+{
+	uint64 high64 = x[n - 1];
+	uint64 low64 = (n >= 2) ? x[n - 2] : 0UI64;
+
+	return (s == 0) ? high64 : (high64 << s) | (low64 >> (64 - s));
+}
+
+/******************************************************************************
+** Function:	u = gcd(u, v), both n words, LS word first. v is destroyed.
+**
+** Notes:		Lehmer's algorithm (Knuth's Algorithm L): runs Euclid on the top
+**				62 bits only, for as long as the quotients are sure to be the
+**				same as for the full values, then applies all those steps to
+**				u & v at once with one linear combination. So each pass over
+**				the full values does about 30 steps, not 1. A full division is
+**				only needed when the top bits of u & v are far apart.
+**				Returns the length of the result in words.
+*/
+int calc_gcd(CALC_job_type* job, uint64* u, uint64* v, int n)
+{
+	uint64* x = u;
+	uint64* y = v;
+	uint64* t = job->gcd_t;
+	uint64* swap;
+	int nx = calc_length(x, n);
+	int ny = calc_length(y, n);
+
+	TRACE_SPAN("Lehmer GCD");
+
+	if ((ny > nx) || ((ny == nx) && (ny > 0) && (y[ny - 1] > x[nx - 1])))
+	{
+		swap = x; x = y; y = swap;
+		nx = ny;
+		ny = calc_length(y, n);
+	}
+
+	while ((ny > 0) && !job->cancel)
+	{
+		if (nx == 1)												// down to single words
+		{
+			uint64 a = x[0], b = y[0];
+			while (b != 0UI64)
+			{
+				uint64 r = a % b;
+				a = b;
+				b = r;
+			}
+			x[0] = a;
+			y[0] = 0UI64;
+			break;
+		}
+
+		unsigned long top_bit;
+		_BitScanReverse64(&top_bit, x[nx - 1]);
+		int s = 63 - (int)top_bit;
+		uint64 x_top = calc_top(x, nx, s) >> 2;
+		uint64 y_top = (ny >= nx - 1) ? calc_top(y, nx, s) >> 2 : 0UI64;
+		int64 a = 1, b = 0, c = 0, d = 1;
+
+		while (((y_top + (uint64)c) != 0UI64) && ((y_top + (uint64)d) != 0UI64))
+		{
+			uint64 q = (x_top + (uint64)a) / (y_top + (uint64)c);
+			if (q != (x_top + (uint64)b) / (y_top + (uint64)d))
+				break;
+
+			int64 temp = a - (int64)q * c;
+			a = c;
+			c = temp;
+			temp = b - (int64)q * d;
+			b = d;
+			d = temp;
+			uint64 top = x_top - q * y_top;
+			x_top = y_top;
+			y_top = top;
+		}
+
+		if (b == 0)													// no single-word steps: full division
+		{
+			calc_mod(job, x, nx, y, ny);
+			swap = x; x = y; y = swap;
+			nx = ny;
+		}
+		else
+		{
+			calc_lin_comb(t, x, a, y, b, nx);
+			calc_lin_comb(y, x, c, y, d, nx);
+			swap = x; x = t; t = swap;
+		}
+
+		nx = calc_length(x, nx);
+		ny = calc_length(y, nx);
+	}
+
+	if (x != u)
+		memcpy(u, x, n * sizeof(uint64));
+	memset(&u[nx], 0, (CALC_GCD_WORDS - nx) * sizeof(uint64));
+
+	return nx;
+}
+
+/******************************************************************************
+** Function:	q = a / g where g divides a exactly & g is odd, LS word first
+**
+** Notes:		Hensel division, from the LS end: each quotient word is
+**				the low word of what is left times 1 / g mod 2^64, so there
+**				is no estimate to correct & no normalising. a is destroyed.
+*/
+void calc_exact_div(uint64* q, uint64* a, int na, const uint64* g, int ng)
+{
+	uint64 inverse = g[0];										// right to 3 bits, as g is odd
+	for (int i = 0; i < 5; i++)									// Newton: 6, 12, 24, 48, 96 bits
+		inverse *= 2UI64 - g[0] * inverse;
+
+	memset(q, 0, CALC_GCD_WORDS * sizeof(uint64));
+	TRACE_COUNT(TRACE_COUNTER_LIMBS, (uint64)(na - ng + 1) * ng);
+	for (int i = 0; i <= na - ng; i++)
+	{
+		uint64 qi = a[i] * inverse;
+		uint64 carry = 0UI64, low64, high64;
+		uint8 borrow = 0;
+		int j;
+
+		for (j = 0; j < ng; j++)								// a -= qi * g << (64 * i)
+		{
+			low64 = _umul128(qi, g[j], &high64);
+			carry = high64 + _addcarry_u64(0, low64, carry, &low64);
+			borrow = _subborrow_u64(borrow, a[i + j], low64, &a[i + j]);
+		}
+		for (j = i + ng; (j < na) && ((carry | borrow) != 0UI64); j++)
+		{
+			borrow = _subborrow_u64(borrow, a[j], carry, &a[j]);
+			carry = 0UI64;
+		}
+
+		q[i] = qi;
+	}
+}
+
+/******************************************************************************
+** Function:	Find where a trail starts repeating, & its period
+**
+** Notes:		Looks at bits [start_bit, n_bits) of the trail, MS bit first.
+**				For each period up to max_period, finds the first bit from
+**				which the rest of the trail repeats with that period, and
+**				keeps the period which repeats from earliest, if it repeats
+**				CALC_MIN_REPEATS times & for CALC_MIN_REPEAT_BITS. Returns
+**				false if none does.
+*/
+bool CALC_find_period(const uint64* trail, int trail_words, uint64 n_bits, uint64 start_bit, uint64 max_period,
+	uint64* p_pre_bits, uint64* p_period_bits)
+{
+	uint64 best_start = n_bits;
+
+	TRACE_SPAN("find period");
+
+	for (uint64 q = 1; (q <= max_period) && (start_bit + (CALC_MIN_REPEATS * q) <= n_bits); q++)
+	{
+		// Compare bit i with bit i + q, for i back from the end, a word at a time:
+		int64 i = (int64)(n_bits - q);
+		int64 repeat_start = (int64)start_bit;
+		while (i > (int64)start_bit)
+		{
+			int64 w = (i - (int64)start_bit >= 64) ? 64 : i - (int64)start_bit;
+			i -= w;
+
+			uint64 x = calc_bits(trail, trail_words, i) ^ calc_bits(trail, trail_words, i + q);
+			if (w < 64)
+				x &= ~(~0UI64 >> w);								// only the first w bits
+			unsigned long low_bit;
+			if (_BitScanForward64(&low_bit, x))
+			{
+				repeat_start = i + 64 - (int64)low_bit;				// just after the last mismatch
+				break;
+			}
+		}
+
+		uint64 repeat_bits = n_bits - (uint64)repeat_start;
+		if ((repeat_bits >= CALC_MIN_REPEATS * q) && (repeat_bits >= CALC_MIN_REPEAT_BITS) && ((uint64)repeat_start < best_start))
+		{
+			best_start = (uint64)repeat_start;
+			*p_pre_bits = best_start - start_bit;
+			*p_period_bits = q;
+		}
+	}
+
+	return best_start < n_bits;
+}
+
+/******************************************************************************
+** Function:	A / B for a trail which repeats, reduced to lowest terms
+**
+** Notes:		The trail starts at start_bit, counting from its MS bit. Its
+**				first pre_bits bits are the integer part I, & the next
+**				period_bits bits, P, repeat forever after the binary point:
+**					I + P / (2^q - 1), where q = period_bits
+**				Any common factor of A & B is a factor of P & 2^q - 1, so
+**				g = gcd(P, 2^q - 1) gives
+**					B = (2^q - 1) / g,  C = P / g,  A = B * I + C
+**				Leaves A in a & B in r2, using hl, r1 & trail_integer.
+**				Returns false if A would be too big for a register.
+**				A short period with an integer part of up to
+**				CALC_ANT_INTEGER_WORDS words, as Langton's ant has, makes
+**				A = B * I + C in fixed-width values.
+*/
+bool CALC_periodic(CALC_job_type* job, const uint64* trail, int trail_words, uint64 start_bit, uint64 pre_bits, uint64 period_bits)
+{
+	if ((period_bits == 0UI64) || (pre_bits + period_bits > 64 * ALU_LENGTH_U64))
+		return false;
+
+	// g = gcd(P, 2^q - 1), into gcd_u:
+	int nq = calc_ones(job->gcd_u, period_bits);
+	calc_get_bits(job->gcd_v, trail, trail_words, start_bit + pre_bits, period_bits);
+	int ng = calc_gcd(job, job->gcd_u, job->gcd_v, nq);
+	if (job->cancel)
+		return true;
+
+	// B = (2^q - 1) / g, into r2; g is odd, as 2^q - 1 is:
+	calc_ones(job->gcd_v, period_bits);
+	calc_exact_div(job->gcd_t, job->gcd_v, nq, job->gcd_u, ng);
+	calc_to_reg(job->r2, job->gcd_t, nq);
+
+	// C = P / g, into r1:
+	calc_get_bits(job->gcd_v, trail, trail_words, start_bit + pre_bits, period_bits);
+	calc_exact_div(job->gcd_t, job->gcd_v, nq, job->gcd_u, ng);
+	calc_to_reg(job->r1, job->gcd_t, nq);
+
+	// I into trail_integer:
+	int ni = calc_get_bits(job->gcd_v, trail, trail_words, start_bit, pre_bits);
+	calc_to_reg(job->trail_integer, job->gcd_v, ni);
+
+	// A = B * I + C; it fits, as it has at most pre_bits + period_bits bits:
+	if ((nq <= 2) && (ni <= CALC_ANT_INTEGER_WORDS))
+	{
+		ALU_fixed_type<2 + CALC_ANT_INTEGER_WORDS> a = ALU_fixed_mul(ALU_fixed_type<2>::from_reg(job->r2),
+			ALU_fixed_type<CALC_ANT_INTEGER_WORDS>::from_reg(job->trail_integer));
+		a.adc(ALU_fixed_type<2>::from_reg(job->r1));
+		a.to_reg(job->a);
+		return true;
+	}
+
+	// Else multiply just the words in use:
+	int n = (ni > nq) ? ni : nq;
+	if (n == 0)
+		n = 1;
+	memset(job->hl, 0, sizeof(job->hl));
+	job->alu.mul_words(job->hl, job->r2, job->trail_integer, n);
+	memcpy(job->a, job->hl, sizeof(job->a));
+	job->alu.adc(job->a, job->r1, ALU_LENGTH_U64);
+
+	return true;
+}
+
+/******************************************************************************
+** Function:	Fixed-point multiply, dest = a * b, all w words
+**
+** Notes:		Word w - 1 is the integer part. The product is truncated.
+**				dest may be a or b. Returns false if the integer part overflows.
+*/
+bool calc_fix_mul(CALC_job_type* job, uint64* dest, uint64* a, uint64* b, int w)
+{
+	job->alu.mul_words(job->root_product, a, b, w);
+	memcpy(dest, &job->root_product[w - 1], w * sizeof(uint64));
+
+	return job->root_product[2 * w - 1] == 0UI64;
+}
+
+/******************************************************************************
+** Function:	Fixed-point signed add, a += b, all w words
+**
+** Notes:		Sign & magnitude: *p_a_negative is the sign of a. Returns
+**				false if the integer part overflows.
+*/
+bool calc_fix_add(CALC_job_type* job, uint64* a, bool* p_a_negative, uint64* b, bool b_negative, int w)
+{
+	if (*p_a_negative == b_negative)
+		return job->alu.adc(a, b, w) == 0;
+
+	if (job->alu.sub(a, b, w) != 0)				// |b| > |a|, so negate a
+	{
+		for (int i = 0; i < w; i++)
+			a[i] = ~a[i];
+		job->alu.add_u64(a, 0, 1UI64, w);
+		*p_a_negative = !*p_a_negative;
+	}
+	return true;
+}
+
+/******************************************************************************
+** Function:	Fixed-point value from a double
+**
+** Notes:		0 <= v < 2^63. Only the first fraction word is set.
+*/
+void calc_fix_from_double(uint64* dest, double v, int w)
+{
+	double fraction = (v - floor(v)) * 18446744073709551616.0;
+
+	memset(dest, 0, w * sizeof(uint64));
+	dest[w - 1] = (uint64)v;
+	dest[w - 2] = (fraction >= 18446744073709551616.0) ? ~0UI64 : (uint64)fraction;	// rounded up to 2^64
+}
+
+/******************************************************************************
+** Function:	Magnitude of coefficient i of the polynomial or its derivative
+**
+** Notes:		Sign in *p_negative. Returns false if it needs over 64 bits.
+*/
+bool calc_poly_coefficient(CALC_job_type* job, bool derivative, int i, uint64* p_magnitude, bool* p_negative)
+{
+	int64 c = job->poly[i];
+	uint64 high;
+
+	*p_negative = (c < 0);
+	*p_magnitude = (c < 0) ? 0UI64 - (uint64)c : (uint64)c;	// also for INT64_MIN
+	if (derivative)
+	{
+		*p_magnitude = _umul128(*p_magnitude, (uint64)i, &high);
+		if (high != 0UI64)
+			return false;
+	}
+	return true;
+}
+
+/******************************************************************************
+** Function:	Evaluate polynomial, or its derivative, at x into root_v
+**
+** Notes:		Horner's rule on the top w words, from the leading
+**				coefficient. x >= 0. Returns sign of result in *p_negative,
+**				and false on overflow.
+*/
+bool calc_poly_eval(CALC_job_type* job, bool derivative, int w, bool* p_negative)
+{
+	int d = job->poly_degree;
+	uint64* x = &job->root_x[CALC_ROOT_WORDS - w];
+	uint64* v = &job->root_v[CALC_ROOT_WORDS - w];
+	uint64* t = &job->root_t[CALC_ROOT_WORDS - w];
+	uint64 c;
+	bool c_negative;
+
+	memset(v, 0, w * sizeof(uint64));
+	if (!calc_poly_coefficient(job, derivative, d, &v[w - 1], p_negative))
+		return false;
+
+	for (int i = d - 1; i >= (derivative ? 1 : 0); i--)
+	{
+		if (!calc_fix_mul(job, v, v, x, w) || !calc_poly_coefficient(job, derivative, i, &c, &c_negative))
+			return false;
+
+		memset(t, 0, w * sizeof(uint64));
+		t[w - 1] = c;
+		if (!calc_fix_add(job, v, p_negative, t, c_negative, w))
+			return false;
+	}
+
+	return true;
+}
+
+/******************************************************************************
+** Function:	Value of polynomial or its derivative, in double precision
+**
+** Notes:
+*/
+double calc_poly_double(CALC_job_type* job, bool derivative, double x)
+{
+	double v = 0.0;
+
+	for (int i = job->poly_degree; i >= (derivative ? 1 : 0); i--)
+		v = (v * x) + (derivative ? (double)i * (double)job->poly[i] : (double)job->poly[i]);
+
+	return v;
+}
+
+/******************************************************************************
+** Function:	Root of poly near poly_guess, to full register precision
+**
+** Notes:		Newton iteration with precision doubling: each pass works at
+**				about twice the words of the one before, so the total cost is
+**				a small multiple of the cost at full length. Iterates x & z
+**				together, where z tends to 1 / p'(x), so no division is needed:
+**					x -= p(x) * z
+**					z *= 2 - p'(x) * z
+**				Each pass works on the top w words of the root_ registers.
+**				Leaves |root| in r1 (integer part in its MS word) and its sign in
+**				root_negative. Changes poly so the root & p'(root) are
+**				positive. Returns false if no simple root is found.
+*/
+bool CALC_poly_root(CALC_job_type* job)
+{
+	int widths[32];
+	int n_widths = 0;
+	bool negative, x_negative = false;
+
+	TRACE_SPAN("polynomial root");
+
+	// Coefficients are negated below, which INT64_MIN can't be:
+	for (int i = 0; i <= job->poly_degree; i++)
+	{
+		if (job->poly[i] == INT64_MIN)
+			return false;
+	}
+
+	// Refine the guess in double precision first:
+	double x = job->poly_guess;
+	for (int i = 0; i < 100; i++)
+	{
+		double dv = calc_poly_double(job, true, x);
+		if (dv == 0.0)
+			return false;
+		x -= calc_poly_double(job, false, x) / dv;
+	}
+	if (!(fabs(calc_poly_double(job, false, x)) <= 1e-9 * (1.0 + fabs(calc_poly_double(job, true, x)))))
+		return false;
+
+	// Make the root positive (p(-x)) & then p'(root) positive (-p(x)):
+	job->root_negative = (x < 0.0);
+	if (job->root_negative)
+	{
+		x = -x;
+		for (int i = 1; i <= job->poly_degree; i += 2)
+			job->poly[i] = -job->poly[i];
+	}
+	double dv = calc_poly_double(job, true, x);
+	if (dv < 0.0)
+	{
+		dv = -dv;
+		for (int i = 0; i <= job->poly_degree; i++)
+			job->poly[i] = -job->poly[i];
+	}
+	if ((x >= 9.2e18) || (1.0 / dv >= 9.2e18))
+		return false;
+
+	calc_fix_from_double(job->root_x, x, CALC_ROOT_WORDS);
+	calc_fix_from_double(job->root_z, 1.0 / dv, CALC_ROOT_WORDS);
+
+	// Working widths, from full length down, each half the last plus a guard word:
+	for (int w = CALC_ROOT_WORDS; w > 4; w = (w / 2) + 2)
+		widths[n_widths++] = w;
+	widths[n_widths++] = 4;
+	widths[n_widths++] = 3;
+	widths[n_widths++] = 3;							// 2 passes from the double guess
+
+	job->progress_total = n_widths;
+	for (int k = n_widths - 1; k >= 0; k--)
+	{
+		int w = widths[k];
+		uint64* root_x = &job->root_x[CALC_ROOT_WORDS - w];
+		uint64* root_z = &job->root_z[CALC_ROOT_WORDS - w];
+		uint64* root_v = &job->root_v[CALC_ROOT_WORDS - w];
+		uint64* root_t = &job->root_t[CALC_ROOT_WORDS - w];
+
+		if (job->cancel)
+			return false;
+
+		// x -= p(x) * z:
+		if (!calc_poly_eval(job, false, w, &negative) || !calc_fix_mul(job, root_t, root_v, root_z, w))
+			return false;
+		if (!calc_fix_add(job, root_x, &x_negative, root_t, !negative, w))
+			return false;
+
+		// z *= 2 - p'(x) * z:
+		if (!calc_poly_eval(job, true, w, &negative) || negative || !calc_fix_mul(job, root_v, root_v, root_z, w))
+			return false;
+		memset(root_t, 0, w * sizeof(uint64));
+		root_t[w - 1] = 2UI64;
+		negative = false;
+		if (!calc_fix_add(job, root_t, &negative, root_v, true, w) || negative || !calc_fix_mul(job, root_z, root_z, root_t, w))
+			return false;
+
+		if (x_negative)
+			return false;
+
+		job->progress++;
+	}
+
+	memcpy(job->r1, &job->root_x[CALC_ROOT_WORDS - ALU_LENGTH_U64], sizeof(job->r1));
+	return true;
+}
+
+/******************************************************************************
+** Function:	Factorial of n into f_reg
+**
+** Notes:		Continues from the factorial already held when n is larger,
+**				divides back down from it when n is a little smaller, else
+**				recalculates. Returns false on numeric overflow. If
+**				cancelled, f_reg is left holding f_n! for some f_n between.
+*/
+bool CALC_factorial(CALC_job_type* job, uint64 n)
+{
+	if (job->f_valid && (n < job->f_n) && (job->f_n - n <= CALC_FACTORIAL_MAX_BACK))	// divide back down
+	{
+		uint64 remainder;
+
+		job->progress_total = job->f_n - n;
+		for (; (job->f_n > n) && !job->cancel; job->f_n--)
+		{
+			job->alu.div_u64(job->f_reg, job->f_n, N_ELEMENTS(job->f_reg), &remainder);
+			job->progress++;
+		}
+		return true;
+	}
+
+	if (!job->f_valid || (n < job->f_n))							// redo full calculation
+	{
+		memset(job->f_reg, 0, sizeof(job->f_reg));
+		job->f_reg[0] = 1UI64;
+		job->f_n = 1UI64;
+		job->f_valid = true;
+	}
+
+	job->progress_total = n - job->f_n;
+	for (uint64 i = job->f_n + 1; i <= n; i++)
+	{
+		if (job->cancel)
+			break;
+
+		if (job->alu.mul_u64(job->f_reg, i, N_ELEMENTS(job->f_reg)) != 0UI64)
+		{
+			job->f_valid = false;
+			return false;
+		}
+		job->f_n = i;
+		job->progress++;
+	}
+
+	return true;
+}
+
+/******************************************************************************
+** Function:	Calculate e - 2 into hl
+**
+** Notes:		Takes ALU_MAX_TERMS terms per pass over the registers, and
+**				skips the leading zero words of the term as it shrinks.
+**				The sum is carry-saved until the end.
+*/
+void CALC_e(CALC_job_type* job)
+{
+	ACCUM_type acc;
+
+	TRACE_SPAN("e series");
+	memset(job->bc, 0, sizeof(job->bc));		// next term
+	job->bc[2 * ALU_LENGTH_U64 - 1] = 1UI64 << 63;
+	memset(job->hl, 0, sizeof(job->hl));		// value of e
+	job->hl[2 * ALU_LENGTH_U64 - 1] = 1UI64 << 63;
+	ACCUM_init(&acc, job->hl, job->carries, 2 * ALU_LENGTH_U64);
+
+	uint64 i = 2UI64;
+	uint64 divisors[ALU_MAX_TERMS];
+	int top_word = 2 * ALU_LENGTH_U64 - 1;
+	do
+	{
+		for (int k = 0; k < ALU_MAX_TERMS; k++)
+			divisors[k] = i++;
+
+		while ((top_word >= 0) && (job->bc[top_word] == 0UI64))
+			top_word--;
+
+		if (job->alu.div_chain_sum(&acc, job->bc, divisors, ALU_MAX_TERMS, top_word))
+			break;
+
+		job->progress = i;
+	} while (!job->cancel);
+	ACCUM_normalise(&acc);
+
+	// double it:
+	job->alu.adc(job->hl, job->hl, 2 * ALU_LENGTH_U64);
+}
+
+/******************************************************************************
+** Function:	Calculate pi using the BBP algorithm
+**
+** Notes:		Leaves pi / 8 in bc and the fractional part of pi in r1
+*  total = 0;
+*  for (i = 0; i < infinity; i++)
+*  {
+*      n = 8 * i;
+*      r = (4/(n + 1)) - (2/(n + 4)) - (1/(n + 5)) - (1/(n + 6))
+*      total += r >> (4 * i);
+*  }
+*				Terms i & i + 1 start in the same word, so all 8 of their
+*				quotients are added into bc in one pass. The sum is
+*				carry-saved until the end.
+*/
+void CALC_pi(CALC_job_type* job)
+{
+	ACCUM_type acc;
+
+	TRACE_SPAN("pi BBP series");
+	memset(job->bc, 0, sizeof(job->bc));		// value of pi
+	ACCUM_init(&acc, job->bc, job->carries, 2 * ALU_LENGTH_U64);
+
+	uint64 i = 0;
+	ALU_term_type terms[8];
+	job->progress_total = 2 * ALU_LENGTH_U64 * 16;		// terms until index runs off the end
+	do
+	{
+		int index = (int)i >> 4;											// word index, from the MS end
+		if (index >= 2 * ALU_LENGTH_U64)
+			break;
+
+		for (int j = 0; j < 2; j++)
+		{
+			uint64 n = (i + j) << 3;
+			int shift_count = 61 - (4 * ((i + j) & 0x0F));
+			ALU_term_type* t = &terms[4 * j];
+
+			t[0] = { 4UI64 << shift_count, n + 1, false };		// + 1 / (2 * (n + 1))
+			t[1] = { 2UI64 << shift_count, n + 4, true };		// - 1 / (4 * (n + 4))
+			t[2] = { 1UI64 << shift_count, n + 5, true };		// - 1 / (8 * (n + 5))
+			t[3] = { 1UI64 << shift_count, n + 6, true };		// - 1 / (8 * (n + 6))
+		}
+		job->alu.div_sum(&acc, terms, 8, 2 * ALU_LENGTH_U64 - 1 - index);
+
+		i += 2;
+		job->progress = i;
+
+	} while (!job->cancel);
+	ACCUM_normalise(&acc);
+
+	memcpy(job->r1, &job->bc[ALU_LENGTH_U64], sizeof(job->r1));
+	job->alu.mul_u64(job->r1, 8, ALU_LENGTH_U64);
+}
@@ -0,0 +1,118 @@
+/******************************************************************************
+** File:	Calc.h
+**
+** Notes:	Computations behind the antplots. Each job owns its ALU context
+**			(with its scratch register) and its own register set, so jobs can
+**			run on different threads at the same time without locking.
+*/
+
+#define CALC_LANGTON_ITERATIONS		12000
+#define CALC_ANT_INTEGER_WORDS		156			// non-recurrent part of the ant trail
+
+#define CALC_LANGTON_PRE_PERIOD		9977		// steps before the ant trail repeats
+#define CALC_LANGTON_PERIOD			104			// steps in each repeat
+#define CALC_GCD_WORDS				(ALU_LENGTH_U64 + 1)	// value & 1 word for normalising
+#define CALC_MIN_REPEATS			4			// times a period must repeat to be found,
+#define CALC_MIN_REPEAT_BITS		1024		// & bits the repeats must cover
+#define CALC_MAX_PERIOD				4096		// longest period looked for, in bits
+
+#define CALC_FACTORIAL_MAX_BACK		256			// further back, n! is calculated again
+
+#define CALC_WINDOW_MAX_WORDS		256			// longest odd part of v for windows of 1 / v
+
+#define CALC_MAX_DEGREE				8
+#define CALC_ROOT_WORDS				(ALU_LENGTH_U64 + 1)	// integer word, fraction & 1 guard word
+
+struct TURMITE_type;
+
+typedef struct
+{
+	int pos_x, pos_y;
+	int dir_x, dir_y;
+} CALC_ant_type;
+
+/******************************************************************************
+** Function:	One step of an antplot walk: turn for the bit, & move
+**
+** Notes:		The walk rule shared by the plot, the render service & the
+**				statistics: from a horizontal heading, a 1 bit turns the ant
+**				to (0, dir_x) & a 0 bit to (0, -dir_x); from a vertical one,
+**				a 1 to (-dir_y, 0) & a 0 to (dir_y, 0). Colouring the cell
+**				left is up to the caller.
+*/
+inline void CALC_ant_step(CALC_ant_type* ant, bool bit)
+{
+	int s = (bit == (ant->dir_x == 0)) ? -1 : 1;
+	int x = ant->dir_x;
+
+	ant->dir_x = s * ant->dir_y;
+	ant->dir_y = s * x;
+	ant->pos_x += ant->dir_x;
+	ant->pos_y += ant->dir_y;
+}
+
+typedef struct
+{
+	ALU_type alu;							// context, incl. scratch register
+
+	ALU_reg r1, r2;
+	ALU_reg_pair hl, bc;
+	int64 carries[2 * ALU_LENGTH_U64];		// carry-saved sums in hl or bc, for e & pi
+
+	ALU_reg_pair f_reg;						// factorial
+	uint64 f_n;								// f_reg holds f_n!
+	bool f_valid;
+
+	ALU_reg ant_trail;						// first ALU_LENGTH_U64 words of the trail
+	ALU_reg trail_integer;					// first 9977 steps, in CALC_ANT_INTEGER_WORDS words
+	ALU_reg trail_fraction;					// recurring 13-byte pattern
+	ALU_reg a;								// Value of A, where L = A / B
+	TURMITE_type* turmite;					// board & rule for the ant trail; see CALC_get_turmite
+
+	ALU_reg num, den;						// rational num / den
+	uint64 rat_d[ALU_LENGTH_U64];			// den normalised, LS word first
+	uint64 rat_u[ALU_LENGTH_U64 + 1];		// remainder & next dividend word, LS word first
+
+	uint64 mont_m[CALC_WINDOW_MAX_WORDS];	// odd part of den, LS word first
+	uint64 mont_x[CALC_WINDOW_MAX_WORDS];	// power of 2 mod mont_m, in Montgomery form
+	uint64 mont_y[CALC_WINDOW_MAX_WORDS];
+	uint64 mont_t[CALC_WINDOW_MAX_WORDS + 2];	// products
+
+	uint64 gcd_u[CALC_GCD_WORDS];			// GCD & exact division, LS word first
+	uint64 gcd_v[CALC_GCD_WORDS];
+	uint64 gcd_t[CALC_GCD_WORDS];
+	uint64 gcd_d[CALC_GCD_WORDS];			// divisor normalised
+
+	int64 poly[CALC_MAX_DEGREE + 1];		// coefficient of x^i in poly[i]
+	int poly_degree;
+	double poly_guess;						// root is refined from here
+	bool root_negative;						// root found is -r1
+	uint64 root_x[CALC_ROOT_WORDS];			// Newton iteration, fixed point, LS word first,
+	uint64 root_z[CALC_ROOT_WORDS];			// with the integer part in the top word
+	uint64 root_v[CALC_ROOT_WORDS];
+	uint64 root_t[CALC_ROOT_WORDS];
+	uint64 root_product[2 * CALC_ROOT_WORDS];
+
+	std::atomic<bool> cancel;				// set by another thread to abandon the job
+	std::atomic<uint64> progress;			// units done, of progress_total (0 if unknown)
+	std::atomic<uint64> progress_total;		// set by the job as it goes, read by others
+} CALC_job_type;
+
+CALC_job_type* CALC_create_job(void);
+void CALC_destroy_job(CALC_job_type* job);
+
+TURMITE_type* CALC_get_turmite(CALC_job_type* job);
+void CALC_turmite(CALC_job_type* job, uint64 n_steps, int first_word_bits);
+void CALC_generate_ant(CALC_job_type* job, int n_steps);
+void CALC_ant_parts(CALC_job_type* job);
+void CALC_ant_ab(CALC_job_type* job);
+bool CALC_find_period(const uint64* trail, int trail_words, uint64 n_bits, uint64 start_bit, uint64 max_period,
+	uint64* p_pre_bits, uint64* p_period_bits);
+bool CALC_periodic(CALC_job_type* job, const uint64* trail, int trail_words, uint64 start_bit, uint64 pre_bits, uint64 period_bits);
+void CALC_reciprocal(CALC_job_type* job, uint64 v);
+bool CALC_rational(CALC_job_type* job, uint64 fraction_words);
+bool CALC_reciprocal_window(CALC_job_type* job, uint64 k, uint64 fraction_words);
+bool CALC_poly_root(CALC_job_type* job);
+bool CALC_factorial(CALC_job_type* job, uint64 n);
+void CALC_e(CALC_job_type* job);
+void CALC_pi(CALC_job_type* job);
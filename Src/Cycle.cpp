@@ -0,0 +1,189 @@
+/******************************************************************************
+** File:	Cycle.cpp
+**
+** Notes:	Rigid motions of the ant over periodic streams. Words of 1 / v
+**			come from the remainder of the long division, so a period is
+**			found when the remainder comes round again, and any part of the
+**			stream can be made again from the remainder at its start.
+*/
+
+#include "stdafx.h"
+
+#include "Cycle.h"
+#include "Trace.h"
+
+#define CYCLE_PROGRESS_WORDS	4096		// words between progress updates
+
+// Heading after 0..3 quarter turns, in the axes of CYCLE_motion_type:
+const int cycle_dx[4] = { 1, 0, -1, 0 };
+const int cycle_dy[4] = { 0, 1, 0, -1 };
+
+/******************************************************************************
+** Function:	Add the n_bits MS bits of bits to a motion
+**
+** Notes:		The cell under the ant is coloured, then the ant turns & moves
+**				on, as app_walker_word does. If c is not NULL, the cells are
+**				added to its bounding box.
+*/
+void cycle_walk(CYCLE_motion_type* m, uint64 bits, int n_bits, CYCLE_reciprocal_type* c)
+{
+	int turns = m->turns;
+	int64 x = m->x;
+	int64 y = m->y;
+
+	for (int i = 0; i < n_bits; i++, bits <<= 1)
+	{
+		if (c != NULL)
+		{
+			if (x < c->min_x)
+				c->min_x = x;
+			if (x > c->max_x)
+				c->max_x = x;
+			if (y < c->min_y)
+				c->min_y = y;
+			if (y > c->max_y)
+				c->max_y = y;
+		}
+
+		turns = (turns + (((bits >> 63) != 0UI64) ? 1 : 3)) & 3;
+		x += cycle_dx[turns];
+		y += cycle_dy[turns];
+	}
+
+	m->turns = turns;
+	m->x = x;
+	m->y = y;
+}
+
+/******************************************************************************
+** Function:	Find the period of 1 / v & the motions of its words
+**
+** Notes:		v > 1. After the first word, the remainders of 1 / v are all
+**				multiples of the power of 2 in v, and multiplying them by 2^64
+**				mod v just permutes them, so the words repeat from the second
+**				word on. The first word never starts with a 1 bit, so its
+**				leading zeroes are skipped, as the walk does.
+**				Returns false, with period_words = 0, if the period is longer
+**				than CYCLE_MAX_PERIOD_WORDS or the run is cancelled.
+*/
+bool CYCLE_reciprocal(CYCLE_reciprocal_type* c, uint64 v, std::atomic<uint64>* p_progress, const std::atomic<bool>* p_cancel)
+{
+	TRACE_SPAN("reciprocal cycle");
+	uint64 remainder = 1UI64;
+	unsigned long top_bit;
+
+	memset(c, 0, sizeof(*c));
+	c->v = v;
+
+	uint64 w = CYCLE_reciprocal_word(v, &remainder);
+	_BitScanReverse64(&top_bit, w);
+	c->first_bits = (int)top_bit + 1;
+	cycle_walk(&c->first, w << (63 - top_bit), c->first_bits, NULL);
+
+	c->period_remainder = remainder;
+	uint64 n = 0UI64;
+	do
+	{
+		cycle_walk(&c->period, CYCLE_reciprocal_word(v, &remainder), 64, c);
+		n++;
+
+		if ((n % CYCLE_PROGRESS_WORDS) == 0UI64)
+		{
+			if (p_progress != NULL)
+				*p_progress = n;
+			if ((n > CYCLE_MAX_PERIOD_WORDS) || ((p_cancel != NULL) && *p_cancel))
+				return false;
+		}
+	} while (remainder != c->period_remainder);
+
+	c->period_words = n;
+	return true;
+}
+
+/******************************************************************************
+** Function:	Next word of 1 / v, MS word first
+**
+** Notes:		*p_remainder < v; 1 before the first word
+*/
+uint64 CYCLE_reciprocal_word(uint64 v, uint64* p_remainder)
+{
+	return _udiv128(*p_remainder, 0UI64, v, p_remainder);
+}
+
+/******************************************************************************
+** Function:	Turn a move by 0..3 quarter turns, the way a 1 bit turns
+**
+** Notes:
+*/
+void CYCLE_turn(int turns, int64* p_x, int64* p_y)
+{
+	int64 x = *p_x;
+	int64 y = *p_y;
+
+	switch (turns & 3)
+	{
+	case 0:		*p_x = x;	*p_y = y;	break;
+	case 1:		*p_x = -y;	*p_y = x;	break;
+	case 2:		*p_x = -x;	*p_y = -y;	break;
+	case 3:		*p_x = y;	*p_y = -x;	break;
+	}
+}
+
+/******************************************************************************
+** Function:	dest = motion a followed by motion b
+**
+** Notes:		dest may be a or b
+*/
+void CYCLE_then(CYCLE_motion_type* dest, const CYCLE_motion_type* a, const CYCLE_motion_type* b)
+{
+	int64 x = b->x;
+	int64 y = b->y;
+
+	CYCLE_turn(a->turns, &x, &y);
+	dest->x = a->x + x;
+	dest->y = a->y + y;
+	dest->turns = (a->turns + b->turns) & 3;
+}
+
+/******************************************************************************
+** Function:	dest = motion m, n times over
+**
+** Notes:		Square & multiply, so about 2 log2(n) compositions. The move
+**				of m n times must fit in 62 bits; it can only grow without
+**				bound when m has no turn (see CYCLE_loop_periods).
+*/
+void CYCLE_power(CYCLE_motion_type* dest, const CYCLE_motion_type* m, uint64 n)
+{
+	CYCLE_motion_type result = { 0, 0, 0 };
+	CYCLE_motion_type square = *m;
+
+	while (n != 0UI64)
+	{
+		if ((n & 1UI64) != 0UI64)
+			CYCLE_then(&result, &result, &square);
+
+		n >>= 1;
+		if (n != 0UI64)
+			CYCLE_then(&square, &square, &square);
+	}
+
+	*dest = result;
+}
+
+/******************************************************************************
+** Function:	Periods after which motion m brings the ant back where it
+**				started, heading the same way; 0 if it never does
+**
+** Notes:		A quarter turn sends the moves of 4 periods round the four
+**				sides of a square, & a half turn sends 2 back & forth, so the
+**				ant closes a loop whatever the move. With no turn, it only
+**				does if it doesn't move; otherwise it builds a highway.
+*/
+uint64 CYCLE_loop_periods(const CYCLE_motion_type* m)
+{
+	if ((m->turns & 1) != 0)
+		return 4UI64;
+	if (m->turns == 2)
+		return 2UI64;
+	return ((m->x == 0) && (m->y == 0)) ? 1UI64 : 0UI64;
+}
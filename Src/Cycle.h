@@ -0,0 +1,36 @@
+/******************************************************************************
+** File:	Cycle.h
+**
+** Notes:	Long walks of periodic streams, such as 1 / v, without taking
+**			every step. Each bit turns the ant a quarter turn, 1 bits one way
+**			& 0 bits the other, whichever way it is heading. So each period
+**			of a stream moves the ant by the same rigid motion, a turn & a
+**			move measured from its heading at the start, and the motion of n
+**			periods is that motion to the power n, found by squaring.
+*/
+
+#define CYCLE_MAX_PERIOD_WORDS		(1 << 24)		// longest period of 1 / v looked for
+
+typedef struct
+{
+	int turns;								// 0..3 quarter turns, the way a 1 bit turns
+	int64 x, y;								// move: x along the heading at the start,
+} CYCLE_motion_type;						// y the way a 1 bit turns from it
+
+typedef struct
+{
+	uint64 v;
+	uint64 period_words;					// words in each period after the first word; 0 if not found
+	uint64 period_remainder;				// of the division 1 / v, at the start of each period
+	int first_bits;							// bits of the first word, from its first 1 bit
+	CYCLE_motion_type first;				// their motion
+	CYCLE_motion_type period;				// each period after it
+	int64 min_x, min_y, max_x, max_y;		// cells a period visits, in the axes of its motion
+} CYCLE_reciprocal_type;
+
+bool CYCLE_reciprocal(CYCLE_reciprocal_type* c, uint64 v, std::atomic<uint64>* p_progress, const std::atomic<bool>* p_cancel);
+uint64 CYCLE_reciprocal_word(uint64 v, uint64* p_remainder);
+void CYCLE_turn(int turns, int64* p_x, int64* p_y);
+void CYCLE_then(CYCLE_motion_type* dest, const CYCLE_motion_type* a, const CYCLE_motion_type* b);
+void CYCLE_power(CYCLE_motion_type* dest, const CYCLE_motion_type* m, uint64 n);
+uint64 CYCLE_loop_periods(const CYCLE_motion_type* m);
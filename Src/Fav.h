@@ -1,19 +1,19 @@
-/******************************************************************************
-** File:	Fav.h
-**
-** Notes:	Favourite reciprocals, for inclusion at top of app.cpp
-*/
-
-const int app_favourites[] =
-{
-	// Lines:
-	13, 113, 2783, 39893, 44345, 84097, 16291,
-
-	// Loops:
-	8153, 1151, 2087, 2903, 166951, 88799, 3841, 2791, 65617,
-	31403, 668477, 19521, 7135, 15771, 20999, 68045, 67879, 70343,
-	3119, 4297, 4751, 7039, 39977, 46399,
-	4943, 5807, 42049, 18583,
-	138449, 8263, 6911, 84769, 18439, 42113,
-	44423, 9199, 180943, 5519
-};
+/******************************************************************************
+** File:	Fav.h
+**
+** Notes:	Favourite reciprocals, for inclusion at top of app.cpp
+*/
+
+const int app_favourites[] =
+{
+	// Lines:
+	13, 113, 2783, 39893, 44345, 84097, 16291,
+
+	// Loops:
+	8153, 1151, 2087, 2903, 166951, 88799, 3841, 2791, 65617,
+	31403, 668477, 19521, 7135, 15771, 20999, 68045, 67879, 70343,
+	3119, 4297, 4751, 7039, 39977, 46399,
+	4943, 5807, 42049, 18583,
+	138449, 8263, 6911, 84769, 18439, 42113,
+	44423, 9199, 180943, 5519
+};
@@ -0,0 +1,204 @@
+/******************************************************************************
+** File:	Filemap.cpp
+**
+** Notes:	Streams a file to a ring, 8 bytes at a time, as words of the bit
+**			string walked. While one view is walked the next is mapped, and
+**			asked to be read in ahead where Windows can (8 & later).
+*/
+
+#include "stdafx.h"
+
+#include "Filemap.h"
+#include "Ring.h"
+#include "Trace.h"
+
+typedef struct
+{
+	void* address;
+	SIZE_T n_bytes;
+} filemap_range_type;					// as WIN32_MEMORY_RANGE_ENTRY
+
+typedef BOOL (WINAPI* filemap_prefetch_type)(HANDLE process, ULONG_PTR n_entries, filemap_range_type* entries, ULONG flags);
+
+filemap_prefetch_type filemap_prefetch;	// PrefetchVirtualMemory, or NULL before Windows 8
+
+/******************************************************************************
+** Function:	Open a file & set the order its bits are walked in
+**
+** Notes:		Returns false if it can't be opened & mapped, or is empty
+*/
+bool FILEMAP_open(FILEMAP_type* f, const char* filename, const FILEMAP_order_type* order)
+{
+	LARGE_INTEGER size;
+
+	f->order = *order;
+	f->file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		order->reverse ? FILE_ATTRIBUTE_NORMAL : FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (f->file == INVALID_HANDLE_VALUE)
+		return false;
+
+	if (!GetFileSizeEx(f->file, &size) || (size.QuadPart == 0))
+	{
+		CloseHandle(f->file);
+		return false;
+	}
+	f->size = (uint64)size.QuadPart;
+
+	f->mapping = CreateFileMappingA(f->file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (f->mapping == NULL)
+	{
+		CloseHandle(f->file);
+		return false;
+	}
+
+	// A part word at the end is padded to a whole one. Walking from the end, its padding
+	// comes first, among the leading zeroes; from the start, it comes last & is left out:
+	uint64 padded_bytes = ((f->size + f->order.word_bytes - 1) / f->order.word_bytes) * f->order.word_bytes;
+	f->n_words = (padded_bytes + 7) / 8;
+	f->tail_bits = f->order.reverse ? 64 : (int)(8 * (padded_bytes - 8 * (f->n_words - 1)));
+
+	filemap_prefetch = (filemap_prefetch_type)GetProcAddress(GetModuleHandleA("kernel32.dll"), "PrefetchVirtualMemory");
+	return true;
+}
+
+/******************************************************************************
+** Function:
+**
+** Notes:
+*/
+void FILEMAP_close(FILEMAP_type* f)
+{
+	CloseHandle(f->mapping);
+	CloseHandle(f->file);
+}
+
+/******************************************************************************
+** Function:	Map view index of the file, & ask for all of it to be read in
+**
+** Notes:		Returns NULL if it can't be mapped
+*/
+const uint8* filemap_map(FILEMAP_type* f, uint64 index)
+{
+	uint64 base = index * FILEMAP_VIEW_BYTES;
+	SIZE_T n_bytes = (SIZE_T)(((f->size - base) < FILEMAP_VIEW_BYTES) ? f->size - base : FILEMAP_VIEW_BYTES);
+
+	void* p = MapViewOfFile(f->mapping, FILE_MAP_READ, (DWORD)(base >> 32), (DWORD)base, n_bytes);
+	if ((p != NULL) && (filemap_prefetch != NULL))
+	{
+		filemap_range_type range = { p, n_bytes };
+		filemap_prefetch(GetCurrentProcess(), 1, &range, 0);
+	}
+
+	return (const uint8*)p;
+}
+
+/******************************************************************************
+** Function:	Swap the bits of x under mask with those shift bits above
+**
+** Notes:
+*/
+inline uint64 filemap_swap(uint64 x, int shift, uint64 mask)
+{
+	return ((x >> shift) & mask) | ((x & mask) << shift);
+}
+
+/******************************************************************************
+** Function:	Word of the bit string from 8 bytes of the file
+**
+** Notes:		x holds the bytes as loaded, first byte in its LS byte
+*/
+inline uint64 filemap_word(uint64 x, const FILEMAP_order_type* order)
+{
+	// Bytes in file order, or the reverse from the end, MS byte first:
+	if (!order->reverse)
+		x = _byteswap_uint64(x);
+
+	// Each word's bytes back the other way, for little-endian words, or to undo the reverse:
+	if (order->little_endian != order->reverse)
+	{
+		if (order->word_bytes >= 2)
+			x = filemap_swap(x, 8, 0x00FF00FF00FF00FFUI64);
+		if (order->word_bytes >= 4)
+			x = filemap_swap(x, 16, 0x0000FFFF0000FFFFUI64);
+		if (order->word_bytes >= 8)
+			x = filemap_swap(x, 32, 0x00000000FFFFFFFFUI64);
+	}
+
+	if (order->lsb_first)
+	{
+		x = filemap_swap(x, 1, 0x5555555555555555UI64);
+		x = filemap_swap(x, 2, 0x3333333333333333UI64);
+		x = filemap_swap(x, 4, 0x0F0F0F0F0F0F0F0FUI64);
+	}
+
+	return x;
+}
+
+/******************************************************************************
+** Function:	Stream the words of the file to p_output, MS word first
+**
+** Notes:		Sends f->n_words words, unless cancelled. p_progress counts
+**				bytes. Only two views are mapped at any time, the one being
+**				streamed & the next. Returns false if a view can't be mapped.
+*/
+bool FILEMAP_stream(FILEMAP_type* f, RING_type* p_output, std::atomic<uint64>* p_progress, const std::atomic<bool>* p_cancel)
+{
+	TRACE_SPAN("file stream");
+	uint64 block[RING_BLOCK_U64];
+	int n = 0;
+	uint64 n_views = (f->size + FILEMAP_VIEW_BYTES - 1) / FILEMAP_VIEW_BYTES;
+	uint64 done = 0UI64;
+	bool reverse = f->order.reverse;
+
+	const uint8* next = filemap_map(f, reverse ? n_views - 1 : 0);
+	for (uint64 k = 0; (k < n_views) && (next != NULL); k++)
+	{
+		uint64 index = reverse ? n_views - 1 - k : k;
+		const uint8* view = next;
+
+		next = NULL;
+		if (k + 1 < n_views)
+		{
+			next = filemap_map(f, reverse ? index - 1 : index + 1);
+			if (next == NULL)
+			{
+				UnmapViewOfFile(view);
+				break;
+			}
+		}
+
+		uint64 base = index * FILEMAP_VIEW_BYTES;
+		uint64 n_bytes = ((f->size - base) < FILEMAP_VIEW_BYTES) ? f->size - base : FILEMAP_VIEW_BYTES;
+		uint64 n_view_words = (n_bytes + 7) / 8;
+		for (uint64 i = 0; i < n_view_words; i++)
+		{
+			uint64 j = reverse ? n_view_words - 1 - i : i;
+			uint64 x = 0UI64;
+			memcpy(&x, &view[8 * j], ((8 * j + 8) <= n_bytes) ? 8 : (size_t)(n_bytes - 8 * j));
+
+			block[n++] = filemap_word(x, &f->order);
+			if (n == RING_BLOCK_U64)
+			{
+				p_output->push(block, n, p_cancel);
+				n = 0;
+			}
+		}
+
+		UnmapViewOfFile(view);
+		done += n_bytes;
+		if (p_progress != NULL)
+			*p_progress = done;
+
+		if ((p_cancel != NULL) && *p_cancel)
+		{
+			if (next != NULL)
+				UnmapViewOfFile(next);
+			return true;
+		}
+	}
+
+	if (n > 0)
+		p_output->push(block, n, p_cancel);
+
+	return done == f->size;
+}
@@ -0,0 +1,34 @@
+/******************************************************************************
+** File:	Filemap.h
+**
+** Notes:	Any file as a bit string for the ant: genomes, archives, firmware
+**			images etc. The file is mapped a view at a time & streamed, so a
+**			file of many gigabytes is plotted in constant memory. Its bytes
+**			are taken as words of 1, 2, 4 or 8 bytes, in either byte order,
+**			from the start or the end, with either bit of each byte first.
+*/
+
+#define FILEMAP_VIEW_BYTES		(64 << 20)		// mapped at a time; a multiple of 64 KB
+
+typedef struct
+{
+	bool lsb_first;							// bits of each byte LS bit first
+	int word_bytes;							// 1, 2, 4 or 8
+	bool little_endian;						// bytes of each word LS byte first, so walked last to first
+	bool reverse;							// words from the end of the file to the start
+} FILEMAP_order_type;
+
+typedef struct
+{
+	HANDLE file, mapping;
+	uint64 size;							// bytes
+	FILEMAP_order_type order;
+	uint64 n_words;							// words streamed; a last part word is padded with zero bytes
+	int tail_bits;							// bits of the last word streamed which are in the file
+} FILEMAP_type;
+
+class RING_type;
+
+bool FILEMAP_open(FILEMAP_type* f, const char* filename, const FILEMAP_order_type* order);
+void FILEMAP_close(FILEMAP_type* f);
+bool FILEMAP_stream(FILEMAP_type* f, RING_type* p_output, std::atomic<uint64>* p_progress, const std::atomic<bool>* p_cancel);
@@ -0,0 +1,166 @@
+/******************************************************************************
+** File:	Fixed.h
+**
+** Notes:	Fixed-width big integer of N uint64 words, for small operands
+**			which would waste time in full-length ALU registers.
+**			Same word order as ALU_reg, LS word first, so a register which
+**			fits has its value in its first N words.
+**			Loops have compile-time trip counts, so the compiler unrolls them
+**			and can keep small values in machine registers. Add, subtract,
+**			compare & zero test are constexpr; multiply & divide use
+**			_umul128 & _udiv128, which are not.
+*/
+
+/******************************************************************************
+** Function:	Add with carry, constexpr
+**
+** Notes:		Branch-free; compiles to add/adc
+*/
+constexpr uint64 alu_fixed_add(uint64 a, uint64 b, uint8& c)
+{
+	uint64 s = a + b;
+	uint8 c1 = (s < a);
+	uint64 t = s + c;
+	c = c1 | (uint8)(t < s);
+	return t;
+}
+
+/******************************************************************************
+** Function:	Subtract with borrow, constexpr
+**
+** Notes:		Branch-free; compiles to sub/sbb
+*/
+constexpr uint64 alu_fixed_sub(uint64 a, uint64 b, uint8& borrow)
+{
+	uint64 d = a - b;
+	uint8 b1 = (a < b);
+	uint64 t = d - borrow;
+	borrow = b1 | (uint8)(d < borrow);
+	return t;
+}
+
+template<size_t N> struct ALU_fixed_type
+{
+	uint64 w[N];
+
+	// Value of the LS N words of a register of length_words:
+	static ALU_fixed_type from_reg(const uint64* r, int length_words = ALU_LENGTH_U64)
+	{
+		ALU_fixed_type x = {};
+		memcpy(x.w, r, sizeof(x.w));
+		return x;
+	}
+
+	// True if a register of length_words has no bits above its LS N words:
+	static bool fits(const uint64* r, int length_words = ALU_LENGTH_U64)
+	{
+		for (int i = (int)N; i < length_words; i++)
+		{
+			if (r[i] != 0UI64)
+				return false;
+		}
+
+		return true;
+	}
+
+	// Write to a register of length_words, zero-extended:
+	void to_reg(uint64* r, int length_words = ALU_LENGTH_U64) const
+	{
+		memcpy(r, w, sizeof(w));
+		memset(&r[N], 0, (length_words - N) * sizeof(uint64));
+	}
+
+	// *this += src, where src may be narrower. Returns carry out.
+	template<size_t M> constexpr uint8 adc(const ALU_fixed_type<M>& src)
+	{
+		static_assert(M <= N, "adc: src wider than dest");
+		uint8 c = 0;
+		for (size_t i = 0; i < N; i++)
+			w[i] = alu_fixed_add(w[i], (i < M) ? src.w[i] : 0UI64, c);
+
+		return c;
+	}
+
+	// *this -= src, where src may be narrower. Returns borrow out.
+	template<size_t M> constexpr uint8 sub(const ALU_fixed_type<M>& src)
+	{
+		static_assert(M <= N, "sub: src wider than dest");
+		uint8 b = 0;
+		for (size_t i = 0; i < N; i++)
+			w[i] = alu_fixed_sub(w[i], (i < M) ? src.w[i] : 0UI64, b);
+
+		return b;
+	}
+
+	// Branch-free: no borrow from *this - b
+	constexpr bool greater_or_equal(const ALU_fixed_type& b) const
+	{
+		uint8 borrow = 0;
+		for (size_t i = 0; i < N; i++)
+			alu_fixed_sub(w[i], b.w[i], borrow);
+
+		return borrow == 0;
+	}
+
+	constexpr bool is_zero(void) const
+	{
+		uint64 x = 0UI64;
+		for (size_t i = 0; i < N; i++)
+			x |= w[i];
+
+		return x == 0UI64;
+	}
+
+	// *this *= v. Returns carry out.
+	uint64 mul_u64(uint64 v)
+	{
+		uint64 carry = 0UI64;
+		uint64 high64;
+		for (size_t i = 0; i < N; i++)
+		{
+			uint64 low64 = _umul128(w[i], v, &high64);
+			high64 += _addcarry_u64(0, low64, carry, &w[i]);
+			carry = high64;
+		}
+
+		return carry;
+	}
+
+	// *this /= d, as ALU_type::div_u64. Returns true when result is zero.
+	bool div_u64(uint64 d, uint64* p_remainder)
+	{
+		uint64 r = 0UI64;
+		for (size_t i = N; i-- > 0; )
+			w[i] = _udiv128(r, w[i], d, &r);
+
+		*p_remainder = r;
+		return is_zero();
+	}
+};
+
+/******************************************************************************
+** Function:	Multiply, full N + M word product
+**
+** Notes:		Row by row, carrying in a word pair, so no carry chains through
+**				the product as in ALU_type::mul
+*/
+template<size_t N, size_t M> ALU_fixed_type<N + M> ALU_fixed_mul(const ALU_fixed_type<N>& x, const ALU_fixed_type<M>& y)
+{
+	ALU_fixed_type<N + M> p = {};
+	uint64 high64;
+
+	for (size_t i = 0; i < N; i++)
+	{
+		uint64 carry = 0UI64;
+		for (size_t j = 0; j < M; j++)
+		{
+			uint64 low64 = _umul128(x.w[i], y.w[j], &high64);
+			high64 += _addcarry_u64(0, low64, p.w[i + j], &low64);
+			high64 += _addcarry_u64(0, low64, carry, &p.w[i + j]);
+			carry = high64;
+		}
+		p.w[i + M] = carry;
+	}
+
+	return p;
+}
@@ -0,0 +1,186 @@
+/******************************************************************************
+** File:	Pool.cpp
+**
+** Notes:	Thread pool for splitting long ALU operations across cores.
+**			Workers sleep on a condition variable between runs, and claim
+**			tasks from an atomic counter, so uneven tasks balance out.
+*/
+
+#include "stdafx.h"
+
+#include "Pool.h"
+
+std::mutex pool_mutex;							// guards the fields below, to the next blank line
+std::condition_variable pool_start;
+std::condition_variable pool_done;
+uint64 pool_generation;							// incremented for each run
+int pool_n_busy;								// workers not yet finished with this run
+bool pool_quit;
+POOL_task_type pool_task;
+void* pool_context;
+int pool_n_tasks;
+
+std::vector<std::thread> pool_workers;			// not including the calling thread; changed under pool_run_mutex
+std::atomic<int> pool_n_workers;				// size of pool_workers, to read without pool_run_mutex
+std::mutex pool_run_mutex;						// one POOL_run at a time
+std::atomic<int> pool_next_task;
+thread_local bool pool_in_task;
+
+/******************************************************************************
+** Function:	Claim & run tasks until there are none left
+**
+** Notes:
+*/
+void pool_do_tasks(void)
+{
+	int task;
+
+	pool_in_task = true;
+	while ((task = pool_next_task++) < pool_n_tasks)
+		pool_task(task, pool_context);
+	pool_in_task = false;
+}
+
+/******************************************************************************
+** Function:	Worker thread
+**
+** Notes:		seen is the generation when the worker was made, as the runs
+**				before it aren't for it, & a run may start before it does
+*/
+void pool_worker(uint64 seen)
+{
+	do
+	{
+		{
+			std::unique_lock<std::mutex> lock(pool_mutex);
+			pool_start.wait(lock, [&seen] { return pool_quit || (pool_generation != seen); });
+			if (pool_quit)
+				return;
+
+			seen = pool_generation;
+		}
+
+		pool_do_tasks();
+
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		if (--pool_n_busy == 0)
+			pool_done.notify_one();
+	} while (true);
+}
+
+/******************************************************************************
+** Function:	Stop all workers
+**
+** Notes:		Also called at exit, as running threads can't be destroyed
+*/
+void pool_stop(void)
+{
+	{
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		pool_quit = true;
+	}
+	pool_start.notify_all();
+	for (size_t i = 0; i < pool_workers.size(); i++)
+		pool_workers[i].join();
+	pool_workers.clear();
+	pool_n_workers = 0;
+
+	std::lock_guard<std::mutex> lock(pool_mutex);
+	pool_quit = false;
+}
+
+/******************************************************************************
+** Function:	Set number of threads, including the calling thread
+**
+** Notes:		1 runs everything on the calling thread
+*/
+void POOL_set_threads(int n_threads)
+{
+	static bool registered = false;
+	std::lock_guard<std::mutex> run_lock(pool_run_mutex);
+
+	if (!registered)
+	{
+		atexit(pool_stop);
+		registered = true;
+	}
+
+	if (n_threads < 1)
+		n_threads = 1;
+	if (n_threads > POOL_MAX_THREADS)
+		n_threads = POOL_MAX_THREADS;
+
+	pool_stop();
+
+	uint64 generation;
+	{
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		generation = pool_generation;
+	}
+	for (int i = 1; i < n_threads; i++)
+		pool_workers.push_back(std::thread(pool_worker, generation));
+	pool_n_workers = n_threads - 1;
+}
+
+/******************************************************************************
+** Function:
+**
+** Notes:
+*/
+int POOL_threads(void)
+{
+	return pool_n_workers + 1;
+}
+
+/******************************************************************************
+** Function:	Run tasks 0..n_tasks-1 & wait for them all
+**
+** Notes:		Nested runs, from inside a task, run on the calling thread
+*/
+void POOL_run(int n_tasks, POOL_task_type p_task, void* p_context)
+{
+	std::unique_lock<std::mutex> run_lock(pool_run_mutex, std::defer_lock);
+
+	if ((n_tasks > 1) && !pool_in_task && (pool_n_workers > 0))
+		run_lock.lock();
+	if (!run_lock.owns_lock() || pool_workers.empty())	// the workers may have gone while we waited
+	{
+		for (int task = 0; task < n_tasks; task++)
+			p_task(task, p_context);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		pool_task = p_task;
+		pool_context = p_context;
+		pool_n_tasks = n_tasks;
+		pool_next_task = 0;
+		pool_n_busy = (int)pool_workers.size();
+		pool_generation++;
+	}
+	pool_start.notify_all();
+
+	pool_do_tasks();
+
+	std::unique_lock<std::mutex> lock(pool_mutex);
+	pool_done.wait(lock, [] { return pool_n_busy == 0; });
+}
+
+/******************************************************************************
+** Function:	Set number of threads command
+**
+** Notes:
+*/
+void POOL_configure(void)
+{
+	int i;
+
+	printf("\nThreads for long operations: %d (%u cores)\nEnter new number of threads (1..%d): ",
+		POOL_threads(), std::thread::hardware_concurrency(), POOL_MAX_THREADS);
+	scanf("%d", &i);
+	if ((i < 1) || (i > POOL_MAX_THREADS))
+		printf("*** Value out of range. Number of threads unchanged.\n");
+	else
+		POOL_set_threads(i);
+}
@@ -0,0 +1,18 @@
+/******************************************************************************
+** File:	Pool.h
+**
+** Notes:	Thread pool for splitting long ALU operations across cores.
+**			POOL_run calls a task function for task numbers 0..n_tasks-1,
+**			on the pool's threads and the calling thread, and returns when
+**			all are done. One POOL_run at a time; a task which calls
+**			POOL_run itself gets its tasks run serially.
+*/
+
+#define POOL_MAX_THREADS		64
+
+typedef void (*POOL_task_type)(int task, void* p_context);
+
+void POOL_set_threads(int n_threads);
+int POOL_threads(void);
+void POOL_run(int n_tasks, POOL_task_type p_task, void* p_context);
+void POOL_configure(void);
@@ -0,0 +1,11 @@
+/******************************************************************************
+** File:	Random.h
+**
+** Notes:	Counter-based random numbers: Philox2x64-10 (Salmon et al., 2011).
+**			Each 128-bit block is a keyed hash of its index, so word i of
+**			stream s depends only on the seed, s & i. Any part of any stream
+**			can be made on any thread, in any order, with the same result.
+*/
+
+void RANDOM_block(uint64 seed, uint64 stream, uint64 index, uint64* p_word0, uint64* p_word1);
+void RANDOM_fill(uint64* dest, int n_words, uint64 seed, uint64 stream);
@@ -0,0 +1,91 @@
+/******************************************************************************
+** File:	Ring.h
+**
+** Notes:	Lock-free single-producer/single-consumer ring of uint64 words,
+**			used to stream finished words of a value from the thread which
+**			generates it to the thread which plots it, MS word first.
+**			Indices increase without limit and are masked on access.
+*/
+
+#define RING_LENGTH_U64		8192				// must be a power of 2
+#define RING_BLOCK_U64		64					// words popped at a time by the consumer
+
+class RING_type
+{
+private:
+	uint64 buffer[RING_LENGTH_U64];
+	alignas(64) std::atomic<uint32> head;		// next word to write; written by producer only
+	alignas(64) std::atomic<uint32> tail;		// next word to read; written by consumer only
+	std::atomic<bool> closed;					// producer has finished
+
+public:
+	void reset(void)
+	{
+		head = 0;
+		tail = 0;
+		closed = false;
+	}
+
+	// Producer: append n words, yielding while the ring is full.
+	// Words are dropped if p_cancel becomes set, so a consumer which stops early can't deadlock us.
+	void push(const uint64* p, int n, const std::atomic<bool>* p_cancel)
+	{
+		uint32 h = head.load(std::memory_order_relaxed);
+
+		while (n > 0)
+		{
+			uint32 space = RING_LENGTH_U64 - (h - tail.load(std::memory_order_acquire));
+			if (space == 0)
+			{
+				if ((p_cancel != NULL) && p_cancel->load(std::memory_order_relaxed))
+					return;
+
+				std::this_thread::yield();
+				continue;
+			}
+
+			uint32 count = ((uint32)n < space) ? (uint32)n : space;
+			for (uint32 i = 0; i < count; i++)
+				buffer[(h + i) & (RING_LENGTH_U64 - 1)] = p[i];
+
+			h += count;
+			head.store(h, std::memory_order_release);
+			p += count;
+			n -= count;
+		}
+	}
+
+	// Producer: no more words will follow
+	void close(void)
+	{
+		closed.store(true, std::memory_order_release);
+	}
+
+	// Consumer: take up to max_words, yielding until some are available.
+	// Returns 0 once the ring is closed and empty, or if p_cancel is set.
+	int pop(uint64* p, int max_words, const std::atomic<bool>* p_cancel)
+	{
+		uint32 t = tail.load(std::memory_order_relaxed);
+
+		do
+		{
+			bool was_closed = closed.load(std::memory_order_acquire);	// read before head, so no words are missed
+			uint32 available = head.load(std::memory_order_acquire) - t;
+
+			if (available != 0)
+			{
+				uint32 count = (available < (uint32)max_words) ? available : (uint32)max_words;
+				for (uint32 i = 0; i < count; i++)
+					p[i] = buffer[(t + i) & (RING_LENGTH_U64 - 1)];
+
+				tail.store(t + count, std::memory_order_release);
+				return (int)count;
+			}
+
+			if (was_closed || ((p_cancel != NULL) && p_cancel->load(std::memory_order_relaxed)))
+				return 0;
+
+			std::this_thread::yield();
+		} while (true);
+	}
+};
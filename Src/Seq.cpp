@@ -0,0 +1,566 @@
+/******************************************************************************
+** File:	Seq.cpp
+**
+** Notes:	Terms are held LS word first in s->value, with n_words the words
+**			in use, so each step multiplies or divides only those words, not
+**			the whole register as CALC_factorial does. Going back a term is
+**			the inverse step, so 'b' is as quick as 'n'.
+*/
+
+#include "stdafx.h"
+
+#include "Alu.h"
+#include "Calc.h"
+#include "Seq.h"
+#include "Trace.h"
+
+const char* const SEQ_names[SEQ_N_KINDS] = { "power", "fibonacci", "primorial", "binomial" };
+
+typedef struct
+{
+	uint64 limit;							// primes up to this
+	bool two_sent;							// the only even prime
+	std::vector<uint32> base;				// odd primes up to the square root of limit
+	std::vector<uint8> composite;			// 1 for each odd composite of the segment
+	uint64 low;								// segment holds the odd numbers from here
+	int length;								// odd numbers in the segment
+	int index;								// next one looked at
+} seq_sieve_type;
+
+/******************************************************************************
+** Function:	Start a segmented sieve of the primes up to limit
+**
+** Notes:		The base primes come from a plain sieve
+*/
+void seq_sieve_start(seq_sieve_type* sv, uint64 limit)
+{
+	uint32 root = (uint32)sqrt((double)limit);
+	while ((uint64)root * root > limit)
+		root--;
+	while ((uint64)(root + 1) * (root + 1) <= limit)
+		root++;
+
+	std::vector<uint8> small(root + 1, 0);
+	sv->base.clear();
+	for (uint32 i = 3; i <= root; i += 2)
+	{
+		if (small[i] != 0)
+			continue;
+
+		sv->base.push_back(i);
+		for (uint64 j = (uint64)i * i; j <= root; j += 2 * i)
+			small[(size_t)j] = 1;
+	}
+
+	sv->limit = limit;
+	sv->two_sent = false;
+	sv->composite.resize(SEQ_SIEVE_BYTES);
+	sv->low = 3UI64;
+	sv->length = 0;
+	sv->index = 0;
+}
+
+/******************************************************************************
+** Function:	Sieve the segment from sv->low
+**
+** Notes:
+*/
+void seq_sieve_fill(seq_sieve_type* sv)
+{
+	uint64 n_odd = (sv->low <= sv->limit) ? (sv->limit - sv->low) / 2 + 1 : 0UI64;
+	sv->length = (n_odd < SEQ_SIEVE_BYTES) ? (int)n_odd : SEQ_SIEVE_BYTES;
+	sv->index = 0;
+
+	uint64 high = sv->low + 2 * (uint64)sv->length;		// first odd number after the segment
+	memset(sv->composite.data(), 0, sv->length);
+	for (size_t k = 0; k < sv->base.size(); k++)
+	{
+		uint64 p = sv->base[k];
+		if (p * p >= high)
+			break;
+
+		// First odd multiple of p in the segment, from p^2:
+		uint64 m = p * p;
+		if (m < sv->low)
+		{
+			m = ((sv->low + p - 1) / p) * p;
+			if ((m & 1UI64) == 0UI64)
+				m += p;
+		}
+
+		for (uint64 i = (m - sv->low) / 2; i < (uint64)sv->length; i += p)
+			sv->composite[(size_t)i] = 1;
+	}
+}
+
+/******************************************************************************
+** Function:	Next prime from the sieve
+**
+** Notes:		Returns 0 after the last prime up to the limit
+*/
+uint64 seq_sieve_next(seq_sieve_type* sv)
+{
+	if (!sv->two_sent)
+	{
+		sv->two_sent = true;
+		if (sv->limit >= 2UI64)
+			return 2UI64;
+	}
+
+	do
+	{
+		while (sv->index < sv->length)
+		{
+			int i = sv->index++;
+			if (sv->composite[i] == 0)
+				return sv->low + 2 * (uint64)i;
+		}
+
+		sv->low += 2 * (uint64)sv->length;
+		seq_sieve_fill(sv);
+	} while (sv->length > 0);
+
+	return 0UI64;
+}
+
+/******************************************************************************
+** Function:	Trial division, for the single primes a step needs
+**
+** Notes:
+*/
+bool seq_is_prime(uint64 x)
+{
+	if (x < 4UI64)
+		return x >= 2UI64;
+
+	if ((x & 1UI64) == 0UI64)
+		return false;
+
+	for (uint64 d = 3UI64; d * d <= x; d += 2)
+	{
+		if ((x % d) == 0UI64)
+			return false;
+	}
+
+	return true;
+}
+
+/******************************************************************************
+** Function:	Words in use of x, from up to n_words
+**
+** Notes:		At least 1
+*/
+inline int seq_length(const uint64* x, int n_words)
+{
+	while ((n_words > 1) && (x[n_words - 1] == 0UI64))
+		n_words--;
+
+	return n_words;
+}
+
+/******************************************************************************
+** Function:	x *= m, over the words in use
+**
+** Notes:		Returns false if the product doesn't fit in SEQ_WORDS. It
+**				may go 1 word over, for a division to bring back.
+*/
+bool seq_mul(SEQ_type* s, CALC_job_type* job, uint64* x, uint64 m)
+{
+	uint64 carry = job->alu.mul_u64(x, m, s->n_words);
+	if (carry != 0UI64)
+		x[s->n_words++] = carry;
+
+	return s->n_words <= SEQ_WORDS;
+}
+
+/******************************************************************************
+** Function:	x /= d, which divides it exactly
+**
+** Notes:
+*/
+void seq_div(SEQ_type* s, CALC_job_type* job, uint64* x, uint64 d)
+{
+	uint64 remainder;
+
+	job->alu.div_u64(x, d, s->n_words, &remainder);
+	s->n_words = seq_length(x, s->n_words);
+}
+
+/******************************************************************************
+** Function:	Multiply s->value by factor, saving up factors a word at a time
+**
+** Notes:		*p_chunk holds the factors saved; call with factor 1 to
+**				multiply them in at the end. Returns false on overflow.
+*/
+bool seq_mul_factor(SEQ_type* s, CALC_job_type* job, uint64* p_chunk, uint64 factor)
+{
+	uint64 high;
+	uint64 low = _umul128(*p_chunk, factor, &high);
+
+	if ((high == 0UI64) && (factor != 1UI64))
+	{
+		*p_chunk = low;
+		return true;
+	}
+
+	bool ok = seq_mul(s, job, s->value, *p_chunk);
+	*p_chunk = factor;
+	return ok;
+}
+
+/******************************************************************************
+** Function:	Set s to term 0
+**
+** Notes:
+*/
+void seq_start(SEQ_type* s)
+{
+	memset(s->value, 0, sizeof(s->value));
+	memset(s->next, 0, sizeof(s->next));
+	s->value[0] = 1UI64;					// a^0, p_0#, C(0, 0)
+	if (s->kind == SEQ_FIBONACCI)
+	{
+		s->value[0] = 0UI64;
+		s->next[0] = 1UI64;
+	}
+
+	s->n = 0UI64;
+	s->n_words = 1;
+	s->prime = 0UI64;
+	s->valid = true;
+}
+
+/******************************************************************************
+** Function:	Step to the next term
+**
+** Notes:		Returns false on overflow
+*/
+bool seq_forward(SEQ_type* s, CALC_job_type* job)
+{
+	bool ok = true;
+
+	switch (s->kind)
+	{
+	case SEQ_POWER:
+		ok = seq_mul(s, job, s->value, s->base);
+		break;
+
+	case SEQ_FIBONACCI:
+	{
+		// (F(n), F(n + 1)) to (F(n + 1), F(n) + F(n + 1)):
+		uint8 c = 0;
+		for (int i = 0; i < s->n_words; i++)
+		{
+			uint64 x = s->next[i];
+			c = _addcarry_u64(c, s->value[i], s->next[i], &s->next[i]);
+			s->value[i] = x;
+		}
+		if (c != 0)
+			s->next[s->n_words++] = 1UI64;
+		ok = s->n_words <= SEQ_WORDS;
+		break;
+	}
+
+	case SEQ_PRIMORIAL:
+		do
+			s->prime = (s->prime < 2UI64) ? 2UI64 : s->prime + 1;
+		while (!seq_is_prime(s->prime));
+		ok = seq_mul(s, job, s->value, s->prime);
+		break;
+
+	default:
+		// C(2n + 2, n + 1) = C(2n, n) * 2(2n + 1) / (n + 1):
+		seq_mul(s, job, s->value, 2 * (2 * s->n + 1));
+		seq_div(s, job, s->value, s->n + 1);
+		ok = s->n_words <= SEQ_WORDS;
+		break;
+	}
+
+	s->n++;
+	return ok;
+}
+
+/******************************************************************************
+** Function:	Step back to the term before, for n > 0
+**
+** Notes:
+*/
+void seq_back(SEQ_type* s, CALC_job_type* job)
+{
+	switch (s->kind)
+	{
+	case SEQ_POWER:
+		seq_div(s, job, s->value, s->base);
+		break;
+
+	case SEQ_FIBONACCI:
+	{
+		// (F(n), F(n + 1)) to (F(n + 1) - F(n), F(n)):
+		uint8 b = 0;
+		for (int i = 0; i < s->n_words; i++)
+		{
+			uint64 x = s->value[i];
+			b = _subborrow_u64(b, s->next[i], s->value[i], &s->value[i]);
+			s->next[i] = x;
+		}
+		s->n_words = seq_length(s->next, s->n_words);
+		break;
+	}
+
+	case SEQ_PRIMORIAL:
+		seq_div(s, job, s->value, s->prime);
+		do
+			s->prime--;
+		while ((s->prime >= 2UI64) && !seq_is_prime(s->prime));
+		if (s->prime < 2UI64)
+			s->prime = 0UI64;
+		break;
+
+	default:
+		// C(2n - 2, n - 1) = C(2n, n) * n / 2(2n - 1):
+		seq_mul(s, job, s->value, s->n);
+		seq_div(s, job, s->value, 2 * (2 * s->n - 1));
+		break;
+	}
+
+	s->n--;
+}
+
+/******************************************************************************
+** Function:	a^n, by squaring, MS bit of n first
+**
+** Notes:		Returns false on overflow
+*/
+bool seq_power_jump(SEQ_type* s, CALC_job_type* job, uint64 n)
+{
+	int bit = 63;
+	while ((bit >= 0) && (((n >> bit) & 1UI64) == 0UI64))
+		bit--;
+
+	job->progress_total = bit + 1;
+	for (; (bit >= 0) && !job->cancel; bit--)
+	{
+		if (2 * s->n_words - 1 > SEQ_WORDS)
+			return false;
+
+		job->alu.mul_words(s->t1, s->value, s->value, s->n_words);
+		memcpy(s->value, s->t1, 2 * s->n_words * sizeof(uint64));
+		s->n_words = seq_length(s->value, 2 * s->n_words);
+
+		if (((n >> bit) & 1UI64) != 0UI64)
+		{
+			if (!seq_mul(s, job, s->value, s->base))
+				return false;
+		}
+		else if (s->n_words > SEQ_WORDS)
+			return false;
+
+		job->progress++;
+	}
+
+	s->n = n;
+	return true;
+}
+
+/******************************************************************************
+** Function:	F(n) & F(n + 1), by doubling, MS bit of n first
+**
+** Notes:		From a = F(k), b = F(k + 1):
+**					F(2k) = a(2b - a), F(2k + 1) = a^2 + b^2
+**				Returns false on overflow
+*/
+bool seq_fibonacci_jump(SEQ_type* s, CALC_job_type* job, uint64 n)
+{
+	int bit = 63;
+	while ((bit >= 0) && (((n >> bit) & 1UI64) == 0UI64))
+		bit--;
+
+	job->progress_total = bit + 1;
+	for (; (bit >= 0) && !job->cancel; bit--)
+	{
+		int length = s->n_words;
+		if (2 * length - 1 > SEQ_WORDS)			// b^2 alone is too big
+			return false;
+
+		// 2b - a, in length + 1 words:
+		for (int i = 0; i < length; i++)
+			s->t3[i] = (s->next[i] << 1) | ((i > 0) ? s->next[i - 1] >> 63 : 0UI64);
+		s->t3[length] = s->next[length - 1] >> 63;
+		job->alu.sub(s->t3, s->value, length + 1);
+
+		job->alu.mul_words(s->t1, s->value, s->t3, length + 1);		// F(2k)
+		job->alu.mul_words(s->t2, s->value, s->value, length);
+		job->alu.mul_words(s->t3, s->next, s->next, length);
+		s->t2[2 * length] = job->alu.adc(s->t2, s->t3, 2 * length);		// F(2k + 1)
+		s->t2[2 * length + 1] = 0UI64;
+
+		if (((n >> bit) & 1UI64) != 0UI64)
+		{
+			job->alu.adc(s->t1, s->t2, 2 * length + 2);					// F(2k + 2)
+			memcpy(s->value, s->t2, (2 * length + 2) * sizeof(uint64));
+			memcpy(s->next, s->t1, (2 * length + 2) * sizeof(uint64));
+		}
+		else
+		{
+			memcpy(s->value, s->t1, (2 * length + 2) * sizeof(uint64));
+			memcpy(s->next, s->t2, (2 * length + 2) * sizeof(uint64));
+		}
+		s->n_words = seq_length(s->next, 2 * length + 2);
+		job->progress++;
+	}
+
+	s->n = n;
+	return s->n_words <= SEQ_WORDS;
+}
+
+/******************************************************************************
+** Function:	p_n#, as the product of the first n primes from the sieve
+**
+** Notes:		Returns false on overflow
+*/
+bool seq_primorial_jump(SEQ_type* s, CALC_job_type* job, uint64 n)
+{
+	seq_sieve_type sv;
+	uint64 chunk = 1UI64;
+
+	if (n > 64 * (uint64)SEQ_WORDS)				// each prime is a bit or more
+		return false;
+
+	// p_n < n(ln n + ln ln n), for n >= 6:
+	double limit = (n < 6) ? 13.0 : n * (log((double)n) + log(log((double)n)));
+	seq_sieve_start(&sv, (uint64)limit + 1);
+
+	job->progress_total = n;
+	while ((s->n < n) && !job->cancel)
+	{
+		s->prime = seq_sieve_next(&sv);
+		if (!seq_mul_factor(s, job, &chunk, s->prime))
+			return false;
+
+		s->n++;
+		job->progress = s->n;
+	}
+
+	return seq_mul_factor(s, job, &chunk, 1UI64);
+}
+
+/******************************************************************************
+** Function:	C(2n, n), as a product of prime powers
+**
+** Notes:		p divides C(2n, n) floor(2n / p^k) - 2 floor(n / p^k) times,
+**				summed over k (Legendre). Returns false on overflow.
+*/
+bool seq_binomial_jump(SEQ_type* s, CALC_job_type* job, uint64 n)
+{
+	seq_sieve_type sv;
+	uint64 chunk = 1UI64;
+	uint64 p;
+
+	if (n > 32 * (uint64)SEQ_WORDS + 32)			// C(2n, n) > 4^n / (2n + 1)
+		return false;
+
+	seq_sieve_start(&sv, 2 * n);
+	job->progress_total = 2 * n;
+	while (((p = seq_sieve_next(&sv)) != 0UI64) && !job->cancel)
+	{
+		for (uint64 q = p; q <= 2 * n; q *= p)
+		{
+			for (uint64 e = (2 * n) / q - 2 * (n / q); e > 0; e--)
+			{
+				if (!seq_mul_factor(s, job, &chunk, p))
+					return false;
+			}
+		}
+		job->progress = p;
+	}
+
+	s->n = n;
+	return seq_mul_factor(s, job, &chunk, 1UI64);
+}
+
+/******************************************************************************
+** Function:	Set the kind of sequence, & the base a of a^n
+**
+** Notes:		The term held is kept if neither changes
+*/
+void SEQ_set(SEQ_type* s, int kind, uint64 base)
+{
+	if ((kind != s->kind) || (base != s->base))
+		s->valid = false;
+
+	s->kind = kind;
+	s->base = base;
+}
+
+/******************************************************************************
+** Function:	Go to term n, stepping if it's near, else jumping
+**
+** Notes:		Returns false if it's too big for SEQ_WORDS; for Fibonacci,
+**				F(n + 1) must fit too. If job->cancel is set, s is left at
+**				a term on the way, or not valid.
+*/
+bool SEQ_term(SEQ_type* s, CALC_job_type* job, uint64 n)
+{
+	TRACE_SPAN("sequence");
+	bool ok = true;
+
+	if (!s->valid)
+		seq_start(s);
+
+	uint64 distance = (n >= s->n) ? n - s->n : s->n - n;
+	if (distance > SEQ_MAX_STEPS)
+	{
+		seq_start(s);
+		switch (s->kind)
+		{
+		case SEQ_POWER:		ok = seq_power_jump(s, job, n);			break;
+		case SEQ_FIBONACCI:	ok = seq_fibonacci_jump(s, job, n);		break;
+		case SEQ_PRIMORIAL:	ok = seq_primorial_jump(s, job, n);		break;
+		default:			ok = seq_binomial_jump(s, job, n);		break;
+		}
+
+		if (job->cancel)
+			s->valid = false;
+	}
+	else
+	{
+		job->progress_total = distance;
+		while (ok && (s->n != n) && !job->cancel)
+		{
+			if (s->n < n)
+				ok = seq_forward(s, job);
+			else
+				seq_back(s, job);
+			job->progress++;
+		}
+	}
+
+	if (!ok)
+		s->valid = false;
+	return ok;
+}
+
+/******************************************************************************
+** Function:	Name of the term held, e.g. 3^100 or C(200, 100)
+**
+** Notes:		Returns the length of text
+*/
+int SEQ_text(const SEQ_type* s, char* text, int max_length)
+{
+	switch (s->kind)
+	{
+	case SEQ_POWER:
+		return snprintf(text, max_length, "%llu^%llu", s->base, s->n);
+
+	case SEQ_FIBONACCI:
+		return snprintf(text, max_length, "F(%llu)", s->n);
+
+	case SEQ_PRIMORIAL:
+		if (s->n == 0UI64)
+			return snprintf(text, max_length, "p_0#");
+		return snprintf(text, max_length, "p_%llu# = %llu#", s->n, s->prime);
+
+	default:
+		return snprintf(text, max_length, "C(%llu, %llu)", 2 * s->n, s->n);
+	}
+}
@@ -0,0 +1,42 @@
+/******************************************************************************
+** File:	Seq.h
+**
+** Notes:	Integer sequences for the 'n' & 'b' commands, alongside the
+**			factorials: a^n, Fibonacci numbers, primorials & central
+**			binomials. Each steps to the next or previous term in time
+**			linear in the words of the term, & jumps straight to a far term:
+**			powers by squaring, Fibonacci numbers by doubling, primorials &
+**			binomials as products of primes from a segmented sieve.
+*/
+
+#define SEQ_WORDS				(2 * ALU_LENGTH_U64)	// longest term, as a factorial
+#define SEQ_MAX_STEPS			256			// further than this, jump rather than step
+#define SEQ_SIEVE_BYTES			(32 << 10)	// odd numbers sieved at a time, to stay in L1 cache
+
+// Kinds:
+#define SEQ_POWER				0			// a^n
+#define SEQ_FIBONACCI			1			// F(n)
+#define SEQ_PRIMORIAL			2			// p_n#, the product of the first n primes
+#define SEQ_BINOMIAL			3			// C(2n, n)
+#define SEQ_N_KINDS				4
+
+struct SEQ_type
+{
+	int kind;
+	uint64 base;							// a, 2 & up, for powers
+	uint64 n;								// term held
+	bool valid;
+	int n_words;							// of value & next; words above are zero
+	uint64 prime;							// primorials: p_n, or 0
+	uint64 value[SEQ_WORDS + 2];			// term n, LS word first; 2 words over for a carry
+	uint64 next[SEQ_WORDS + 2];				// Fibonacci: F(n + 1)
+	uint64 t1[SEQ_WORDS + 2];				// products
+	uint64 t2[SEQ_WORDS + 2];
+	uint64 t3[SEQ_WORDS + 2];
+};
+
+extern const char* const SEQ_names[SEQ_N_KINDS];
+
+void SEQ_set(SEQ_type* s, int kind, uint64 base);
+bool SEQ_term(SEQ_type* s, CALC_job_type* job, uint64 n);
+int SEQ_text(const SEQ_type* s, char* text, int max_length);
@@ -0,0 +1,710 @@
+/******************************************************************************
+** File:	Serve.cpp
+**
+** Notes:	Render service. The listening thread queues each connection for
+**			a pool of workers, each with its own CALC job & canvas. A plot
+**			is looked up by a key made from its parsed request: a cached
+**			plot is sent at once; one being rendered for another request
+**			is waited for; otherwise the worker renders it into the cache,
+**			dropping the least recently used plot.
+*/
+
+#include "stdafx.h"
+
+#include "Alu.h"
+#include "Calc.h"
+#include "Cycle.h"
+#include "Pool.h"
+#include "Random.h"
+#include "Seq.h"
+#include "Serve.h"
+#include "Stats.h"
+#include "Trace.h"
+
+#pragma comment(lib, "ws2_32.lib")
+
+#define SERVE_TICK_MS			100			// listener checks for cancel this often
+#define SERVE_QUEUE_LENGTH		256			// connections waiting for a worker; must be a power of 2
+#define SERVE_MAX_REQUEST		2048		// bytes of request header read
+#define SERVE_RECEIVE_MS		2000		// longest wait for a request
+#define SERVE_KEY_LENGTH		96
+#define SERVE_LATENCY_BIN_MS	0.05		// histograms: the first bin to 50 us, then
+#define SERVE_LATENCY_BIN_RATIO	1.0717735	// 2^(1/10) wider each, to 40 minutes at 7% resolution
+#define SERVE_MAX_TEXT			1024		// text responses
+
+#define SERVE_COLOUR_BACKGROUND	0x00325564UL		// as the plot window
+#define SERVE_COLOUR_WHITE		0x00FFFFFFUL
+#define SERVE_COLOUR_BLACK		0x00000000UL
+
+// Modes:
+#define SERVE_MODE_RECIPROCAL	0
+#define SERVE_MODE_FACTORIAL	1
+#define SERVE_MODE_RANDOM		2
+#define SERVE_MODE_SEQUENCE		3			// + SEQ_x
+#define SERVE_N_MODES			(SERVE_MODE_SEQUENCE + SEQ_N_KINDS)
+
+// Formats:
+#define SERVE_FORMAT_BMP		0			// 32 bits a pixel, top-down
+#define SERVE_FORMAT_PGM		1			// binary greyscale
+#define SERVE_N_FORMATS			2
+
+// Cache slot states:
+#define SERVE_SLOT_EMPTY		0
+#define SERVE_SLOT_RENDERING	1			// other requests for it wait
+#define SERVE_SLOT_READY		2
+
+typedef std::shared_ptr<std::vector<uint8>> serve_response_type;	// whole HTTP response
+
+typedef struct
+{
+	int mode;
+	uint64 from, to;
+	int dir;								// 0..3, as the 'd' command
+	int size;
+	int format;
+	uint64 seed;							// random strings
+	int words;
+	uint64 base;							// a^n
+} serve_request_type;
+
+typedef struct
+{
+	char key[SERVE_KEY_LENGTH];
+	int state;
+	uint64 last_used;						// serve_clock
+	serve_response_type response;
+	bool ok;								// else response is an error, e.g. too big for the ALU
+} serve_slot_type;
+
+typedef struct
+{
+	CALC_job_type* job;						// factorials carry on from the last one
+	SEQ_type sequence;						// & so do other sequences
+	uint64 value[2 * ALU_LENGTH_U64];		// reciprocal or random string, LS word first
+	std::vector<uint32> canvas;				// 0x00RRGGBB, as APP_pixels
+} serve_worker_type;
+
+const char* const serve_mode_names[SERVE_MODE_SEQUENCE] = { "reciprocal", "factorial", "random" };	// then SEQ_names
+const char* const serve_format_names[SERVE_N_FORMATS] = { "bmp", "pgm" };
+const char* const serve_content_types[SERVE_N_FORMATS] = { "image/bmp", "image/x-portable-graymap" };
+
+std::mutex serve_mutex;						// guards the fields below, to the next blank line
+std::condition_variable serve_rendered;		// a slot has left SERVE_SLOT_RENDERING
+serve_slot_type serve_slots[SERVE_CACHE_ENTRIES];
+uint64 serve_clock;
+uint64 serve_n_requests, serve_n_errors, serve_n_refused;
+uint64 serve_n_rendered, serve_n_hits, serve_n_coalesced;
+STATS_distribution_type serve_latency;		// ms, from accept to response sent
+STATS_distribution_type serve_render_ms;
+std::chrono::steady_clock::time_point serve_start;
+
+std::mutex serve_queue_mutex;				// guards the fields below, to the next blank line
+std::condition_variable serve_queue_ready;
+SOCKET serve_queue[SERVE_QUEUE_LENGTH];
+std::chrono::steady_clock::time_point serve_queue_time[SERVE_QUEUE_LENGTH];	// when accepted
+uint32 serve_queue_head, serve_queue_tail;
+bool serve_quit;
+
+/******************************************************************************
+** Function:	Milliseconds since t
+**
+** Notes:
+*/
+double serve_ms(std::chrono::steady_clock::time_point t)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count();
+}
+
+/******************************************************************************
+** Function:	HTTP response with a text body
+**
+** Notes:
+*/
+serve_response_type serve_text(const char* status, const char* text)
+{
+	char header[128];
+	int n_text = (int)strlen(text);
+	int n_header = snprintf(header, sizeof(header),
+		"HTTP/1.0 %s\r\nContent-Type: text/plain\r\nContent-Length: %d\r\nConnection: close\r\n\r\n", status, n_text);
+
+	serve_response_type response = std::make_shared<std::vector<uint8>>(header, header + n_header);
+	response->insert(response->end(), text, text + n_text);
+	return response;
+}
+
+/******************************************************************************
+** Function:	Parse the query of a plot request
+**
+** Notes:		Returns false, with a message in error, if it isn't valid
+*/
+bool serve_parse(const char* query, serve_request_type* r, char* error, int max_error)
+{
+	char name[16];
+	char text[32];
+	bool have_from = false;
+	bool have_to = false;
+
+	r->mode = SERVE_MODE_RECIPROCAL;
+	r->from = r->to = 0UI64;
+	r->dir = 0;
+	r->size = SERVE_DEFAULT_SIZE;
+	r->format = SERVE_FORMAT_BMP;
+	r->seed = 1UI64;
+	r->words = ALU_LENGTH_U64;
+	r->base = 3UI64;
+
+	while (*query != '\0')
+	{
+		int n = 0;
+		if ((sscanf(query, "%15[^=&]=%31[^&]%n", name, text, &n) != 2) || (n == 0))
+		{
+			snprintf(error, max_error, "Expected name=value at %.40s\n", query);
+			return false;
+		}
+		query += n;
+		if (*query == '&')
+			query++;
+
+		uint64 x = strtoull(text, NULL, 0);
+		if (strcmp(name, "mode") == 0)
+		{
+			for (r->mode = SERVE_N_MODES - 1; r->mode >= 0; r->mode--)
+			{
+				if (strcmp(text, (r->mode < SERVE_MODE_SEQUENCE) ? serve_mode_names[r->mode] : SEQ_names[r->mode - SERVE_MODE_SEQUENCE]) == 0)
+					break;
+			}
+		}
+		else if (strcmp(name, "format") == 0)
+		{
+			for (r->format = SERVE_N_FORMATS - 1; r->format >= 0; r->format--)
+			{
+				if (strcmp(text, serve_format_names[r->format]) == 0)
+					break;
+			}
+		}
+		else if (strcmp(name, "value") == 0)
+		{
+			r->from = r->to = x;
+			have_from = have_to = true;
+		}
+		else if (strcmp(name, "from") == 0)
+		{
+			r->from = x;
+			have_from = true;
+		}
+		else if (strcmp(name, "to") == 0)
+		{
+			r->to = x;
+			have_to = true;
+		}
+		else if (strcmp(name, "dir") == 0)
+			r->dir = (x <= 3UI64) ? (int)x : -1;
+		else if (strcmp(name, "size") == 0)
+			r->size = (x <= SERVE_MAX_SIZE) ? (int)x : 0;
+		else if (strcmp(name, "seed") == 0)
+			r->seed = x;
+		else if (strcmp(name, "words") == 0)
+			r->words = (x <= ALU_LENGTH_U64) ? (int)x : 0;
+		else if (strcmp(name, "base") == 0)
+			r->base = x;
+		else
+		{
+			snprintf(error, max_error, "Unknown parameter %s\n", name);
+			return false;
+		}
+	}
+
+	if (!have_to)
+		r->to = r->from;
+
+	if (r->mode < 0)
+		snprintf(error, max_error, "Mode is reciprocal, factorial, random, power, fibonacci, primorial or binomial\n");
+	else if (r->format < 0)
+		snprintf(error, max_error, "Format is bmp or pgm\n");
+	else if (!have_from)
+		snprintf(error, max_error, "Give value, or from & to\n");
+	else if ((r->to < r->from) || (r->to - r->from >= SERVE_MAX_TILES))
+		snprintf(error, max_error, "A range is from <= to, of up to %d values\n", SERVE_MAX_TILES);
+	else if (r->dir < 0)
+		snprintf(error, max_error, "Direction is 0..3\n");
+	else if (r->size < 1)
+		snprintf(error, max_error, "Size is 1..%d\n", SERVE_MAX_SIZE);
+	else if ((r->to - r->from + 1) * r->size * r->size > SERVE_MAX_PIXELS)
+		snprintf(error, max_error, "Over %d pixels; make the range or the size smaller\n", SERVE_MAX_PIXELS);
+	else if ((r->mode == SERVE_MODE_RECIPROCAL) && (r->from < 2UI64))
+		snprintf(error, max_error, "Reciprocals are of 2 and up\n");
+	else if ((r->mode == SERVE_MODE_RANDOM) && (r->words < 1))
+		snprintf(error, max_error, "Words is 1..%d\n", ALU_LENGTH_U64);
+	else if ((r->mode == SERVE_MODE_SEQUENCE + SEQ_POWER) && (r->base < 2UI64))
+		snprintf(error, max_error, "Base is 2 and up\n");
+	else
+		return true;
+
+	return false;
+}
+
+/******************************************************************************
+** Function:	Cache key for a request
+**
+** Notes:		From the parsed request, so the order of the parameters
+**				doesn't matter
+*/
+void serve_key(const serve_request_type* r, char* key)
+{
+	snprintf(key, SERVE_KEY_LENGTH, "%d %llu %llu %d %d %d %llu %d", r->mode, r->from, r->to, r->dir, r->size, r->format,
+		(r->mode == SERVE_MODE_RANDOM) ? r->seed : (r->mode == SERVE_MODE_SEQUENCE + SEQ_POWER) ? r->base : 0UI64,
+		(r->mode == SERVE_MODE_RANDOM) ? r->words : 0);
+}
+
+/******************************************************************************
+** Function:	Walk the ant over a value, MS bit first, into a tile of size
+**				by size cells, starting in its centre
+**
+** Notes:		As app_walker_bits, including the leading zeroes skipped
+*/
+void serve_walk(uint32* tile, int stride, int size, ALU_view_type v, int dir)
+{
+	CALC_ant_type ant;
+	bool started = false;
+
+	ant.pos_x = size / 2;
+	ant.pos_y = size / 2;
+	ant.dir_x = (~dir & 0x01) * (dir - 1);
+	ant.dir_y = (dir & 0x01) * ((dir ^ 0x03) - 1);
+
+	for (int k = 0; k < v.length_words; k++)
+	{
+		uint64 c = v.word(k);
+		uint64 m = 1UI64 << 63;
+
+		if (!started)
+		{
+			if (c == 0UI64)
+				continue;
+
+			while ((c & m) == 0UI64)
+				m >>= 1;
+			started = true;
+		}
+
+		for (; m != 0UI64; m >>= 1)
+		{
+			bool bit = ((c & m) != 0UI64);
+
+			if (((unsigned)ant.pos_x < (unsigned)size) && ((unsigned)ant.pos_y < (unsigned)size))
+				tile[ant.pos_y * stride + ant.pos_x] = bit ? SERVE_COLOUR_BLACK : SERVE_COLOUR_WHITE;
+			CALC_ant_step(&ant, bit);
+		}
+	}
+}
+
+/******************************************************************************
+** Function:	Render a plot into an HTTP response
+**
+** Notes:		Tiles fill a grid, row by row, near enough square. Returns
+**				false, with an error response, if a value can't be made.
+*/
+bool serve_render(serve_worker_type* w, const serve_request_type* r, serve_response_type response)
+{
+	TRACE_SPAN("serve render");
+	int n_tiles = (int)(r->to - r->from + 1);
+	int columns = 1;
+	while (columns * columns < n_tiles)
+		columns++;
+	int width = columns * r->size;
+	int height = ((n_tiles + columns - 1) / columns) * r->size;
+
+	w->canvas.assign((size_t)width * height, SERVE_COLOUR_BACKGROUND);
+	for (int i = 0; i < n_tiles; i++)
+	{
+		uint64 value = r->from + i;
+		ALU_view_type v;
+
+		switch (r->mode)
+		{
+		case SERVE_MODE_RECIPROCAL:
+		{
+			uint64 remainder = 1UI64;
+			for (int k = 0; k < 2 * ALU_LENGTH_U64; k++)
+				w->value[2 * ALU_LENGTH_U64 - 1 - k] = CYCLE_reciprocal_word(value, &remainder);
+			w->value[0] &= ~1UI64;							// as CALC_reciprocal
+			v = ALU_view(w->value, 2 * ALU_LENGTH_U64);
+			break;
+		}
+
+		case SERVE_MODE_FACTORIAL:
+			if (!CALC_factorial(w->job, value))
+			{
+				char error[SERVE_MAX_TEXT];
+				snprintf(error, sizeof(error), "%llu! is too big for the ALU\n", value);
+				*response = *serve_text("400 Bad Request", error);
+				return false;
+			}
+			v = ALU_view(w->job->f_reg, 2 * ALU_LENGTH_U64);
+			break;
+
+		case SERVE_MODE_RANDOM:
+			RANDOM_fill(w->value, r->words, r->seed, value);
+			v = ALU_view(w->value, r->words);
+			break;
+
+		default:
+			SEQ_set(&w->sequence, r->mode - SERVE_MODE_SEQUENCE, r->base);
+			if (!SEQ_term(&w->sequence, w->job, value))
+			{
+				char error[SERVE_MAX_TEXT];
+				snprintf(error, sizeof(error), "Term %llu of %s is too big for the ALU\n", value, SEQ_names[w->sequence.kind]);
+				*response = *serve_text("400 Bad Request", error);
+				return false;
+			}
+			v = ALU_view(w->sequence.value, SEQ_WORDS);
+			break;
+		}
+
+		serve_walk(&w->canvas[(size_t)(i / columns) * r->size * width + (i % columns) * r->size], width, r->size, v, r->dir);
+	}
+
+	// Encode:
+	char header[256];
+	size_t n_pixels = (size_t)width * height;
+	size_t n_image = (r->format == SERVE_FORMAT_BMP) ? sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER) + 4 * n_pixels :
+		snprintf(NULL, 0, "P5\n%d %d\n255\n", width, height) + n_pixels;
+	int n_header = snprintf(header, sizeof(header),
+		"HTTP/1.0 200 OK\r\nContent-Type: %s\r\nContent-Length: %llu\r\nConnection: close\r\n\r\n",
+		serve_content_types[r->format], (uint64)n_image);
+
+	response->assign(header, header + n_header);
+	response->reserve(n_header + n_image);
+	if (r->format == SERVE_FORMAT_BMP)
+	{
+		BITMAPFILEHEADER file_header;
+		BITMAPINFOHEADER info_header;
+
+		memset(&file_header, 0, sizeof(file_header));
+		file_header.bfType = 0x4D42;						// "BM"
+		file_header.bfSize = (DWORD)n_image;
+		file_header.bfOffBits = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER);
+
+		memset(&info_header, 0, sizeof(info_header));
+		info_header.biSize = sizeof(BITMAPINFOHEADER);
+		info_header.biWidth = width;
+		info_header.biHeight = -height;						// top-down
+		info_header.biPlanes = 1;
+		info_header.biBitCount = 32;
+		info_header.biCompression = BI_RGB;
+
+		response->insert(response->end(), (const uint8*)&file_header, (const uint8*)(&file_header + 1));
+		response->insert(response->end(), (const uint8*)&info_header, (const uint8*)(&info_header + 1));
+		response->insert(response->end(), (const uint8*)w->canvas.data(), (const uint8*)(w->canvas.data() + n_pixels));
+	}
+	else
+	{
+		n_header = snprintf(header, sizeof(header), "P5\n%d %d\n255\n", width, height);
+		response->insert(response->end(), header, header + n_header);
+		for (size_t i = 0; i < n_pixels; i++)
+		{
+			uint32 c = w->canvas[i];
+			response->push_back((uint8)((77 * ((c >> 16) & 0xFF) + 150 * ((c >> 8) & 0xFF) + 29 * (c & 0xFF)) >> 8));
+		}
+	}
+
+	return true;
+}
+
+/******************************************************************************
+** Function:	Response for a plot: cached, rendered for another request
+**				meanwhile, or rendered now
+**
+** Notes:		If every slot is being rendered, the plot is rendered without
+**				being cached. Error responses are cached too, with *p_ok
+**				false, so every request answered with one counts as an error.
+*/
+serve_response_type serve_lookup(serve_worker_type* w, const serve_request_type* r, bool* p_ok)
+{
+	char key[SERVE_KEY_LENGTH];
+	bool waited = false;
+
+	serve_key(r, key);
+	std::unique_lock<std::mutex> lock(serve_mutex);
+
+	do
+	{
+		serve_slot_type* p_found = NULL;
+		for (int i = 0; i < SERVE_CACHE_ENTRIES; i++)
+		{
+			if ((serve_slots[i].state != SERVE_SLOT_EMPTY) && (strcmp(serve_slots[i].key, key) == 0))
+				p_found = &serve_slots[i];
+		}
+
+		if (p_found == NULL)
+			break;
+
+		if (p_found->state == SERVE_SLOT_READY)
+		{
+			if (!waited)
+				serve_n_hits++;
+			p_found->last_used = ++serve_clock;
+			*p_ok = p_found->ok;
+			return p_found->response;
+		}
+
+		if (!waited)
+			serve_n_coalesced++;
+		waited = true;
+		serve_rendered.wait(lock);
+	} while (true);
+
+	// Claim an empty slot, or else the least recently used:
+	serve_slot_type* p_slot = NULL;
+	for (int i = 0; (i < SERVE_CACHE_ENTRIES) && ((p_slot == NULL) || (p_slot->state != SERVE_SLOT_EMPTY)); i++)
+	{
+		serve_slot_type* p = &serve_slots[i];
+		if ((p->state == SERVE_SLOT_EMPTY) || ((p->state == SERVE_SLOT_READY) && ((p_slot == NULL) || (p->last_used < p_slot->last_used))))
+			p_slot = p;
+	}
+	if (p_slot != NULL)
+	{
+		strcpy(p_slot->key, key);
+		p_slot->state = SERVE_SLOT_RENDERING;
+		p_slot->response.reset();
+	}
+	lock.unlock();
+
+	auto t0 = std::chrono::steady_clock::now();
+	serve_response_type response = std::make_shared<std::vector<uint8>>();
+	*p_ok = serve_render(w, r, response);
+	double ms = serve_ms(t0);
+
+	lock.lock();
+	serve_n_rendered++;
+	STATS_add(&serve_render_ms, ms);
+	if (p_slot != NULL)
+	{
+		p_slot->response = response;
+		p_slot->ok = *p_ok;
+		p_slot->state = SERVE_SLOT_READY;
+		p_slot->last_used = ++serve_clock;
+		serve_rendered.notify_all();
+	}
+
+	return response;
+}
+
+/******************************************************************************
+** Function:	Read a request from a connection, answer it & close it
+**
+** Notes:
+*/
+void serve_connection(serve_worker_type* w, SOCKET s, std::chrono::steady_clock::time_point accepted)
+{
+	char text[SERVE_MAX_REQUEST + 1];
+	char method[8];
+	char path[SERVE_MAX_REQUEST + 1];
+	char error[SERVE_MAX_TEXT];
+	serve_request_type r;
+	serve_response_type response;
+	bool ok = false;
+	int n = 0;
+	int n_received;
+
+	DWORD timeout = SERVE_RECEIVE_MS;
+	setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+
+	// Read the header, up to the blank line after it:
+	text[0] = '\0';
+	while ((n < SERVE_MAX_REQUEST) && (strstr(text, "\r\n\r\n") == NULL) && (strstr(text, "\n\n") == NULL) &&
+		((n_received = recv(s, &text[n], SERVE_MAX_REQUEST - n, 0)) > 0))
+	{
+		n += n_received;
+		text[n] = '\0';
+	}
+
+	if ((sscanf(text, "%7s %2048s", method, path) != 2) || (strcmp(method, "GET") != 0))	// width is SERVE_MAX_REQUEST
+		response = serve_text("400 Bad Request", "Only GET is served\n");
+	else if (strcmp(path, "/stats") == 0)
+	{
+		SERVE_stats_text(error, sizeof(error));
+		response = serve_text("200 OK", error);
+		ok = true;
+	}
+	else if ((strncmp(path, "/plot", 5) == 0) && ((path[5] == '\0') || (path[5] == '?')))
+	{
+		if (serve_parse((path[5] == '?') ? &path[6] : "", &r, error, sizeof(error)))
+		{
+			response = serve_lookup(w, &r, &ok);
+		}
+		else
+			response = serve_text("400 Bad Request", error);
+	}
+	else
+		response = serve_text("404 Not Found", "Try /plot?mode=reciprocal&value=113, or /stats\n");
+
+	const char* p = (const char*)response->data();
+	int n_left = (int)response->size();
+	int n_sent;
+	while ((n_left > 0) && ((n_sent = send(s, p, n_left, 0)) > 0))
+	{
+		p += n_sent;
+		n_left -= n_sent;
+	}
+	closesocket(s);
+
+	std::lock_guard<std::mutex> lock(serve_mutex);
+	serve_n_requests++;
+	if (!ok)
+		serve_n_errors++;
+	STATS_add(&serve_latency, serve_ms(accepted));
+}
+
+/******************************************************************************
+** Function:	Worker thread: answer queued connections until told to quit
+**
+** Notes:		Connections still queued when told to quit are answered first
+*/
+void serve_worker(void)
+{
+	serve_worker_type* w = new serve_worker_type();
+	w->job = CALC_create_job();
+
+	do
+	{
+		SOCKET s;
+		std::chrono::steady_clock::time_point accepted;
+		{
+			std::unique_lock<std::mutex> lock(serve_queue_mutex);
+			serve_queue_ready.wait(lock, [] { return serve_quit || (serve_queue_head != serve_queue_tail); });
+			if (serve_queue_head == serve_queue_tail)
+				break;
+
+			s = serve_queue[serve_queue_tail & (SERVE_QUEUE_LENGTH - 1)];
+			accepted = serve_queue_time[serve_queue_tail & (SERVE_QUEUE_LENGTH - 1)];
+			serve_queue_tail++;
+		}
+
+		serve_connection(w, s, accepted);
+	} while (true);
+
+	CALC_destroy_job(w->job);
+	delete w;
+}
+
+/******************************************************************************
+** Function:	Serve plots on a port of this machine until cancelled
+**
+** Notes:		Runs POOL_threads() workers. p_progress counts connections.
+**				The cache is kept from one run to the next; the stats start
+**				again. Returns false if the port can't be listened on.
+*/
+bool SERVE_run(int port, std::atomic<uint64>* p_progress, const std::atomic<bool>* p_cancel)
+{
+	WSADATA wsa_data;
+	sockaddr_in address;
+	std::vector<std::thread> workers;
+	uint64 n_accepted = 0UI64;
+
+	if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
+		return false;
+
+	SOCKET listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons((u_short)port);
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);			// this machine only
+	if ((listener == INVALID_SOCKET) || (bind(listener, (const sockaddr*)&address, sizeof(address)) != 0) ||
+		(listen(listener, SOMAXCONN) != 0))
+	{
+		if (listener != INVALID_SOCKET)
+			closesocket(listener);
+		WSACleanup();
+		return false;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(serve_mutex);
+		serve_n_requests = serve_n_errors = serve_n_refused = 0UI64;
+		serve_n_rendered = serve_n_hits = serve_n_coalesced = 0UI64;
+		memset(&serve_latency, 0, sizeof(serve_latency));
+		memset(&serve_render_ms, 0, sizeof(serve_render_ms));
+		serve_latency.bin_width = serve_render_ms.bin_width = SERVE_LATENCY_BIN_MS;
+		serve_latency.bin_ratio = serve_render_ms.bin_ratio = SERVE_LATENCY_BIN_RATIO;
+		serve_start = std::chrono::steady_clock::now();
+	}
+
+	serve_quit = false;
+	serve_queue_head = serve_queue_tail = 0;
+	for (int i = 0; i < POOL_threads(); i++)
+		workers.push_back(std::thread(serve_worker));
+
+	while (!*p_cancel)
+	{
+		fd_set readable;
+		timeval tick = { 0, SERVE_TICK_MS * 1000 };
+
+		FD_ZERO(&readable);
+		FD_SET(listener, &readable);
+		if (select((int)listener + 1, &readable, NULL, NULL, &tick) <= 0)
+			continue;
+
+		SOCKET s = accept(listener, NULL, NULL);
+		if (s == INVALID_SOCKET)
+			continue;
+
+		bool queued = false;
+		{
+			std::lock_guard<std::mutex> lock(serve_queue_mutex);
+			if (serve_queue_head - serve_queue_tail < SERVE_QUEUE_LENGTH)
+			{
+				serve_queue[serve_queue_head & (SERVE_QUEUE_LENGTH - 1)] = s;
+				serve_queue_time[serve_queue_head & (SERVE_QUEUE_LENGTH - 1)] = std::chrono::steady_clock::now();
+				serve_queue_head++;
+				serve_queue_ready.notify_one();
+				queued = true;
+			}
+		}
+
+		if (!queued)
+		{
+			closesocket(s);
+			std::lock_guard<std::mutex> lock(serve_mutex);
+			serve_n_refused++;
+		}
+
+		if (p_progress != NULL)
+			*p_progress = ++n_accepted;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(serve_queue_mutex);
+		serve_quit = true;
+		serve_queue_ready.notify_all();
+	}
+	for (auto& worker : workers)
+		worker.join();
+
+	closesocket(listener);
+	WSACleanup();
+	return true;
+}
+
+/******************************************************************************
+** Function:	Counts, throughput & latency since the service started
+**
+** Notes:		The /stats response. Returns the length of text.
+*/
+int SERVE_stats_text(char* text, int max_length)
+{
+	std::lock_guard<std::mutex> lock(serve_mutex);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - serve_start).count();
+
+	return snprintf(text, max_length,
+		"requests %llu\nerrors %llu\nrefused %llu\nrendered %llu\ncache_hits %llu\ncoalesced %llu\n"
+		"uptime_s %.1f\nrequests_per_s %.2f\n"
+		"latency_ms mean %.2f p50 %.2f p90 %.2f p99 %.2f max %.2f\n"
+		"render_ms mean %.2f p50 %.2f p90 %.2f p99 %.2f max %.2f\n",
+		serve_n_requests, serve_n_errors, serve_n_refused, serve_n_rendered, serve_n_hits, serve_n_coalesced,
+		seconds, (seconds > 0.0) ? serve_n_requests / seconds : 0.0,
+		STATS_mean(&serve_latency), STATS_percentile(&serve_latency, 0.5), STATS_percentile(&serve_latency, 0.9),
+		STATS_percentile(&serve_latency, 0.99), serve_latency.max,
+		STATS_mean(&serve_render_ms), STATS_percentile(&serve_render_ms, 0.5), STATS_percentile(&serve_render_ms, 0.9),
+		STATS_percentile(&serve_render_ms, 0.99), serve_render_ms.max);
+}
@@ -0,0 +1,26 @@
+/******************************************************************************
+** File:	Serve.h
+**
+** Notes:	Antplots on demand for other tools, over HTTP on a port of this
+**			machine only, e.g.
+**				GET /plot?mode=reciprocal&value=113&dir=1&size=512&format=bmp
+**				GET /plot?mode=factorial&from=100&to=115&format=pgm
+**				GET /plot?mode=random&value=7&seed=1&words=64
+**				GET /plot?mode=power&base=3&from=1000&to=1063
+**				GET /stats
+**			Modes fibonacci, primorial & binomial are as power, without a
+**			base. A range from..to gives a grid of tiles, one per value,
+**			each term of a sequence stepped on from the one before.
+**			Identical requests in flight are rendered once for all of them,
+**			& recent plots are served again from a cache.
+*/
+
+#define SERVE_DEFAULT_PORT		8642
+#define SERVE_CACHE_ENTRIES		64			// plots kept; the least recently used goes first
+#define SERVE_DEFAULT_SIZE		512			// tile width & height, in cells
+#define SERVE_MAX_SIZE			2048
+#define SERVE_MAX_TILES			256			// values in a range
+#define SERVE_MAX_PIXELS		(16 << 20)	// in all the tiles of a plot
+
+bool SERVE_run(int port, std::atomic<uint64>* p_progress, const std::atomic<bool>* p_cancel);
+int SERVE_stats_text(char* text, int max_length);
@@ -0,0 +1,569 @@
+/******************************************************************************
+** File:	Stats.cpp
+**
+** Notes:	Monte Carlo walks of random bit strings. Each pool task walks its
+**			share of the strings on its own board, into its own histograms,
+**			& the histograms are added together at the end. String s is
+**			stream s of the seed, so the same strings are walked, & the same
+**			histograms made, whatever the number of threads. Sweeps of 1 / v
+**			are split the same way, by v.
+*/
+
+#include "stdafx.h"
+
+#include "Accum.h"
+#include "Alu.h"
+#include "Calc.h"
+#include "Pool.h"
+#include "Random.h"
+#include "Stats.h"
+#include "Trace.h"
+
+#define STATS_BOARD_MASK		(STATS_BOARD_SIZE - 1)
+#define STATS_BOARD_WORDS		((STATS_BOARD_SIZE * STATS_BOARD_SIZE) / 64)
+#define STATS_PROGRESS_SAMPLES	1024		// samples between progress updates
+
+typedef struct
+{
+	uint64 n_samples;
+	int length_words;
+	uint64 seed;
+	uint64 v_from;
+	int n_tasks;
+	std::atomic<uint64>* p_progress;
+	const std::atomic<bool>* p_cancel;
+	STATS_result_type part[POOL_MAX_THREADS];
+} stats_context_type;
+
+const char* const stats_metric_names[STATS_N_METRICS] = { "Displacement", "Bounding box extent", "Bounding box area", "Revisit ratio" };
+
+/******************************************************************************
+** Function:	Empty distributions, with bins scaled to the string length
+**
+** Notes:		Random walks spread as the square root of their steps, so
+**				distances are binned up to a few times sqrt(steps), & areas
+**				up to a few times steps
+*/
+void stats_clear(STATS_result_type* result, uint64 n_samples, int length_words, uint64 seed)
+{
+	double steps = 64.0 * length_words;
+
+	memset(result, 0, sizeof(STATS_result_type));
+	result->n_samples = n_samples;
+	result->length_words = length_words;
+	result->seed = seed;
+
+	result->metric[STATS_DISPLACEMENT].bin_width = (4.0 * sqrt(steps)) / STATS_N_BINS;
+	result->metric[STATS_EXTENT].bin_width = (6.0 * sqrt(steps)) / STATS_N_BINS;
+	result->metric[STATS_AREA].bin_width = (4.0 * steps) / STATS_N_BINS;
+	result->metric[STATS_REVISITS].bin_width = 1.0 / STATS_N_BINS;
+}
+
+/******************************************************************************
+** Function:	Bin a value falls in
+**
+** Notes:		In doubles until clamped, so huge values can't overflow the int
+*/
+int stats_bin(const STATS_distribution_type* d, double v)
+{
+	double bin;
+
+	if (d->bin_ratio == 0.0)
+		bin = v / d->bin_width;
+	else
+		bin = (v < d->bin_width) ? 0.0 : 1.0 + (log(v / d->bin_width) / log(d->bin_ratio));
+
+	return (bin < 0.0) ? 0 : (bin < STATS_N_BINS) ? (int)bin : STATS_N_BINS - 1;
+}
+
+/******************************************************************************
+** Function:	Lower edge of bin i
+**
+** Notes:
+*/
+double stats_bin_low(const STATS_distribution_type* d, int i)
+{
+	if (d->bin_ratio == 0.0)
+		return i * d->bin_width;
+
+	return (i == 0) ? 0.0 : d->bin_width * pow(d->bin_ratio, i - 1);
+}
+
+/******************************************************************************
+** Function:	Add a value to a distribution
+**
+** Notes:
+*/
+void STATS_add(STATS_distribution_type* d, double v)
+{
+	d->bins[stats_bin(d, v)]++;
+	if ((d->n == 0UI64) || (v < d->min))
+		d->min = v;
+	if ((d->n == 0UI64) || (v > d->max))
+		d->max = v;
+	d->n++;
+	d->sum += v;
+	d->sum_squares += v * v;
+}
+
+/******************************************************************************
+** Function:	dest += src, for distributions with the same bins
+**
+** Notes:
+*/
+void stats_merge(STATS_distribution_type* dest, const STATS_distribution_type* src)
+{
+	if (src->n == 0UI64)
+		return;
+
+	if ((dest->n == 0UI64) || (src->min < dest->min))
+		dest->min = src->min;
+	if ((dest->n == 0UI64) || (src->max > dest->max))
+		dest->max = src->max;
+	dest->n += src->n;
+	dest->sum += src->sum;
+	dest->sum_squares += src->sum_squares;
+	for (int i = 0; i < STATS_N_BINS; i++)
+		dest->bins[i] += src->bins[i];
+}
+
+/******************************************************************************
+** Function:	Metrics of a walk, from where it ended, its bounding box, &
+**				the cells it coloured for the first time
+**
+** Notes:		Fills metrics[STATS_N_METRICS]
+*/
+void stats_metrics(int x, int y, int min_x, int max_x, int min_y, int max_y, uint64 steps, uint64 new_cells, double* metrics)
+{
+	int width = max_x - min_x + 1;
+	int height = max_y - min_y + 1;
+
+	metrics[STATS_DISPLACEMENT] = sqrt(((double)x * x) + ((double)y * y));
+	metrics[STATS_EXTENT] = (width > height) ? width : height;
+	metrics[STATS_AREA] = (double)width * height;
+	metrics[STATS_REVISITS] = (steps == 0UI64) ? 0.0 : 1.0 - ((double)new_cells / (double)steps);
+}
+
+/******************************************************************************
+** Function:	Clear the board after a walk with the given bounding box
+**
+** Notes:		Only the rows & columns of the bounding box are cleared,
+**				unless it spans the board
+*/
+void stats_clear_board(uint64* board, int min_x, int max_x, int min_y, int max_y)
+{
+	if ((max_x - min_x + 1 >= STATS_BOARD_SIZE) || (max_y - min_y + 1 >= STATS_BOARD_SIZE))
+		memset(board, 0, STATS_BOARD_WORDS * sizeof(uint64));
+	else
+	{
+		for (int row = min_y; row <= max_y; row++)
+		{
+			for (int column = min_x & ~63; column <= max_x; column += 64)
+				board[((row & STATS_BOARD_MASK) << (STATS_BOARD_BITS - 6)) | ((column & STATS_BOARD_MASK) >> 6)] = 0UI64;
+		}
+	}
+}
+
+/******************************************************************************
+** Function:	Walk the ant over a bit string, MS bit of v[0] first
+**
+** Notes:		Same rule, leading zero suppression & starting direction as
+**				the antplot (direction 0). board must be clear, & is left clear:
+**				only the rows & columns of the bounding box are cleared.
+**				Fills metrics[STATS_N_METRICS].
+*/
+void STATS_walk(const uint64* v, int length_words, uint64* board, double* metrics)
+{
+	CALC_ant_type ant = { 0, 0, -1, 0 };
+	int min_x = 0, max_x = 0, min_y = 0, max_y = 0;
+	uint64 steps = 0UI64, new_cells = 0UI64;
+	bool started = false;
+
+	for (int i = 0; i < length_words; i++)
+	{
+		uint64 c = v[i];
+		uint64 m = 1UI64 << 63;
+
+		if (!started)
+		{
+			if (c == 0UI64)
+				continue;
+
+			while ((c & m) == 0UI64)				// find first non-zero bit
+				m >>= 1;
+			started = true;
+		}
+
+		for (; m != 0UI64; m >>= 1)
+		{
+			uint64* p = &board[((ant.pos_y & STATS_BOARD_MASK) << (STATS_BOARD_BITS - 6)) | ((ant.pos_x & STATS_BOARD_MASK) >> 6)];
+			uint64 cell = 1UI64 << (ant.pos_x & 63);
+			new_cells += ((*p & cell) == 0UI64);
+			*p |= cell;
+
+			CALC_ant_step(&ant, (c & m) != 0UI64);
+
+			min_x = (ant.pos_x < min_x) ? ant.pos_x : min_x;
+			max_x = (ant.pos_x > max_x) ? ant.pos_x : max_x;
+			min_y = (ant.pos_y < min_y) ? ant.pos_y : min_y;
+			max_y = (ant.pos_y > max_y) ? ant.pos_y : max_y;
+			steps++;
+		}
+	}
+
+	stats_metrics(ant.pos_x, ant.pos_y, min_x, max_x, min_y, max_y, steps, new_cells, metrics);
+	stats_clear_board(board, min_x, max_x, min_y, max_y);
+}
+
+/******************************************************************************
+** Function:	Pool task: walk one share of the strings
+**
+** Notes:
+*/
+void stats_task(int task, void* p_context)
+{
+	stats_context_type* c = (stats_context_type*)p_context;
+	uint64 first = (c->n_samples * task) / c->n_tasks;
+	uint64 end = (c->n_samples * (task + 1)) / c->n_tasks;
+	uint64* board = new uint64[STATS_BOARD_WORDS]();
+	uint64* v = new uint64[c->length_words];
+	double metrics[STATS_N_METRICS];
+
+	stats_clear(&c->part[task], end - first, c->length_words, c->seed);
+	for (uint64 s = first; s < end; s++)
+	{
+		RANDOM_fill(v, c->length_words, c->seed, s);
+		STATS_walk(v, c->length_words, board, metrics);
+		for (int k = 0; k < STATS_N_METRICS; k++)
+			STATS_add(&c->part[task].metric[k], metrics[k]);
+
+		if (((s - first) % STATS_PROGRESS_SAMPLES) == STATS_PROGRESS_SAMPLES - 1)
+		{
+			if ((c->p_cancel != NULL) && c->p_cancel->load(std::memory_order_relaxed))
+				break;
+			if (c->p_progress != NULL)
+				*c->p_progress += STATS_PROGRESS_SAMPLES;
+		}
+	}
+
+	delete[] v;
+	delete[] board;
+}
+
+/******************************************************************************
+** Function:	Walk the first length_words words of 1 / v
+**
+** Notes:		One value at a time, for CPUs without AVX-512 & the values
+**				left over. words holds length_words words.
+*/
+void stats_walk_reciprocal(uint64 v, uint64* words, int length_words, uint64* board, double* metrics)
+{
+	uint64 r = 1UI64;
+
+	for (int i = 0; i < length_words; i++)
+		words[i] = _udiv128(r, 0UI64, v, &r);
+
+	STATS_walk(words, length_words, board, metrics);
+}
+
+/******************************************************************************
+** Function:	Walk the first length_words words of 1 / v, for STATS_LANES
+**				values of v side by side, with AVX-512
+**
+** Notes:		Lane l makes the bits of 1 / v[l] one at a time, as r = 2 r
+**				mod v, & walks each on its own board as it's made, so there's
+**				no buffer & no lane waits for another. Lanes whose first 1 bit
+**				hasn't come yet are masked off. Each lane's board is coloured
+**				by gathering & scattering its word. Same walk & metrics as
+**				STATS_walk of the expansion; v < STATS_SWEEP_MAX_V. Fills
+**				metrics[l * STATS_N_METRICS + k].
+*/
+void stats_walk_lanes(const uint64* v, int length_words, uint64* boards, double* metrics)
+{
+	int64 lane_words[STATS_LANES];
+	int64 x[STATS_LANES], y[STATS_LANES], min_x[STATS_LANES], max_x[STATS_LANES], min_y[STATS_LANES], max_y[STATS_LANES];
+	uint64 steps[STATS_LANES], new_cells[STATS_LANES];
+
+	for (int l = 0; l < STATS_LANES; l++)
+		lane_words[l] = l * (int64)STATS_BOARD_WORDS;
+
+	const __m512i zero = _mm512_setzero_si512();
+	const __m512i one = _mm512_set1_epi64(1);
+	const __m512i board_mask = _mm512_set1_epi64(STATS_BOARD_MASK);
+	const __m512i lane_base = _mm512_loadu_si512(lane_words);
+	const __m512i vv = _mm512_loadu_si512(v);
+	__m512i r = one;
+	__m512i px = zero, py = zero, dir_x = _mm512_set1_epi64(-1), dir_y = zero;
+	__m512i low_x = zero, high_x = zero, low_y = zero, high_y = zero;
+	__m512i n_steps = zero, n_new = zero;
+	__mmask8 started = 0;
+
+	for (int i = 0; i < 64 * length_words; i++)
+	{
+		// Next bit, & r = 2 r mod v:
+		__m512i r2 = _mm512_add_epi64(r, r);
+		__mmask8 bit = _mm512_cmpge_epu64_mask(r2, vv);
+		r = _mm512_mask_sub_epi64(r2, bit, r2, vv);
+
+		started |= bit;							// leading zeroes are suppressed
+		if (started == 0)
+			continue;
+
+		// Colour the cell, counting it if it's new:
+		__m512i index = _mm512_or_si512(lane_base, _mm512_or_si512(
+			_mm512_slli_epi64(_mm512_and_si512(py, board_mask), STATS_BOARD_BITS - 6),
+			_mm512_srli_epi64(_mm512_and_si512(px, board_mask), 6)));
+		__m512i cell = _mm512_sllv_epi64(one, _mm512_and_si512(px, _mm512_set1_epi64(63)));
+		__m512i w = _mm512_mask_i64gather_epi64(zero, started, index, boards, 8);
+		n_new = _mm512_mask_add_epi64(n_new, _mm512_mask_testn_epi64_mask(started, w, cell), n_new, one);
+		_mm512_mask_i64scatter_epi64(boards, started, index, _mm512_or_si512(w, cell), 8);
+
+		// Turn as CALC_ant_step, negating where bit == (dir_x == 0), & move:
+		__mmask8 negate = bit ^ _mm512_test_epi64_mask(dir_x, dir_x);
+		__m512i turned_x = _mm512_mask_sub_epi64(dir_y, negate, zero, dir_y);
+		__m512i turned_y = _mm512_mask_sub_epi64(dir_x, negate, zero, dir_x);
+		dir_x = _mm512_mask_mov_epi64(dir_x, started, turned_x);
+		dir_y = _mm512_mask_mov_epi64(dir_y, started, turned_y);
+		px = _mm512_mask_add_epi64(px, started, px, dir_x);
+		py = _mm512_mask_add_epi64(py, started, py, dir_y);
+		n_steps = _mm512_mask_add_epi64(n_steps, started, n_steps, one);
+
+		low_x = _mm512_min_epi64(low_x, px);
+		high_x = _mm512_max_epi64(high_x, px);
+		low_y = _mm512_min_epi64(low_y, py);
+		high_y = _mm512_max_epi64(high_y, py);
+	}
+
+	_mm512_storeu_si512(x, px);
+	_mm512_storeu_si512(y, py);
+	_mm512_storeu_si512(min_x, low_x);
+	_mm512_storeu_si512(max_x, high_x);
+	_mm512_storeu_si512(min_y, low_y);
+	_mm512_storeu_si512(max_y, high_y);
+	_mm512_storeu_si512(steps, n_steps);
+	_mm512_storeu_si512(new_cells, n_new);
+
+	for (int l = 0; l < STATS_LANES; l++)
+	{
+		stats_metrics((int)x[l], (int)y[l], (int)min_x[l], (int)max_x[l], (int)min_y[l], (int)max_y[l],
+			steps[l], new_cells[l], &metrics[l * STATS_N_METRICS]);
+		stats_clear_board(&boards[l * STATS_BOARD_WORDS], (int)min_x[l], (int)max_x[l], (int)min_y[l], (int)max_y[l]);
+	}
+}
+
+/******************************************************************************
+** Function:	Pool task: walk 1 / v for one share of the values of v
+**
+** Notes:		STATS_LANES at a time with AVX-512, else one at a time
+*/
+void stats_sweep_task(int task, void* p_context)
+{
+	stats_context_type* c = (stats_context_type*)p_context;
+	uint64 first = (c->n_samples * task) / c->n_tasks;
+	uint64 end = (c->n_samples * (task + 1)) / c->n_tasks;
+	int n_lanes = (ACCUM_level() == ACCUM_AVX512) ? STATS_LANES : 1;
+	uint64* boards = new uint64[n_lanes * STATS_BOARD_WORDS]();
+	uint64* words = new uint64[c->length_words];
+	uint64 v[STATS_LANES];
+	double metrics[STATS_LANES * STATS_N_METRICS];
+	uint64 done = 0UI64;
+
+	stats_clear(&c->part[task], end - first, c->length_words, c->seed);
+	for (uint64 s = first; s < end; )
+	{
+		int n = ((n_lanes == STATS_LANES) && (end - s >= STATS_LANES)) ? STATS_LANES : 1;
+
+		for (int l = 0; l < n; l++)
+			v[l] = c->v_from + s + l;
+		if (n == STATS_LANES)
+			stats_walk_lanes(v, c->length_words, boards, metrics);
+		else
+			stats_walk_reciprocal(v[0], words, c->length_words, boards, metrics);
+
+		for (int l = 0; l < n; l++)
+		{
+			for (int k = 0; k < STATS_N_METRICS; k++)
+				STATS_add(&c->part[task].metric[k], metrics[l * STATS_N_METRICS + k]);
+		}
+		s += n;
+
+		done += n;
+		if (done >= STATS_PROGRESS_SAMPLES)
+		{
+			if ((c->p_cancel != NULL) && c->p_cancel->load(std::memory_order_relaxed))
+				break;
+			if (c->p_progress != NULL)
+				*c->p_progress += done;
+			done = 0UI64;
+		}
+	}
+
+	delete[] words;
+	delete[] boards;
+}
+
+/******************************************************************************
+** Function:	Run p_task across the thread pool, & add up the parts
+**
+** Notes:		Returns false if cancelled
+*/
+bool stats_run_tasks(STATS_result_type* result, stats_context_type* c, POOL_task_type p_task)
+{
+	c->n_tasks = POOL_threads();
+	POOL_run(c->n_tasks, p_task, c);
+
+	stats_clear(result, c->n_samples, c->length_words, c->seed);
+	result->v_from = c->v_from;
+	for (int task = 0; task < c->n_tasks; task++)
+	{
+		for (int k = 0; k < STATS_N_METRICS; k++)
+			stats_merge(&result->metric[k], &c->part[task].metric[k]);
+	}
+	result->n_samples = result->metric[0].n;
+
+	return !((c->p_cancel != NULL) && c->p_cancel->load());
+}
+
+/******************************************************************************
+** Function:	Walk n_samples random strings of length_words each
+**
+** Notes:		Split across the thread pool. Returns false if cancelled.
+*/
+bool STATS_run(STATS_result_type* result, uint64 n_samples, int length_words, uint64 seed,
+	std::atomic<uint64>* p_progress, const std::atomic<bool>* p_cancel)
+{
+	stats_context_type* c = new stats_context_type;
+
+	TRACE_SPAN("Monte Carlo walks");
+	TRACE_COUNT(TRACE_COUNTER_PIXELS, n_samples * 64 * length_words);
+
+	c->n_samples = n_samples;
+	c->length_words = length_words;
+	c->seed = seed;
+	c->v_from = 0UI64;
+	c->p_progress = p_progress;
+	c->p_cancel = p_cancel;
+	bool completed = stats_run_tasks(result, c, stats_task);
+
+	delete c;
+	return completed;
+}
+
+/******************************************************************************
+** Function:	Walk the first length_words words of 1 / v, for n_values
+**				values of v from v_from
+**
+** Notes:		As STATS_run. 2 <= v < STATS_SWEEP_MAX_V.
+*/
+bool STATS_sweep(STATS_result_type* result, uint64 v_from, uint64 n_values, int length_words,
+	std::atomic<uint64>* p_progress, const std::atomic<bool>* p_cancel)
+{
+	stats_context_type* c = new stats_context_type;
+
+	TRACE_SPAN("reciprocal sweep");
+	TRACE_COUNT(TRACE_COUNTER_PIXELS, n_values * 64 * length_words);
+
+	c->n_samples = n_values;
+	c->length_words = length_words;
+	c->seed = 0UI64;
+	c->v_from = v_from;
+	c->p_progress = p_progress;
+	c->p_cancel = p_cancel;
+	bool completed = stats_run_tasks(result, c, stats_sweep_task);
+
+	delete c;
+	return completed;
+}
+
+/******************************************************************************
+** Function:
+**
+** Notes:
+*/
+double STATS_mean(const STATS_distribution_type* d)
+{
+	return (d->n == 0UI64) ? 0.0 : d->sum / d->n;
+}
+
+/******************************************************************************
+** Function:	Standard deviation
+**
+** Notes:		Of the sample, n - 1 in the denominator
+*/
+double STATS_sd(const STATS_distribution_type* d)
+{
+	if (d->n < 2UI64)
+		return 0.0;
+
+	double variance = (d->sum_squares - (d->sum * d->sum / d->n)) / (d->n - 1);
+	return (variance > 0.0) ? sqrt(variance) : 0.0;
+}
+
+/******************************************************************************
+** Function:	Value below which a fraction p of the samples fall
+**
+** Notes:		From the histogram, so to within a bin (to within a fraction
+**				bin_ratio - 1 for geometric bins); linear within the bin, &
+**				clamped to the exact min & max
+*/
+double STATS_percentile(const STATS_distribution_type* d, double p)
+{
+	double target = p * d->n;
+	double below = 0.0;
+
+	if (d->n == 0UI64)
+		return 0.0;
+
+	for (int i = 0; i < STATS_N_BINS; i++)
+	{
+		if ((d->bins[i] != 0UI64) && (below + d->bins[i] >= target))
+		{
+			double low = stats_bin_low(d, i);
+			double high = (i == STATS_N_BINS - 1) ? d->max : stats_bin_low(d, i + 1);
+			double v = low + ((high - low) * (target - below) / d->bins[i]);
+			return (v < d->min) ? d->min : (v > d->max) ? d->max : v;
+		}
+		below += d->bins[i];
+	}
+
+	return d->max;
+}
+
+/******************************************************************************
+** Function:	Print summary table
+**
+** Notes:		Distances are also given per sqrt(steps), & areas per step,
+**				so runs of different lengths can be compared
+*/
+void STATS_print(const STATS_result_type* result)
+{
+	double steps = 64.0 * result->length_words;
+	const double scale[STATS_N_METRICS] = { sqrt(steps), sqrt(steps), steps, 1.0 };
+	const char* const scale_names[STATS_N_METRICS] = { "per sqrt(steps)", "per sqrt(steps)", "per step", "" };
+
+	if (result->v_from != 0UI64)
+		printf("\n1 / v for %llu values of v from %llu, first %d bits:\n\n", result->n_samples, result->v_from, 64 * result->length_words);
+	else
+		printf("\n%llu random strings of %d bits (seed 0x%016llX):\n\n", result->n_samples, 64 * result->length_words, result->seed);
+	printf("%-20s %10s %10s %10s %10s %10s %10s %10s %10s\n", "", "Mean", "SD", "Min", "5%", "25%", "Median", "75%", "95%");
+	for (int k = 0; k < STATS_N_METRICS; k++)
+	{
+		const STATS_distribution_type* d = &result->metric[k];
+		printf("%-20s %10.4g %10.4g %10.4g %10.4g %10.4g %10.4g %10.4g %10.4g\n", stats_metric_names[k],
+			STATS_mean(d), STATS_sd(d), d->min, STATS_percentile(d, 0.05), STATS_percentile(d, 0.25),
+			STATS_percentile(d, 0.5), STATS_percentile(d, 0.75), STATS_percentile(d, 0.95));
+	}
+
+	printf("\n%-20s %10s %10s %10s %10s %10s\n", "Scaled", "Mean", "SD", "5%", "Median", "95%");
+	for (int k = 0; k < STATS_N_METRICS; k++)
+	{
+		const STATS_distribution_type* d = &result->metric[k];
+		if (scale[k] == 1.0)
+			continue;
+
+		printf("%-20s %10.4f %10.4f %10.4f %10.4f %10.4f  %s\n", stats_metric_names[k],
+			STATS_mean(d) / scale[k], STATS_sd(d) / scale[k], STATS_percentile(d, 0.05) / scale[k],
+			STATS_percentile(d, 0.5) / scale[k], STATS_percentile(d, 0.95) / scale[k], scale_names[k]);
+	}
+	printf("\n");
+}
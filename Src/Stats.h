@@ -0,0 +1,54 @@
+/******************************************************************************
+** File:	Stats.h
+**
+** Notes:	Monte Carlo baselines for antplots: walks many random bit strings
+**			with the antplot rule & gathers the distributions of how far the
+**			ant ends up from its start, the size of its bounding box, and
+**			how often it comes back to a cell it has already coloured.
+**			Plots of reciprocals, constants etc. can be judged against them.
+**			The same distributions for a range of reciprocals 1 / v come
+**			from a sweep, which walks 8 values of v at a time with AVX-512.
+*/
+
+#define STATS_N_BINS			256
+#define STATS_BOARD_BITS		12			// cells across; the edges join up
+#define STATS_BOARD_SIZE		(1 << STATS_BOARD_BITS)
+#define STATS_LANES				8			// values of v swept side by side
+#define STATS_SWEEP_MAX_V		(1UI64 << 63)	// sweeps are of v below this, so 2 r can't overflow
+
+// Metrics:
+#define STATS_DISPLACEMENT		0			// end to start, in cells
+#define STATS_EXTENT			1			// longer side of the bounding box
+#define STATS_AREA				2			// bounding box, in cells
+#define STATS_REVISITS			3			// fraction of steps onto a cell already coloured
+#define STATS_N_METRICS			4
+
+typedef struct
+{
+	uint64 n;
+	double sum, sum_squares;
+	double min, max;
+	double bin_width;						// bins cover 0 to STATS_N_BINS * bin_width; the last
+	double bin_ratio;						// takes everything above. With a ratio, bin 0 covers
+	uint64 bins[STATS_N_BINS];				// 0 to bin_width, & each after it is ratio times wider
+} STATS_distribution_type;
+
+typedef struct
+{
+	uint64 n_samples;
+	int length_words;
+	uint64 seed;
+	uint64 v_from;							// 1 / v for v from v_from, or 0 for random strings
+	STATS_distribution_type metric[STATS_N_METRICS];
+} STATS_result_type;
+
+bool STATS_run(STATS_result_type* result, uint64 n_samples, int length_words, uint64 seed,
+	std::atomic<uint64>* p_progress, const std::atomic<bool>* p_cancel);
+bool STATS_sweep(STATS_result_type* result, uint64 v_from, uint64 n_values, int length_words,
+	std::atomic<uint64>* p_progress, const std::atomic<bool>* p_cancel);
+void STATS_walk(const uint64* v, int length_words, uint64* board, double* metrics);
+void STATS_add(STATS_distribution_type* d, double v);
+double STATS_mean(const STATS_distribution_type* d);
+double STATS_sd(const STATS_distribution_type* d);
+double STATS_percentile(const STATS_distribution_type* d, double p);
+void STATS_print(const STATS_result_type* result);
@@ -0,0 +1,192 @@
+/******************************************************************************
+** File:	Store.cpp
+**
+** Notes:	Persistent store of computed registers, memory-mapped read-only.
+**			Files are replaced whole (write a temporary, then rename), so
+**			another process mapping an entry sees either the old or the new.
+*/
+
+#include "stdafx.h"
+
+#include "Alu.h"
+#include "Store.h"
+
+typedef struct
+{
+	const char* name;
+	int length_words;
+} store_entry_type;
+
+const store_entry_type store_entries[STORE_N_ENTRIES] =
+{
+	{ "e", ALU_LENGTH_U64 },
+	{ "e_decimal", 2 * ALU_LENGTH_U64 },
+	{ "pi", ALU_LENGTH_U64 },
+	{ "pi_decimal", 2 * ALU_LENGTH_U64 },
+	{ "factorial", 2 * ALU_LENGTH_U64 },
+	{ "a", ALU_LENGTH_U64 },
+	{ "b", ALU_LENGTH_U64 },
+	{ "l", 2 * ALU_LENGTH_U64 }
+};
+
+const STORE_header_type* store_view[STORE_N_ENTRIES];		// NULL if not mapped
+
+/******************************************************************************
+** Function:	Filename for an entry
+**
+** Notes:
+*/
+void store_filename(char* filename, int id, const char* suffix)
+{
+	sprintf(filename, STORE_FILENAME_PREFIX "%s" STORE_FILENAME_SUFFIX "%s", store_entries[id].name, suffix);
+}
+
+/******************************************************************************
+** Function:	Unmap an entry
+**
+** Notes:
+*/
+void store_unmap(int id)
+{
+	if (store_view[id] != NULL)
+	{
+		UnmapViewOfFile(store_view[id]);
+		store_view[id] = NULL;
+	}
+}
+
+/******************************************************************************
+** Function:	Map an entry's file, if present & valid
+**
+** Notes:		The view stays valid after its handles are closed
+*/
+void store_map(int id)
+{
+	char filename[MAX_PATH];
+	LARGE_INTEGER size;
+
+	store_unmap(id);
+	store_filename(filename, id, "");
+
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+
+	uint64 expected_bytes = sizeof(STORE_header_type) + (store_entries[id].length_words * sizeof(uint64));
+	if (!GetFileSizeEx(file, &size) || ((uint64)size.QuadPart != expected_bytes))
+	{
+		CloseHandle(file);
+		return;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (mapping == NULL)
+		return;
+
+	const STORE_header_type* header = (const STORE_header_type*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (header == NULL)
+		return;
+
+	if ((memcmp(header->magic, STORE_MAGIC, sizeof(header->magic)) != 0) ||
+		(header->version != STORE_VERSION) ||
+		(header->header_bytes != sizeof(STORE_header_type)) ||
+		(header->alu_length_u64 != ALU_LENGTH_U64) ||
+		(header->length_words != (uint32)store_entries[id].length_words))
+	{
+		UnmapViewOfFile(header);
+		return;
+	}
+
+	store_view[id] = header;
+}
+
+/******************************************************************************
+** Function:	Map all entries present
+**
+** Notes:		Call at startup
+*/
+void STORE_init(void)
+{
+	int n = 0;
+
+	for (int id = 0; id < STORE_N_ENTRIES; id++)
+	{
+		store_map(id);
+		if (store_view[id] != NULL)
+		{
+			printf("%s %s", (n == 0) ? "\n*** Stored values:" : ",", store_entries[id].name);
+			n++;
+		}
+	}
+
+	if (n != 0)
+		printf("\n");
+}
+
+/******************************************************************************
+** Function:	Stored words of an entry, or NULL if none
+**
+** Notes:		Points into the mapped file; read only. Sets *p_param if not NULL.
+*/
+const uint64* STORE_get(int id, uint64* p_param)
+{
+	const STORE_header_type* header = store_view[id];
+	if (header == NULL)
+		return NULL;
+
+	if (p_param != NULL)
+		*p_param = header->param;
+
+	return (const uint64*)((const uint8*)header + header->header_bytes);
+}
+
+/******************************************************************************
+** Function:	Write an entry & map the new file
+**
+** Notes:		Returns false if the file can't be written or replaced,
+**				e.g. while another process has it mapped
+*/
+bool STORE_put(int id, const uint64* v, uint64 param)
+{
+	char filename[MAX_PATH];
+	char temp_filename[MAX_PATH];
+	STORE_header_type header;
+
+	store_filename(filename, id, "");
+	store_filename(temp_filename, id, ".tmp");
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, STORE_MAGIC, sizeof(header.magic));
+	header.version = STORE_VERSION;
+	header.header_bytes = sizeof(STORE_header_type);
+	header.alu_length_u64 = ALU_LENGTH_U64;
+	header.length_words = store_entries[id].length_words;
+	header.param = param;
+	strncpy(header.name, store_entries[id].name, sizeof(header.name) - 1);
+
+	FILE* f = fopen(temp_filename, "wb");
+	if (f == NULL)
+	{
+		printf("\n*** Unable to create %s\n", temp_filename);
+		return false;
+	}
+
+	bool ok = (fwrite(&header, sizeof(header), 1, f) == 1) &&
+		(fwrite(v, sizeof(uint64), header.length_words, f) == header.length_words);
+	ok = (fclose(f) == 0) && ok;
+
+	store_unmap(id);							// our own view would block the replace
+	if (!ok || !MoveFileExA(temp_filename, filename, MOVEFILE_REPLACE_EXISTING))
+	{
+		printf("\n*** Unable to store %s\n", filename);
+		DeleteFileA(temp_filename);
+		store_map(id);
+		return false;
+	}
+
+	store_map(id);
+	return true;
+}
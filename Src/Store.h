@@ -0,0 +1,40 @@
+/******************************************************************************
+** File:	Store.h
+**
+** Notes:	Persistent store of computed registers, one file per entry.
+**			Each file is a fixed header followed by the register's uint64
+**			words exactly as held in memory, so it is memory-mapped and used
+**			in place with no parsing. Entries written by a build with a
+**			different STORE_VERSION or ALU_LENGTH_U64 are ignored.
+*/
+
+#define STORE_MAGIC				"ANTPLOT"		// 8 bytes incl. terminator
+#define STORE_VERSION			2				// bump when the word layout changes
+#define STORE_FILENAME_PREFIX	"antplot_"
+#define STORE_FILENAME_SUFFIX	".reg"
+
+// Entries:
+#define STORE_E					0				// e - 2, fraction (ALU_reg)
+#define STORE_E_DECIMAL			1				// e - 2 in BCD (ALU_reg_pair)
+#define STORE_PI				2				// pi - 3, fraction (ALU_reg)
+#define STORE_PI_DECIMAL		3				// pi - 3 in BCD (ALU_reg_pair)
+#define STORE_FACTORIAL			4				// checkpoint: param! (ALU_reg_pair)
+#define STORE_A					5				// A, where L = A / B (ALU_reg)
+#define STORE_B					6				// B (ALU_reg)
+#define STORE_L					7				// L = A / B (ALU_reg_pair)
+#define STORE_N_ENTRIES			8
+
+typedef struct
+{
+	char magic[8];
+	uint32 version;
+	uint32 header_bytes;						// words start here
+	uint32 alu_length_u64;						// ALU_LENGTH_U64 of the writer
+	uint32 length_words;
+	uint64 param;								// e.g. n, for n!
+	char name[32];
+} STORE_header_type;							// 64 bytes, so the words are cache-line aligned
+
+void STORE_init(void);
+const uint64* STORE_get(int id, uint64* p_param);
+bool STORE_put(int id, const uint64* v, uint64 param);
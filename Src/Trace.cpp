@@ -0,0 +1,229 @@
+/******************************************************************************
+** File:	Trace.cpp
+**
+** Notes:	Lightweight instrumentation: scoped spans and counters, exported
+**			as Chrome trace-event JSON
+*/
+
+#include "stdafx.h"
+
+#include "Trace.h"
+
+typedef struct
+{
+	const char* name;
+	uint64 ts_ns;							// relative to trace_t0
+	uint64 dur_ns;
+	int tid;
+	uint64 counter[TRACE_N_COUNTERS];		// totals at end of span
+} trace_event_type;
+
+const char* const trace_counter_names[TRACE_N_COUNTERS] = { "limbs", "divisions", "carries", "pixels" };
+
+std::atomic<bool> TRACE_on;
+thread_local uint64 TRACE_local[TRACE_N_COUNTERS];
+thread_local int trace_tid;					// small thread number for the viewer, 0 = unassigned
+
+std::atomic<uint64> trace_total[TRACE_N_COUNTERS];
+std::atomic<int> trace_n_threads;
+std::chrono::steady_clock::time_point trace_t0;
+
+std::mutex trace_mutex;						// guards trace_events
+std::vector<trace_event_type> trace_events;
+
+/******************************************************************************
+** Function:	Nanoseconds since tracing started
+**
+** Notes:
+*/
+uint64 trace_now_ns(void)
+{
+	return (uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - trace_t0).count();
+}
+
+/******************************************************************************
+** Function:	Add this thread's counts into the totals
+**
+** Notes:
+*/
+void trace_flush_counters(void)
+{
+	for (int i = 0; i < TRACE_N_COUNTERS; i++)
+	{
+		if (TRACE_local[i] != 0UI64)
+		{
+			trace_total[i].fetch_add(TRACE_local[i], std::memory_order_relaxed);
+			TRACE_local[i] = 0UI64;
+		}
+	}
+}
+
+/******************************************************************************
+** Function:	Start span
+**
+** Notes:		Costs one clock read when tracing is on, nothing else
+*/
+TRACE_span_type::TRACE_span_type(const char* span_name)
+{
+	name = NULL;
+	if (TRACE_on.load(std::memory_order_relaxed))
+	{
+		name = span_name;
+		t0_ns = trace_now_ns();
+	}
+}
+
+/******************************************************************************
+** Function:	End span, recording it as a complete ("X") event
+**
+** Notes:
+*/
+TRACE_span_type::~TRACE_span_type()
+{
+	if ((name == NULL) || !TRACE_on.load(std::memory_order_relaxed))
+		return;
+
+	trace_event_type e;
+	e.name = name;
+	e.ts_ns = t0_ns;
+	e.dur_ns = trace_now_ns() - t0_ns;
+
+	if (trace_tid == 0)
+		trace_tid = ++trace_n_threads;
+	e.tid = trace_tid;
+
+	trace_flush_counters();
+	for (int i = 0; i < TRACE_N_COUNTERS; i++)
+		e.counter[i] = trace_total[i].load(std::memory_order_relaxed);
+
+	std::lock_guard<std::mutex> lock(trace_mutex);
+	if (trace_events.size() < TRACE_MAX_EVENTS)
+		trace_events.push_back(e);
+}
+
+/******************************************************************************
+** Function:	Write a string into the trace as a JSON string, with quotes
+**
+** Notes:		Command descriptions can hold " & \, & control characters
+**				aren't allowed raw
+*/
+void trace_put_string(FILE* f, const char* s)
+{
+	fputc('"', f);
+	for (; *s != '\0'; s++)
+	{
+		if ((*s == '"') || (*s == '\\'))
+			fprintf(f, "\\%c", *s);
+		else if ((unsigned char)*s < 0x20)
+			fprintf(f, "\\u%04x", (unsigned char)*s);
+		else
+			fputc(*s, f);
+	}
+	fputc('"', f);
+}
+
+/******************************************************************************
+** Function:	Write trace in Chrome trace-event format
+**
+** Notes:		Each span is followed by a counter ("C") event at its end time,
+**				so the viewer shows counter totals over time
+*/
+void trace_export(void)
+{
+	FILE* f = fopen(TRACE_OUTPUT_FILENAME, "w");
+	if (f == NULL)
+	{
+		printf("*** Unable to create " TRACE_OUTPUT_FILENAME "\n");
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(trace_mutex);
+
+	fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Antplot\"}}");
+
+	for (size_t i = 0; i < trace_events.size(); i++)
+	{
+		const trace_event_type* e = &trace_events[i];
+
+		fprintf(f, ",\n{\"name\":");
+		trace_put_string(f, e->name);
+		fprintf(f, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+			e->tid, e->ts_ns / 1000.0, e->dur_ns / 1000.0);
+
+		fprintf(f, ",\n{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{", (e->ts_ns + e->dur_ns) / 1000.0);
+		for (int c = 0; c < TRACE_N_COUNTERS; c++)
+			fprintf(f, "%s\"%s\":%llu", (c == 0) ? "" : ",", trace_counter_names[c], e->counter[c]);
+		fprintf(f, "}}");
+	}
+
+	fprintf(f, "\n]}\n");
+	fclose(f);
+
+	printf("*** %u trace events written to " TRACE_OUTPUT_FILENAME "\n", (unsigned)trace_events.size());
+}
+
+/******************************************************************************
+** Function:	Tracing on/off command
+**
+** Notes:		Turning tracing off exports the trace
+*/
+void TRACE_toggle(void)
+{
+#if TRACE_ENABLED
+	if (TRACE_on)
+	{
+		TRACE_on = false;
+		printf("\n*** Tracing OFF\n");
+		trace_export();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(trace_mutex);
+		trace_events.clear();
+	}
+	for (int i = 0; i < TRACE_N_COUNTERS; i++)
+		trace_total[i] = 0UI64;
+	memset(TRACE_local, 0, sizeof(TRACE_local));
+	trace_t0 = std::chrono::steady_clock::now();
+
+	TRACE_on = true;
+	printf("\n*** Tracing ON. Commands are timed; toggle off to write " TRACE_OUTPUT_FILENAME "\n");
+#else
+	printf("\n*** Tracing not compiled in (TRACE_ENABLED is 0)\n");
+#endif
+}
+
+/******************************************************************************
+** Function:	Execute a command inside a span
+**
+** Notes:		While tracing, reports elapsed time and counts for the command
+*/
+void TRACE_command(const char* name, ptr_to_function p_function)
+{
+	if (!TRACE_on)
+	{
+		p_function();
+		return;
+	}
+
+	uint64 before[TRACE_N_COUNTERS];
+	trace_flush_counters();
+	for (int i = 0; i < TRACE_N_COUNTERS; i++)
+		before[i] = trace_total[i].load();
+
+	uint64 t0 = trace_now_ns();
+	{
+		TRACE_SPAN(name);
+		p_function();
+	}
+
+	if (!TRACE_on)							// command turned tracing off
+		return;
+
+	printf("\n*** %s: %.3f s", name, (trace_now_ns() - t0) / 1e9);
+	for (int i = 0; i < TRACE_N_COUNTERS; i++)
+		printf(", %llu %s", trace_total[i].load() - before[i], trace_counter_names[i]);
+	printf("\n");
+}
@@ -0,0 +1,47 @@
+/******************************************************************************
+** File:	Trace.h
+**
+** Notes:	Lightweight instrumentation: scoped spans and counters, exported
+**			as Chrome trace-event JSON (load in chrome://tracing or Perfetto).
+**			Set TRACE_ENABLED to 0 to compile all instrumentation out.
+*/
+
+#define TRACE_ENABLED			1
+
+#define TRACE_OUTPUT_FILENAME	"antplot_trace.json"
+#define TRACE_MAX_EVENTS		1000000
+
+#define TRACE_COUNTER_LIMBS		0			// uint64 words processed
+#define TRACE_COUNTER_DIVISIONS	1			// 128/64-bit divide instructions
+#define TRACE_COUNTER_CARRIES	2			// carries propagated beyond the first word
+#define TRACE_COUNTER_PIXELS	3			// pixels written by the ant walk
+#define TRACE_N_COUNTERS		4
+
+extern std::atomic<bool> TRACE_on;
+
+// Counted per thread without locking, and added into the totals when a span ends:
+extern thread_local uint64 TRACE_local[TRACE_N_COUNTERS];
+
+class TRACE_span_type
+{
+private:
+	const char* name;						// NULL when tracing was off at start
+	uint64 t0_ns;
+
+public:
+	TRACE_span_type(const char* span_name);
+	~TRACE_span_type();
+};
+
+#if TRACE_ENABLED
+#define TRACE_CONCAT2(A, B)		A##B
+#define TRACE_CONCAT(A, B)		TRACE_CONCAT2(A, B)
+#define TRACE_SPAN(NAME)		TRACE_span_type TRACE_CONCAT(trace_span_, __LINE__)(NAME)
+#define TRACE_COUNT(ID, N)		do { if (TRACE_on.load(std::memory_order_relaxed)) TRACE_local[ID] += (N); } while (0)
+#else
+#define TRACE_SPAN(NAME)
+#define TRACE_COUNT(ID, N)
+#endif
+
+void TRACE_toggle(void);
+void TRACE_command(const char* name, ptr_to_function p_function);
@@ -0,0 +1,230 @@
+/******************************************************************************
+** File:	Turmite.cpp
+**
+** Notes:	Multi-colour ant simulator. The step loop is a template on the
+**			number of colours & the turns, so for the common rules below
+**			the colour cycle & turn lookup compile to constants; any other
+**			rule runs the general loop, which looks them up in tables.
+*/
+
+#include "stdafx.h"
+
+#include "Turmite.h"
+
+#define TURMITE_BOARD_MASK		(TURMITE_BOARD_SIZE - 1)
+#define TURMITE_MAX_STEPS		64			// per call to a kernel: one trail word
+
+// Moves for dir 0..3, turning clockwise; (0, 1) to (1, 0) is a right turn, as in CALC_generate_ant:
+const int turmite_dx[4] = { 0, 1, 0, -1 };
+const int turmite_dy[4] = { 1, 0, -1, 0 };
+
+/******************************************************************************
+** Function:	Turn letter to TURMITE_TURN_x, or -1
+**
+** Notes:
+*/
+constexpr int turmite_turn(char c)
+{
+	return ((c | 0x20) == 'n') ? TURMITE_TURN_N :
+		((c | 0x20) == 'r') ? TURMITE_TURN_R :
+		((c | 0x20) == 'u') ? TURMITE_TURN_U :
+		((c | 0x20) == 'l') ? TURMITE_TURN_L : -1;
+}
+
+/******************************************************************************
+** Function:	Rule string packed 2 bits per colour, colour 0 in the LS bits
+**
+** Notes:		Compile time, for the template arguments below
+*/
+constexpr uint32 turmite_pack(const char* rule, int i = 0)
+{
+	return (rule[i] == '\0') ? 0 : ((uint32)turmite_turn(rule[i]) << (2 * i)) | turmite_pack(rule, i + 1);
+}
+
+constexpr int turmite_length(const char* rule)
+{
+	return (*rule == '\0') ? 0 : 1 + turmite_length(rule + 1);
+}
+
+/******************************************************************************
+** Function:	Run n_steps (up to 64) & return their trail bits
+**
+** Notes:		First step in the MS of the n_steps bits returned.
+**				N_COLOURS == 0 is the general loop, which reads the rule from t.
+**				Position & direction live in locals, so in machine registers.
+*/
+template<int N_COLOURS, uint32 TURNS> uint64 turmite_kernel(TURMITE_type* t, int n_steps)
+{
+	uint8* board = t->board;
+	int x = t->pos_x;
+	int y = t->pos_y;
+	int dir = t->dir;
+	int n_colours = (N_COLOURS != 0) ? N_COLOURS : t->n_colours;
+	uint64 trail = 0UI64;
+
+	for (int step = 0; step < n_steps; step++)
+	{
+		uint8* p_cell = &board[(y << TURMITE_BOARD_BITS) | x];
+		int colour = *p_cell;
+		int turn = (N_COLOURS != 0) ? (int)((TURNS >> (2 * colour)) & 3) : t->turns[colour];
+
+		trail = (trail << 1) | (uint64)(turn == TURMITE_TURN_R);
+		*p_cell = (uint8)((colour + 1 == n_colours) ? 0 : colour + 1);
+
+		dir = (dir + turn) & 3;
+		x = (x + turmite_dx[dir]) & TURMITE_BOARD_MASK;
+		y = (y + turmite_dy[dir]) & TURMITE_BOARD_MASK;
+	}
+
+	t->pos_x = x;
+	t->pos_y = y;
+	t->dir = dir;
+	return trail;
+}
+
+typedef struct
+{
+	const char* rule;
+	TURMITE_kernel_type p_kernel;
+} turmite_compiled_type;
+
+#define TURMITE_COMPILED(rule)	{ rule, turmite_kernel<turmite_length(rule), turmite_pack(rule)> }
+
+const turmite_compiled_type turmite_compiled[] =
+{
+	TURMITE_COMPILED("RL"),					// Langton's Ant
+	TURMITE_COMPILED("LR"),
+	TURMITE_COMPILED("RLR"),				// chaotic
+	TURMITE_COMPILED("LLRR"),				// symmetric
+	TURMITE_COMPILED("LRRL"),
+	TURMITE_COMPILED("RRLL"),
+	TURMITE_COMPILED("RLLR"),
+	TURMITE_COMPILED("LRRRRRLLR"),			// fills a square
+	TURMITE_COMPILED("LLRRRLRLRLLR"),		// convoluted highway
+	TURMITE_COMPILED("RRLLLRLLLRRR")		// growing triangle
+};
+
+/******************************************************************************
+** Function:	Allocate an empty board
+**
+** Notes:		Rule starts as Langton's Ant
+*/
+void TURMITE_init(TURMITE_type* t)
+{
+	t->board = new uint8[TURMITE_BOARD_SIZE * TURMITE_BOARD_SIZE];
+	memset(t->board, 0, TURMITE_BOARD_SIZE * TURMITE_BOARD_SIZE);
+	t->min_x = t->max_x = t->min_y = t->max_y = TURMITE_BOARD_SIZE / 2;
+	TURMITE_set_rule(t, "RL");
+	TURMITE_reset(t);
+}
+
+/******************************************************************************
+** Function:
+**
+** Notes:
+*/
+void TURMITE_free(TURMITE_type* t)
+{
+	delete[] t->board;
+	t->board = NULL;
+}
+
+/******************************************************************************
+** Function:	Set the rule, one letter per colour
+**
+** Notes:		Returns false, leaving the rule unchanged, if it isn't valid.
+**				Call TURMITE_reset before running the new rule.
+*/
+bool TURMITE_set_rule(TURMITE_type* t, const char* rule)
+{
+	int n = (int)strlen(rule);
+
+	if ((n < 1) || (n > TURMITE_MAX_COLOURS))
+		return false;
+
+	for (int i = 0; i < n; i++)
+	{
+		if (turmite_turn(rule[i]) < 0)
+			return false;
+	}
+
+	for (int i = 0; i < n; i++)
+	{
+		t->turns[i] = (uint8)turmite_turn(rule[i]);
+		t->rule[i] = (char)(rule[i] & ~0x20);		// upper case
+	}
+	t->rule[n] = '\0';
+	t->n_colours = n;
+
+	t->p_kernel = turmite_kernel<0, 0>;
+	for (int i = 0; i < N_ELEMENTS(turmite_compiled); i++)
+	{
+		if (strcmp(turmite_compiled[i].rule, t->rule) == 0)
+			t->p_kernel = turmite_compiled[i].p_kernel;
+	}
+
+	return true;
+}
+
+/******************************************************************************
+** Function:	Clear the board & put the ant back in the middle, facing up
+**
+** Notes:		Only clears the rows & columns the ant can have reached: it is
+**				never more than TURMITE_MAX_STEPS from a position seen between
+**				kernel calls. If that margin reaches an edge, the ant may have
+**				crossed it & come back within a call, leaving cells by the
+**				opposite edge, so the whole board is cleared.
+*/
+void TURMITE_reset(TURMITE_type* t)
+{
+	int x0 = t->min_x - TURMITE_MAX_STEPS;
+	int x1 = t->max_x + TURMITE_MAX_STEPS;
+	int y0 = t->min_y - TURMITE_MAX_STEPS;
+	int y1 = t->max_y + TURMITE_MAX_STEPS;
+
+	if ((x0 < 0) || (x1 > TURMITE_BOARD_MASK) || (y0 < 0) || (y1 > TURMITE_BOARD_MASK))
+		memset(t->board, 0, TURMITE_BOARD_SIZE * TURMITE_BOARD_SIZE);
+	else
+	{
+		for (int y = y0; y <= y1; y++)
+			memset(&t->board[(y << TURMITE_BOARD_BITS) | x0], 0, x1 - x0 + 1);
+	}
+
+	t->pos_x = TURMITE_BOARD_SIZE / 2;
+	t->pos_y = TURMITE_BOARD_SIZE / 2;
+	t->dir = 0;
+	t->min_x = t->max_x = t->pos_x;
+	t->min_y = t->max_y = t->pos_y;
+	t->steps = 0UI64;
+}
+
+/******************************************************************************
+** Function:	Run n_steps (up to 64) & return their trail bits
+**
+** Notes:		First step in the MS of the n_steps bits returned
+*/
+uint64 TURMITE_steps(TURMITE_type* t, int n_steps)
+{
+	uint64 trail = t->p_kernel(t, n_steps);
+
+	t->steps += n_steps;
+	if (t->pos_x < t->min_x)
+		t->min_x = t->pos_x;
+	if (t->pos_x > t->max_x)
+		t->max_x = t->pos_x;
+	if (t->pos_y < t->min_y)
+		t->min_y = t->pos_y;
+	if (t->pos_y > t->max_y)
+		t->max_y = t->pos_y;
+	return trail;
+}
+
+/******************************************************************************
+** Function:	True if the rule has a compiled step loop
+**
+** Notes:
+*/
+bool TURMITE_compiled(const TURMITE_type* t)
+{
+	return t->p_kernel != turmite_kernel<0, 0>;
+}
@@ -0,0 +1,44 @@
+/******************************************************************************
+** File:	Turmite.h
+**
+** Notes:	Multi-colour ants (turmites with one state) on a wrapping board.
+**			A rule such as "RL" or "LLRR" gives the turn for each cell colour:
+**			the ant turns, steps the cell on to the next colour & moves on.
+**			"RL" is Langton's Ant. Letters are L, R, N (no turn) & U (U-turn).
+**			The trail is one bit per step, 1 where the ant turned right;
+**			for "RL" that is 1 where it turned a white cell black.
+*/
+
+#define TURMITE_MAX_COLOURS		16
+#define TURMITE_BOARD_BITS		12
+#define TURMITE_BOARD_SIZE		(1 << TURMITE_BOARD_BITS)		// cells across; the edges join up
+
+// Quarter turns clockwise:
+#define TURMITE_TURN_N			0
+#define TURMITE_TURN_R			1
+#define TURMITE_TURN_U			2
+#define TURMITE_TURN_L			3
+
+struct TURMITE_type;
+typedef uint64 (*TURMITE_kernel_type)(TURMITE_type* t, int n_steps);
+
+struct TURMITE_type
+{
+	char rule[TURMITE_MAX_COLOURS + 1];
+	int n_colours;
+	uint8 turns[TURMITE_MAX_COLOURS];		// TURMITE_TURN_x for each colour
+	TURMITE_kernel_type p_kernel;			// compiled for the rule, or general
+
+	uint8* board;							// colour of each cell, row by row
+	int pos_x, pos_y;
+	int dir;								// 0..3: up, right, down, left
+	int min_x, min_y, max_x, max_y;			// range of positions seen, for a quick reset
+	uint64 steps;
+};
+
+void TURMITE_init(TURMITE_type* t);
+void TURMITE_free(TURMITE_type* t);
+bool TURMITE_set_rule(TURMITE_type* t, const char* rule);
+void TURMITE_reset(TURMITE_type* t);
+uint64 TURMITE_steps(TURMITE_type* t, int n_steps);
+bool TURMITE_compiled(const TURMITE_type* t);